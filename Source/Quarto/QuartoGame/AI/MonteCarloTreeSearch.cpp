@@ -1,508 +1,298 @@
 #include "Quarto/QuartoGame/AI/MonteCarloTreeSearch.h"
 
-#include "HAL/PlatformProcess.h"
-#include "HAL/RunnableThread.h"
-#include "HAL/Event.h"
+#include "QuartoCore/MCTS/SearchScheduler.h"
 
-using namespace ai::mcts;
-
-MonteCarloTreeSearch::MonteCarloTreeSearch(brFloat maxMoveSearchTimeInSeconds, brFloat maxOpponentTokenSearchTimeInSeconds)
-{
-	m_threadWorker = new internal::MCTSThread(maxMoveSearchTimeInSeconds, maxOpponentTokenSearchTimeInSeconds);
-}
-
-MonteCarloTreeSearch::~MonteCarloTreeSearch()
-{
-	delete m_threadWorker;
-}
-
-void MonteCarloTreeSearch::FindNextOpponentToken(QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId) const
-{
-	m_threadWorker->RequestNextOpponentToken(currentBoard, playerId, opponentId);
-}
+#include "Async/Async.h"
 
-void MonteCarloTreeSearch::FindNextMove(QuartoTokenData const& token, QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId) const
-{
-	m_threadWorker->RequestNextMove(token, currentBoard, playerId, opponentId);
-}
-
-brBool MonteCarloTreeSearch::IsLookingForNextMove() const
-{
-	return m_threadWorker->IsProcessingAnyRequest();
-}
+using namespace ai::mcts;
 
-brBool MonteCarloTreeSearch::IsLookingForNextOpponentToken() const
-{
-	return m_threadWorker->IsProcessingAnyRequest();
-}
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("MCTS_Iterations"), STAT_Quarto_MCTS_Iterations, STATGROUP_Quarto);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("MCTS_PlayoutsPerSecond"), STAT_Quarto_MCTS_PlayoutsPerSecond, STATGROUP_Quarto);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("MCTS_TreeNodes"), STAT_Quarto_MCTS_TreeNodes, STATGROUP_Quarto);
+DECLARE_MEMORY_STAT(TEXT("MCTS_PeakTreeMemory"), STAT_Quarto_MCTS_PeakTreeMemory, STATGROUP_Quarto);
 
-brBool MonteCarloTreeSearch::HasFoundNextMove() const
+namespace
 {
-	return m_threadWorker->IsMoveRequestFinished();
-}
-
-brBool MonteCarloTreeSearch::HasFoundNextOpponentToken() const
-{
-	return m_threadWorker->IsOpponentTokenRequestFinished();
+	// Wires the job up with a promise of the game result and the completion delegate
+	template <typename T>
+	SearchHandle<T> MakeSearchHandle(SearchJobPtr const& job, TFunction<T(SearchJob const&, SearchResult const&)> convertResult, OnSearchFinished<T> onFound)
+	{
+		TPromise<T> promise;
+		TFuture<T> future = promise.GetFuture();
+		job->Complete = [promise = MoveTemp(promise), convertResult = MoveTemp(convertResult), onFound = MoveTemp(onFound)](SearchJobPtr const& finishedJob, SearchResult const& result) mutable
+		{
+			T const value = convertResult(*finishedJob, result);
+			if (onFound && !finishedJob->IsCancelled)
+			{
+				//the job could still be cancelled until the game thread gets to it
+				AsyncTask(ENamedThreads::GameThread, [onFound, value, finishedJob]()
+				{
+					if (!finishedJob->IsCancelled)
+					{
+						onFound(value);
+					}
+				});
+			}
+			promise.SetValue(value);
+		};
+		return SearchHandle<T>(MoveTemp(future), job);
+	}
 }
 
-QuartoBoardSlotCoordinates MonteCarloTreeSearch::GetNextMoveCoordinates() const
+MonteCarloTreeSearch::MonteCarloTreeSearch(SearchSettings const& settings, brU32 priority)
+	: m_queue(MakeShared<internal::SearchQueue, ESPMode::ThreadSafe>(settings, priority))
 {
-	return m_threadWorker->ConsumeRequestResultNextMove();
 }
 
-QuartoTokenData MonteCarloTreeSearch::GetNextOpponentToken() const
+MonteCarloTreeSearch::~MonteCarloTreeSearch()
 {
-	return m_threadWorker->ConsumeRequestResultOpponentToken();
+	//a running search keeps the queue alive until its callback is done, nobody has to wait for it here
+	m_queue->Shutdown();
 }
 
-
-TArray<internal::State> internal::State::GetAllPossibleStates(QuartoTokenData const* token) const
+SearchHandle<QuartoTokenData> MonteCarloTreeSearch::FindNextOpponentToken(QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId,
+	OnSearchFinished<QuartoTokenData> onFound, brFloat deadlineSeconds) const
 {
-	TArray<State> states;
-	auto addState = [&](QuartoBoardSlotCoordinates const& c, QuartoTokenData const& t)
-	{
-		State newState;
-		newState.BoardData = BoardData;
-		newState.BoardData.SetTokenOnBoard(c, t);
-		states.Add(newState);
-	};
-	
-	for(auto const& slotCoordinates : BoardData.GetEmptySlotCoordinates())
-	{
-		if(!token)
+	SearchJobPtr const job = CreateJob(m_queue->GetSettings().OpponentTokenSearchBudget, currentBoard, quarto::InvalidToken, playerId, opponentId, deadlineSeconds);
+	SearchHandle<QuartoTokenData> handle = MakeSearchHandle<QuartoTokenData>(job,
+		[currentBoard](SearchJob const& finishedJob, SearchResult const& result)
 		{
-			for (auto const& freeToken : BoardData.GetFreeTokens())
+			if (result.IsValid())
 			{
-				addState(slotCoordinates, freeToken);
+				return QuartoTokenData::FromTokenId(result.GetToken());
 			}
-		}
-		else
-		{
-			addState(slotCoordinates, *token);
-		}
-	}
-	return states;
+			if (!finishedJob.IsCancelled)
+			{
+				UE_LOG(LogTemp, Error, TEXT("ERROR: No token was found with the Monte Carlo Tree Search! Random free token will be used."));
+			}
+			auto const& freeTokens = currentBoard.GetFreeTokens();
+			return freeTokens[FMath::RandRange(0, freeTokens.Num() - 1)];
+		},
+		MoveTemp(onFound));
+	m_queue->Enqueue(job);
+	return handle;
 }
 
-void internal::State::RandomPlay()
+SearchHandle<QuartoBoardSlotCoordinates> MonteCarloTreeSearch::FindNextMove(QuartoTokenData const& token, QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId,
+	OnSearchFinished<QuartoBoardSlotCoordinates> onFound, brFloat deadlineSeconds) const
 {
-	auto const emptySlotCoordinates = BoardData.GetEmptySlotCoordinates();
-	auto const freeTokens = BoardData.GetFreeTokens();
-
-	if(emptySlotCoordinates.Num() == 0 || freeTokens.Num() == 0)
-	{
-		UE_LOG(LogTemp, Warning, TEXT("MCTS: Can't play a random play!"));
-		return;
-	}
-
-	brU32 const randomSlotIdx = FMath::RandRange(0, emptySlotCoordinates.Num()-1);
-	brU32 const randomTokenIdx = FMath::RandRange(0, freeTokens.Num()-1);
-	BoardData.SetTokenOnBoard(emptySlotCoordinates[randomSlotIdx], freeTokens[randomTokenIdx]);
+	SearchJobPtr const job = CreateJob(m_queue->GetSettings().MoveSearchBudget, currentBoard, token.GetTokenId(), playerId, opponentId, deadlineSeconds);
+	SearchHandle<QuartoBoardSlotCoordinates> handle = MakeSearchHandle<QuartoBoardSlotCoordinates>(job,
+		[currentBoard](SearchJob const& finishedJob, SearchResult const& result)
+		{
+			if (result.IsValid())
+			{
+				return QuartoBoardData::ConvertIndexToSlotCoordinates(result.GetSlot());
+			}
+			if (!finishedJob.IsCancelled)
+			{
+				UE_LOG(LogTemp, Error, TEXT("ERROR: No slotcoordinates were found with the Monte Carlo Tree Search! Random free slot coordinate will be used."));
+			}
+			auto const& freeCoords = currentBoard.GetEmptySlotCoordinates();
+			return freeCoords[FMath::RandRange(0, freeCoords.Num() - 1)];
+		},
+		MoveTemp(onFound));
+	m_queue->Enqueue(job);
+	return handle;
 }
 
-void internal::State::ReplacePlayerIdWithUnused(::PlayerId id1, ::PlayerId id2)
+brU32 MonteCarloTreeSearch::GetNumPendingRequests() const
 {
-	if(PlayerId == id1)
-	{
-		PlayerId = id2;
-	}
-	else if(PlayerId == id2)
-	{
-		PlayerId = id1;
-	}
+	return m_queue->GetNumPendingJobs();
 }
 
-internal::Node& internal::Node::GetChildWithHighestScore()
+void MonteCarloTreeSearch::CancelAllRequests() const
 {
-	if(Children.Num() == 0)
-	{
-		return *this;
-	}
-	
-	Node* bestChild = nullptr;
-	for(Node& child : Children)
-	{
-		if(!bestChild ||
-			(bestChild && child.State.VisitCount > bestChild->State.VisitCount))
-		{
-			bestChild = &child;
-		}
-	}
-	return *bestChild;
+	m_queue->CancelAllJobs();
 }
 
-internal::Node& internal::Node::GetRandomChild()
+brDouble MonteCarloTreeSearch::GetAverageSecondsSavedPerDecision() const
 {
-	return Children[FMath::RandRange(0, Children.Num() - 1)];
+	return m_queue->GetAverageSecondsSavedPerDecision();
 }
 
-internal::MCTSThread::MCTSThread(brFloat maxMoveSearchTimeInSeconds, brFloat maxOpponentTokenSearchTimeInSeconds)
-	: m_thread(FRunnableThread::Create(this, TEXT("MCTSThread"), 0, TPri_BelowNormal))
-	, m_semaphore(FGenericPlatformProcess::GetSynchEventFromPool(false))
-	, m_kill(false)
-	, m_pause(true)
-	, m_maxMoveSearchTimeInSeconds(maxMoveSearchTimeInSeconds)
-	, m_maxOpponentTokenSearchTimeInSeconds(maxOpponentTokenSearchTimeInSeconds)
+SearchStats MonteCarloTreeSearch::GetLastMoveSearchStats() const
 {
-	m_moveRequest.IsProcessed = true;
-	m_opponentTokenRequest.IsProcessed = true;
+	return m_queue->GetLastMoveSearchStats();
 }
 
-internal::MCTSThread::~MCTSThread()
+SearchStats MonteCarloTreeSearch::GetLastOpponentTokenSearchStats() const
 {
-	MCTSThread::Stop();
-	if(m_thread)
-	{
-		m_thread->WaitForCompletion();
-	}
-	
-	if(m_semaphore)
-	{
-		//Cleanup the FEvent
-		FGenericPlatformProcess::ReturnSynchEventToPool(m_semaphore);
-		m_semaphore = nullptr;
-	}
-
-	if (m_thread)
-	{
-		//Cleanup the worker thread
-		delete m_thread;
-		m_thread = nullptr;
-	}
+	return m_queue->GetLastOpponentTokenSearchStats();
 }
 
-uint32 internal::MCTSThread::Run()
+SearchSnapshot const& MonteCarloTreeSearch::GetLatestSearchSnapshot() const
 {
-	//Initial wait before starting
-	FPlatformProcess::Sleep(0.03);
-
-	while (!m_kill)
-	{
-		if (m_pause)
-		{
-			//FEvent->Wait(); will "sleep" the thread until it will get a signal "Trigger()"
-			m_semaphore->Wait();
-
-			if (m_kill)
-			{
-				return 0;
-			}
-		}
-		else
-		{
-			if(!m_opponentTokenRequest.IsProcessed)
-			{
-				SearchNextOpponentToken();
-			}
-			
-			if(!m_moveRequest.IsProcessed)
-			{
-				SearchNextMove();
-			}
-
-			PauseThread();
-		}
-	}
-
-	return 0;
+	return m_queue->GetLatestSearchSnapshot();
 }
 
-void internal::MCTSThread::Stop()
+SearchJobPtr MonteCarloTreeSearch::CreateJob(SearchBudgetSettings const& budgetSettings, QuartoBoardData const& boardData, quarto::TokenId token, PlayerId playerId, PlayerId opponentId, brFloat deadlineSeconds) const
 {
-	m_kill = true;
-	m_pause = false;
-	
-	if(m_semaphore)
+	SearchJobPtr const job = MakeShared<SearchJob, ESPMode::ThreadSafe>();
+	job->Request.Board = boardData.GetCoreBoard();
+	job->Request.Token = token;
+	job->Request.Player = playerId;
+	job->Request.Opponent = opponentId;
+	job->Request.Budget = budgetSettings;
+	if (deadlineSeconds > 0.f)
 	{
-		//We shall signal "Trigger" the FEvent (in case the Thread is sleeping it shall wake up!!)
-		m_semaphore->Trigger();
+		job->Control->SetDeadlineFromNow(deadlineSeconds);
 	}
+	return job;
 }
 
-brBool internal::MCTSThread::IsProcessingAnyRequest() const
-{
-	return static_cast<brBool>(!m_pause);
-}
-
-void internal::MCTSThread::RequestNextMove(QuartoTokenData const& token, QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId)
+internal::SearchQueue::SearchQueue(SearchSettings const& settings, brU32 priority)
+	: m_kill(false)
+	, m_numPendingJobs(0)
+	, m_generation(0)
+	, m_settings(settings)
+	, m_priority(priority)
 {
-	if(IsProcessingAnyRequest())
-	{
-		return;
-	}
-	
-	m_moveRequest.BoardData = currentBoard;
-	m_moveRequest.TokenData = token;
-	m_moveRequest.PlayerId = playerId;
-	m_moveRequest.OpponentId = opponentId;
-	m_moveRequest.IsMoveFound = false;
-	m_moveRequest.IsProcessed = false;
-	ContinueThread();
 }
 
-void internal::MCTSThread::RequestNextOpponentToken(QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId)
+void internal::SearchQueue::Enqueue(SearchJobPtr const& job)
 {
-	if (IsProcessingAnyRequest())
-	{
-		return;
-	}
-
-	m_opponentTokenRequest.BoardData = currentBoard;
-	m_opponentTokenRequest.PlayerId = playerId;
-	m_opponentTokenRequest.OpponentId = opponentId;
-	m_opponentTokenRequest.IsTokenFound = false;
-	m_opponentTokenRequest.IsProcessed = false;
-	ContinueThread();
+	job->Generation = m_generation;
+	++m_numPendingJobs;
+	m_jobs.Enqueue(job);
+	SubmitNextJob();
 }
 
-void internal::MCTSThread::SearchNextMove()
+void internal::SearchQueue::CancelAllJobs()
 {
-	m_moveRequest.IsMoveFound = false;
-
-	auto const winnerBoard = 
-		SearchNextDraw(
-			m_maxMoveSearchTimeInSeconds, 
-			&m_moveRequest.BoardData, 
-			&m_moveRequest.TokenData, 
-			m_moveRequest.PlayerId, 
-			m_moveRequest.OpponentId, 
-			false);
-	
-	auto oldEmptySlotCoordinates = m_moveRequest.BoardData.GetEmptySlotCoordinates();
-	for (auto& slotCoordinates : winnerBoard.GetEmptySlotCoordinates())
-	{
-		oldEmptySlotCoordinates.Remove(slotCoordinates);
-	}
-
+	//queued jobs are cancelled once they are dequeued, the running one right away
+	++m_generation;
 	m_mutex.Lock();
 	{
-		if (oldEmptySlotCoordinates.Num() == 1)
-		{
-			m_moveRequest.ResultMove = oldEmptySlotCoordinates[0];
-		}
-		else
+		if (m_runningJob)
 		{
-			UE_LOG(LogTemp, Error, TEXT("ERROR: No slotcoordinates were found with the Monte Carlo Tree Search! Random free slot coordinate will be used."));
-			auto const& freeCoords = m_opponentTokenRequest.BoardData.GetEmptySlotCoordinates();
-			m_moveRequest.ResultMove = freeCoords[FMath::RandRange(0, freeCoords.Num() - 1)];
+			m_runningJob->Cancel();
 		}
 	}
 	m_mutex.Unlock();
-	
-	m_moveRequest.IsMoveFound = true;
-	m_moveRequest.IsProcessed = true;
 }
 
-void internal::MCTSThread::SearchNextOpponentToken()
+void internal::SearchQueue::Shutdown()
 {
-	m_opponentTokenRequest.IsTokenFound = false;
-
-	auto const winnerBoard = 
-		SearchNextDraw(
-			m_maxOpponentTokenSearchTimeInSeconds, 
-			&m_opponentTokenRequest.BoardData, 
-			nullptr,
-			m_opponentTokenRequest.PlayerId,
-			m_opponentTokenRequest.OpponentId,
-			true);
-	
-	auto oldFreeTokens = m_opponentTokenRequest.BoardData.GetFreeTokens();
-	for (auto& token : winnerBoard.GetFreeTokens())
-	{
-		oldFreeTokens.Remove(token);
-	}
+	m_kill = true;
+	CancelAllJobs();
+
+	//nobody waits for a future in vain: the remaining jobs are cancelled, which still fulfills them
+	SubmitNextJob();
+}
 
+brDouble internal::SearchQueue::GetAverageSecondsSavedPerDecision()
+{
+	brDouble result = 0.0;
 	m_mutex.Lock();
 	{
-		if (oldFreeTokens.Num() == 1)
-		{
-			m_opponentTokenRequest.ResultToken = oldFreeTokens[0];
-		}
-		else
+		if (m_numDecisions > 0)
 		{
-			UE_LOG(LogTemp, Error, TEXT("ERROR: No token was found with the Monte Carlo Tree Search! Random free token will be used."));
-			auto const& freeTokens = m_opponentTokenRequest.BoardData.GetFreeTokens();
-			m_opponentTokenRequest.ResultToken = freeTokens[FMath::RandRange(0, freeTokens.Num() - 1)];
+			result = m_totalSavedSeconds / m_numDecisions;
 		}
 	}
 	m_mutex.Unlock();
-
-	m_opponentTokenRequest.IsTokenFound = true;
-	m_opponentTokenRequest.IsProcessed = true;
+	return result;
 }
 
-QuartoTokenData internal::MCTSThread::ConsumeRequestResultOpponentToken()
+SearchStats internal::SearchQueue::GetLastMoveSearchStats()
 {
-	QuartoTokenData result;
+	SearchStats result;
 	m_mutex.Lock();
 	{
-		result = m_opponentTokenRequest.ResultToken;
+		result = m_lastMoveStats;
 	}
 	m_mutex.Unlock();
-	m_opponentTokenRequest.IsTokenFound = false;
 	return result;
 }
 
-QuartoBoardSlotCoordinates internal::MCTSThread::ConsumeRequestResultNextMove()
+SearchStats internal::SearchQueue::GetLastOpponentTokenSearchStats()
 {
-	QuartoBoardSlotCoordinates result;
+	SearchStats result;
 	m_mutex.Lock();
 	{
-		result = m_moveRequest.ResultMove;
+		result = m_lastOpponentTokenStats;
 	}
 	m_mutex.Unlock();
-	m_moveRequest.IsMoveFound = false;
 	return result;
 }
 
-void internal::MCTSThread::PauseThread()
+SearchSnapshot const& internal::SearchQueue::GetLatestSearchSnapshot()
 {
-	m_pause = true;
+	m_snapshots.Update();
+	return m_snapshots.GetReadBuffer();
 }
 
-void internal::MCTSThread::ContinueThread()
+void internal::SearchQueue::SubmitNextJob()
 {
-	m_pause = false;
-
-	if (m_semaphore)
+	while (true)
 	{
-		//Here is a FEvent signal "Trigger()" -> it will wake up the thread.
-		m_semaphore->Trigger();
-	}
-}
-
-QuartoBoardData internal::MCTSThread::SearchNextDraw(brFloat maxSearchTime, QuartoBoardData const* boardData, QuartoTokenData const* tokenData, PlayerId playerId, PlayerId opponentId, brBool negate) const
-{
-	Node root;
-	root.State.BoardData = *boardData;
-	root.State.PlayerId = opponentId;
-
-	FDateTime const startTime = FDateTime::Now();
-	while (!m_kill && (FDateTime::Now() - startTime).GetTotalSeconds() < maxSearchTime)
-	{
-		Node* promisingNode = Select(&root);
-		if (promisingNode && promisingNode->State.BoardData.GetStatus() == QuartoBoardData::GameStatus::InProgress)
+		SearchJobPtr job;
+		m_mutex.Lock();
 		{
-			Expand(promisingNode, playerId, opponentId, tokenData);
+			if (!m_runningJob && m_jobs.Dequeue(job))
+			{
+				m_runningJob = job;
+				if (m_kill || job->Generation != m_generation)
+				{
+					job->Cancel();
+				}
+			}
 		}
-		Node* nodeToExplore = promisingNode;
-		if (promisingNode && promisingNode->Children.Num() > 0)
+		m_mutex.Unlock();
+
+		if (!job)
 		{
-			nodeToExplore = &promisingNode->GetRandomChild();
+			//the queue is empty or the running job submits the next one when it is done
+			return;
 		}
-		PlayerId const winnerId = Simulate(nodeToExplore, playerId, opponentId, negate);
-		BackPropagate(nodeToExplore, winnerId, negate);
-	}
-	
-	return root.GetChildWithHighestScore().State.BoardData;
-}
-
-internal::Node* internal::MCTSThread::Select(Node* node)
-{
-	Node* result = node;
-	while (result && result->Children.Num() > 0)
-	{
-		result = FindBestNodeWithUct(result);
-	}
-	return result;
-}
-
-void internal::MCTSThread::Expand(Node* node, PlayerId playerId, PlayerId opponentId, QuartoTokenData const* token)
-{
-	if(!node)
-	{
-		return;
-	}
-
-	TArray<State> possibleStates = node->State.GetAllPossibleStates(token);
-	for(State& state : possibleStates)
-	{
-		Node child;
-		child.State = state;
-		child.State.PlayerId = node->State.PlayerId;
-		child.State.ReplacePlayerIdWithUnused(playerId, opponentId);
-		child.Parent = node;
-		node->Children.Add(child);
-	}
-}
 
-PlayerId internal::MCTSThread::Simulate(Node* node, PlayerId playerId, PlayerId opponentId, brBool negate)
-{
-	if (!node)
-	{
-		return 0;
-	}
-	
-	auto status = node->State.BoardData.GetStatus();
-	if(status == QuartoBoardData::GameStatus::End 
-		&& playerId != node->State.PlayerId)
-	{
-		if(node->Parent)
+		if (job->IsCancelled)
 		{
-			node->Parent->State.WinScore = negate ? INT_MAX : INT_MIN;
+			CompleteJob(job, SearchResult(), false);
+			continue;
 		}
-		return node->State.PlayerId;
-	}
 
-	State tmpState = node->State;
-	while(status == QuartoBoardData::GameStatus::InProgress)
-	{
-		tmpState.ReplacePlayerIdWithUnused(playerId, opponentId);
-		tmpState.RandomPlay();
-		status = tmpState.BoardData.GetStatus();
+		//runs until the budget or the deadline is used up, the decision is fixed or the job is stopped
+		//only this job writes the snapshots until it is completed
+		TSharedRef<SearchQueue, ESPMode::ThreadSafe> const self = AsShared();
+		SearchScheduler::Get().Submit(m_settings, job->Request, job->Control, m_priority,
+			[self, job](SearchResult const& result)
+			{
+				self->CompleteJob(job, result, true);
+				self->SubmitNextJob();
+			},
+			&m_snapshots);
+		return;
 	}
-	
-	return tmpState.PlayerId;
 }
 
-void internal::MCTSThread::BackPropagate(Node* node, PlayerId playerId, brBool negate)
+void internal::SearchQueue::CompleteJob(SearchJobPtr const& job, SearchResult const& result, brBool isSearched)
 {
-	Node* tmpNode = node;
-	while(tmpNode)
-	{
-		State& state = tmpNode->State;
-		++(state.VisitCount);
-		if((!negate && state.PlayerId == playerId) 
-			|| (negate && state.PlayerId != playerId))
-		{
-			state.WinScore += 10;
-		}
-		tmpNode = tmpNode->Parent;
-	}
-}
+	QUARTO_SCOPE_CYCLE_COUNTER(MCTS_CompleteJob);
 
-internal::Node* internal::MCTSThread::FindBestNodeWithUct(Node* node)
-{
-	if(!node)
+	if (isSearched)
 	{
-		return nullptr;
+		//values of the last decision, so they stay visible in stat Quarto until the next one
+		SearchStats const& stats = result.Stats;
+		SET_DWORD_STAT(STAT_Quarto_MCTS_Iterations, stats.NumIterations);
+		SET_DWORD_STAT(STAT_Quarto_MCTS_PlayoutsPerSecond, stats.TotalSeconds > 0.0 ? static_cast<brU32>(stats.NumPlayouts / stats.TotalSeconds) : 0);
+		SET_DWORD_STAT(STAT_Quarto_MCTS_TreeNodes, stats.NumNodesAllocated - stats.NumNodesPruned);
+		SET_MEMORY_STAT(STAT_Quarto_MCTS_PeakTreeMemory, stats.PeakTreeBytes);
 	}
-	
-	static auto uctValueFct = [](brU32 totalVisit, brFloat nodeWinScore, brU32 nodeVisit) -> brFloat
-	{
-		static brFloat explorationParam = 1.41f; // sqrt(2)
-
-		if (nodeVisit == 0)
-		{
-			return brFloatMax;
-		}
-
-		return (nodeWinScore / nodeVisit) + explorationParam * FMath::Sqrt(FMath::Loge(totalVisit) / static_cast<brFloat>(nodeVisit));
-	};
 
-	Node* bestNode = nullptr;
-	brU32 const parentVisit = node->State.VisitCount;
-	brFloat highestUctValue = brFloatMin;
-	for(Node& childNode : node->Children)
+	m_mutex.Lock();
 	{
-		brFloat const uctValue = uctValueFct(parentVisit, childNode.State.WinScore, childNode.State.VisitCount);
-		if(uctValue > highestUctValue || !bestNode)
+		if (isSearched)
 		{
-			bestNode = &childNode;
-			highestUctValue = uctValue;
+			++m_numDecisions;
+			m_totalSavedSeconds += result.SavedSeconds;
+			(job->Request.IsOpponentTokenSearch() ? m_lastOpponentTokenStats : m_lastMoveStats) = result.Stats;
 		}
+		m_runningJob.Reset();
 	}
-	
-	return bestNode;
-}
\ No newline at end of file
+	m_mutex.Unlock();
+
+	job->Complete(job, result);
+	--m_numPendingJobs;
+}
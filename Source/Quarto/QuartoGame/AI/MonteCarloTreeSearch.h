@@ -1,8 +1,16 @@
 #pragma once
-#include "HAL/Runnable.h"
-#include "HAL/ThreadSafeBool.h"
+#include "Async/Future.h"
+#include "Containers/Queue.h"
+#include "Templates/Function.h"
 #include "Quarto/Common/UnrealCommon.h"
 #include "Quarto/QuartoGame/QuartoData.h"
+#include "QuartoCore/MCTS/SearchSettings.h"
+#include "QuartoCore/MCTS/SearchSnapshot.h"
+#include "QuartoCore/MCTS/SearchStats.h"
+#include "QuartoCore/MCTS/SearchTree.h"
+
+#include <atomic>
+#include <memory>
 
 namespace ai
 {
@@ -10,125 +18,141 @@ namespace ai
 	{
 		namespace internal
 		{
-			class MCTSThread;
+			class SearchQueue;
 		}
 
+		struct SearchJob;
+		using SearchJobPtr = TSharedPtr<SearchJob, ESPMode::ThreadSafe>;
+
+		// A queued search, shared between the caller and the search workers
+		struct SearchJob
+		{
+			// Stops the search and drops the completion delegate, the future still gets the best decision so far
+			void Cancel() { IsCancelled = true; Control->Stop(); }
+
+			SearchRequest Request;
+			// Stop, deadline and best-so-far of the search, usable while the job is queued as well
+			std::shared_ptr<SearchControl> Control = std::make_shared<SearchControl>();
+			std::atomic<brBool> IsCancelled { false };
+			// MonteCarloTreeSearch::CancelAllRequests cancels every job of an older generation
+			brU32 Generation = 0;
+			// Converts the result for the game, fulfills the future and schedules the completion delegate, runs on a search worker
+			TUniqueFunction<void(SearchJobPtr const& job, SearchResult const& result)> Complete;
+		};
+
+		// Handle of a queued search: the future decision and a way to cancel the search
+		// The future is always fulfilled, cancelled or interrupted searches deliver their best decision so far or a random one
+		template <typename T>
+		class SearchHandle
+		{
+		public:
+			SearchHandle() = default;
+			SearchHandle(TFuture<T>&& future, SearchJobPtr job)
+				: m_future(MoveTemp(future))
+				, m_job(MoveTemp(job)) {}
+
+			brBool IsValid() const { return m_future.IsValid(); }
+			brBool IsReady() const { return m_future.IsReady(); }
+			// Blocks until the decision is made
+			T const& Get() const { return m_future.Get(); }
+			void Cancel() const { if (m_job) { m_job->Cancel(); } }
+			// Ends the search right away, the future and the completion delegate get the best decision so far
+			void DecideNow() const { if (m_job) { m_job->Control->Stop(); } }
+			// Replaces the time limit of the budget: the decision is made the given time from now, queued or not
+			void SetDeadline(brFloat secondsFromNow) const { if (m_job) { m_job->Control->SetDeadlineFromNow(secondsFromNow); } }
+			// Moves the deadline, negative seconds pull it in
+			void ExtendDeadline(brFloat seconds) const { if (m_job) { m_job->Control->ExtendDeadline(seconds); } }
+			// Most visited action of the running search, InvalidAction while it is queued
+			Action GetBestActionSoFar() const { return m_job ? m_job->Control->GetBestActionSoFar() : InvalidAction; }
+			TFuture<T>& GetFuture() { return m_future; }
+
+		private:
+			TFuture<T> m_future;
+			SearchJobPtr m_job;
+		};
+
+		// Called on the game thread as soon as the decision is made
+		template <typename T>
+		using OnSearchFinished = TFunction<void(T const&)>;
+
 		class MonteCarloTreeSearch
 		{
 		public:
-			MonteCarloTreeSearch(brFloat maxMoveSearchTimeInSeconds, brFloat maxOpponentTokenSearchTimeInSeconds);
+			// The searches run on the shared SearchScheduler, next to the searches of all other games
+			// A priority of 2 gets twice the cpu time of the default priority 1 while the workers are busy
+			explicit MonteCarloTreeSearch(SearchSettings const& settings, brU32 priority = 1);
 			~MonteCarloTreeSearch();
 
-			void FindNextOpponentToken(QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId) const;
-			void FindNextMove(QuartoTokenData const& token, QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId) const;
-			brBool IsLookingForNextMove() const;
-			brBool IsLookingForNextOpponentToken() const;
-			brBool HasFoundNextMove() const;
-			brBool HasFoundNextOpponentToken() const;
-			QuartoBoardSlotCoordinates GetNextMoveCoordinates() const;
-			QuartoTokenData GetNextOpponentToken() const;
-			
+			// Requests are queued and searched one after another
+			// deadlineSeconds replaces the time limit of the budget with a deadline, the time spent in the queue included (0 = time limit of the budget)
+			SearchHandle<QuartoTokenData> FindNextOpponentToken(QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId,
+				OnSearchFinished<QuartoTokenData> onFound = nullptr, brFloat deadlineSeconds = 0.f) const;
+			SearchHandle<QuartoBoardSlotCoordinates> FindNextMove(QuartoTokenData const& token, QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId,
+				OnSearchFinished<QuartoBoardSlotCoordinates> onFound = nullptr, brFloat deadlineSeconds = 0.f) const;
+			// Queued and running requests
+			brU32 GetNumPendingRequests() const;
+			// Cancels the running and all queued requests, e.g. when a match is abandoned
+			void CancelAllRequests() const;
+			// Time left in the budgets of all finished searches, because of the early termination
+			brDouble GetAverageSecondsSavedPerDecision() const;
+			// Telemetry of the last finished searches
+			SearchStats GetLastMoveSearchStats() const;
+			SearchStats GetLastOpponentTokenSearchStats() const;
+			// Live state of the running or last search, never blocks the search workers
+			// Only one thread may read the snapshots (the game thread)
+			SearchSnapshot const& GetLatestSearchSnapshot() const;
+
 		protected:
-			internal::MCTSThread* m_threadWorker = nullptr;
+			SearchJobPtr CreateJob(SearchBudgetSettings const& budgetSettings, QuartoBoardData const& boardData, quarto::TokenId token, PlayerId playerId, PlayerId opponentId, brFloat deadlineSeconds) const;
+
+		protected:
+			TSharedPtr<internal::SearchQueue, ESPMode::ThreadSafe> m_queue;
 		};
 
 		namespace internal
 		{
-			struct State
+			// Requests of one MonteCarloTreeSearch, handed to the SearchScheduler one at a time
+			// The callbacks of the scheduler keep the queue alive, so it can be released while a search is still running
+			class SearchQueue : public TSharedFromThis<SearchQueue, ESPMode::ThreadSafe>
 			{
-				TArray<State> GetAllPossibleStates(QuartoTokenData const* token) const;
-				void RandomPlay();
-
-				//Helper
-				void ReplacePlayerIdWithUnused(PlayerId id1, PlayerId id2);
-
-				QuartoBoardData BoardData;
-				brU32 VisitCount = 0;
-				brS32 WinScore = 0;
-				PlayerId PlayerId = 0;
-			};
-
-			struct Node
-			{
-				Node& GetChildWithHighestScore();
-				Node& GetRandomChild();
+			public:
+				SearchQueue(SearchSettings const& settings, brU32 priority);
 
-				State State;
-				Node* Parent = nullptr;
-				TArray<Node> Children;
-			};
+				void Enqueue(SearchJobPtr const& job);
+				void CancelAllJobs();
+				// Cancels the running job and every queued or later enqueued one
+				void Shutdown();
+				brU32 GetNumPendingJobs() const { return m_numPendingJobs; }
 
-			//https://wiki.unrealengine.com/MultiThreading_and_synchronization_Guide
-			class MCTSThread : public FRunnable
-			{
-			public:
-				MCTSThread(brFloat maxMoveSearchTimeInSeconds, brFloat maxOpponentTokenSearchTimeInSeconds);
-				~MCTSThread();
-				
-				uint32 Run() override;
-				void Stop() override;
-				brBool IsProcessingAnyRequest() const;
-
-				void RequestNextMove(QuartoTokenData const& token, QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId);
-				void RequestNextOpponentToken(QuartoBoardData const& currentBoard, PlayerId playerId, PlayerId opponentId);
-
-				void SearchNextMove();
-				void SearchNextOpponentToken();
-				
-				brBool IsMoveRequestFinished() const { return m_moveRequest.IsProcessed && m_moveRequest.IsMoveFound; }
-				brBool IsOpponentTokenRequestFinished() const { return m_opponentTokenRequest.IsProcessed && m_opponentTokenRequest.IsTokenFound; }
-				QuartoTokenData ConsumeRequestResultOpponentToken();
-				QuartoBoardSlotCoordinates ConsumeRequestResultNextMove();
+				SearchSettings const& GetSettings() const { return m_settings; }
+				brDouble GetAverageSecondsSavedPerDecision();
+				SearchStats GetLastMoveSearchStats();
+				SearchStats GetLastOpponentTokenSearchStats();
+				SearchSnapshot const& GetLatestSearchSnapshot();
 
 			protected:
-				void PauseThread();
-				void ContinueThread();
-				
-				QuartoBoardData SearchNextDraw(brFloat maxSearchTime, QuartoBoardData const* boardData, QuartoTokenData const* tokenData, PlayerId playerId, PlayerId opponentId, brBool negate) const;
-				
-				// Selects the most promising node outgoing from this node
-				static Node* Select(Node* node);
-				// Expands the given node with new possible nodes
-				static void Expand(Node* node, PlayerId playerId, PlayerId opponentId, QuartoTokenData const* token);
-				// Simulates a random play and returns the winner
-				static PlayerId Simulate(Node* node, PlayerId playerId, PlayerId opponentId, brBool negate);
-				// Backpropagates the results
-				static void BackPropagate(Node* node, PlayerId playerId, brBool negate);
-
-				static Node* FindBestNodeWithUct(Node* node);
+				// Submits the next job unless one is running, cancelled jobs are completed right away
+				void SubmitNextJob();
+				void CompleteJob(SearchJobPtr const& job, SearchResult const& result, brBool isSearched);
 
 			protected:
-				//Thread to run the worker FRunnable on
-				FRunnableThread* m_thread;
-				FEvent* m_semaphore;
 				FCriticalSection m_mutex;
-				FThreadSafeBool m_kill;
-				FThreadSafeBool m_pause;
-
-				brFloat m_maxMoveSearchTimeInSeconds;
-				brFloat m_maxOpponentTokenSearchTimeInSeconds;
-
-				struct
-				{
-					QuartoBoardData BoardData;
-					QuartoTokenData TokenData;
-					QuartoBoardSlotCoordinates ResultMove;
-					::PlayerId PlayerId;
-					::PlayerId OpponentId;
-					FThreadSafeBool IsMoveFound;
-					FThreadSafeBool IsProcessed;
-				} m_moveRequest;
-
-				struct
-				{
-					QuartoBoardData BoardData;
-					QuartoTokenData ResultToken;
-					::PlayerId PlayerId;
-					::PlayerId OpponentId;
-					FThreadSafeBool IsTokenFound;
-					FThreadSafeBool IsProcessed;
-				} m_opponentTokenRequest;
+				std::atomic<brBool> m_kill;
+
+				TQueue<SearchJobPtr, EQueueMode::Mpsc> m_jobs;
+				std::atomic<brU32> m_numPendingJobs;
+				std::atomic<brU32> m_generation;
+				//guarded by m_mutex, only one job of the queue runs at a time
+				SearchJobPtr m_runningJob;
+
+				SearchSettings m_settings;
+				brU32 m_priority;
+				brU32 m_numDecisions = 0;
+				brDouble m_totalSavedSeconds = 0.0;
+				SearchStats m_lastMoveStats;
+				SearchStats m_lastOpponentTokenStats;
+				SearchSnapshotBuffer m_snapshots;
 			};
 		}
 	}
-}
\ No newline at end of file
+}
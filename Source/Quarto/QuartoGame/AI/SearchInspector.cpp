@@ -0,0 +1,152 @@
+#include "Quarto/QuartoGame/AI/SearchInspector.h"
+
+#ifdef IMGUI_ENABLED
+
+#include <cstdio>
+
+using namespace ai::mcts;
+
+namespace
+{
+	ImVec2 const s_cellSize(56.f, 40.f);
+
+	// Short name of a token, one letter per attribute: Tall/small, Hole/filled, Round/quadratic, color 1/2
+	void GetTokenName(quarto::TokenId token, char (&name)[5])
+	{
+		name[0] = (token & quarto::TokenAttribute_Tall) ? 'T' : 's';
+		name[1] = (token & quarto::TokenAttribute_Hole) ? 'H' : 'f';
+		name[2] = (token & quarto::TokenAttribute_Round) ? 'R' : 'q';
+		name[3] = (token & quarto::TokenAttribute_Color2) ? '2' : '1';
+		name[4] = '\0';
+	}
+
+	// Cold (blue) for rarely visited up to hot (red) for the most visited cells
+	ImVec4 GetHeatColor(brFloat heat)
+	{
+		return ImVec4(0.15f + 0.75f * heat, 0.2f, 0.9f - 0.75f * heat, 1.f);
+	}
+
+	// A cell of a heat map, blocked cells are slots which are taken or tokens which are used up
+	void DrawHeatCell(brU32 id, char const* name, brBool isBlocked, brBool isBest, brU32 visits, brU32 maxVisits, brFloat winRate)
+	{
+		ImVec4 const color = isBlocked ? ImVec4(0.3f, 0.3f, 0.3f, 1.f) : GetHeatColor(maxVisits > 0 ? static_cast<brFloat>(visits) / maxVisits : 0.f);
+		ImGui::PushID(static_cast<int>(id));
+		ImGui::PushStyleColor(ImGuiCol_Button, color);
+		ImGui::PushStyleColor(ImGuiCol_ButtonHovered, color);
+		ImGui::PushStyleColor(ImGuiCol_ButtonActive, color);
+		if (isBest)
+		{
+			ImGui::PushStyleVar(ImGuiStyleVar_FrameBorderSize, 2.f);
+			ImGui::PushStyleColor(ImGuiCol_Border, ImVec4(1.f, 1.f, 0.f, 1.f));
+		}
+
+		char label[32];
+		if (isBlocked || visits == 0)
+		{
+			std::snprintf(label, sizeof(label), "%s", name);
+		}
+		else
+		{
+			std::snprintf(label, sizeof(label), "%s\n%.0f%%", name, 100.f * winRate);
+		}
+		ImGui::Button(label, s_cellSize);
+		if (!isBlocked && ImGui::IsItemHovered())
+		{
+			ImGui::SetTooltip("%s: %u visits, win rate %.1f%%", name, visits, 100.f * winRate);
+		}
+
+		if (isBest)
+		{
+			ImGui::PopStyleColor();
+			ImGui::PopStyleVar();
+		}
+		ImGui::PopStyleColor(3);
+		ImGui::PopID();
+	}
+
+	brU32 GetMaxVisits(brU32 const* visits, brU32 count)
+	{
+		brU32 maxVisits = 0;
+		for (brU32 i = 0; i < count; ++i)
+		{
+			maxVisits = FMath::Max(maxVisits, visits[i]);
+		}
+		return maxVisits;
+	}
+}
+
+void ai::mcts::DrawSearchInspector(SearchSnapshot const& snapshot)
+{
+	if (!ImGui::Begin("MCTS Inspector"))
+	{
+		ImGui::End();
+		return;
+	}
+
+	if (!snapshot.IsValid)
+	{
+		ImGui::TextDisabled("No search yet");
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("%s search, %s", snapshot.IsOpponentTokenSearch ? "Opponent token" : "Move", snapshot.IsFinished ? "finished" : "running");
+	brDouble const playoutsPerSecond = snapshot.ElapsedSeconds > 0.0 ? snapshot.NumPlayouts / snapshot.ElapsedSeconds : 0.0;
+	ImGui::Text("Playouts/s: %.0f (%u threads)", playoutsPerSecond, snapshot.NumThreads);
+	ImGui::Text("Iterations: %u, playouts: %u", snapshot.NumIterations, snapshot.NumPlayouts);
+	ImGui::Text("Tree: %u nodes, %.1f KB peak", snapshot.NumNodes, snapshot.PeakTreeBytes / 1024.0);
+
+	char overlay[32];
+	if (snapshot.MaxSeconds > 0.0)
+	{
+		std::snprintf(overlay, sizeof(overlay), "%.2f / %.2f s", snapshot.ElapsedSeconds, snapshot.MaxSeconds);
+		ImGui::ProgressBar(static_cast<brFloat>(FMath::Min(snapshot.ElapsedSeconds / snapshot.MaxSeconds, 1.0)), ImVec2(-1.f, 0.f), overlay);
+	}
+	else
+	{
+		ImGui::Text("Time: %.2f s (no time limit)", snapshot.ElapsedSeconds);
+	}
+	ImGui::Text("Estimated win rate: %.1f%%", 100.f * snapshot.EstimatedWinRate);
+
+	quarto::SlotIndex const bestSlot = snapshot.BestAction != InvalidAction ? GetActionSlot(snapshot.BestAction) : quarto::InvalidSlot;
+	quarto::TokenId const bestToken = snapshot.BestAction != InvalidAction ? GetActionToken(snapshot.BestAction) : quarto::InvalidToken;
+
+	ImGui::Separator();
+	ImGui::Text("Board");
+	brU32 const maxSlotVisits = GetMaxVisits(snapshot.SlotVisits, QUARTO_BOARD_AVAILABLE_SLOTS);
+	for (brU32 slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+	{
+		if (slot % QUARTO_BOARD_SIZE_X != 0)
+		{
+			ImGui::SameLine();
+		}
+
+		brBool const isTaken = !snapshot.Board.IsSlotEmpty(static_cast<quarto::SlotIndex>(slot));
+		char name[5] = "";
+		if (isTaken)
+		{
+			GetTokenName(snapshot.Board.GetToken(static_cast<quarto::SlotIndex>(slot)), name);
+		}
+		DrawHeatCell(slot, name, isTaken, slot == bestSlot, snapshot.SlotVisits[slot], maxSlotVisits, snapshot.SlotWinRates[slot]);
+	}
+
+	ImGui::Separator();
+	ImGui::Text("%s", snapshot.IsOpponentTokenSearch ? "Tokens for the opponent" : "Token to place");
+	brU32 const maxTokenVisits = GetMaxVisits(snapshot.TokenVisits, quarto::NumTokens);
+	for (brU32 token = 0; token < quarto::NumTokens; ++token)
+	{
+		if (token % 8 != 0)
+		{
+			ImGui::SameLine();
+		}
+
+		char name[5];
+		GetTokenName(static_cast<quarto::TokenId>(token), name);
+		brBool const isUsed = !snapshot.Board.IsTokenFree(static_cast<quarto::TokenId>(token));
+		DrawHeatCell(QUARTO_BOARD_AVAILABLE_SLOTS + token, name, isUsed, token == bestToken, snapshot.TokenVisits[token], maxTokenVisits, snapshot.TokenWinRates[token]);
+	}
+
+	ImGui::End();
+}
+
+#endif
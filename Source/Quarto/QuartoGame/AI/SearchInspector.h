@@ -0,0 +1,15 @@
+#pragma once
+#include "Quarto/Quarto.h"
+#include "QuartoCore/MCTS/SearchSnapshot.h"
+
+namespace ai
+{
+	namespace mcts
+	{
+#ifdef IMGUI_ENABLED
+		// ImGui window with the live state of the AI search: throughput, tree size, time budget
+		// and the visits and win rates of the root children as heat maps over the 4x4 board and the 16 tokens
+		void DrawSearchInspector(SearchSnapshot const& snapshot);
+#endif
+	}
+}
@@ -1,9 +1,7 @@
 #pragma once
 
-#define QUARTO_NUM_OF_PLAYERS 2
-#define QUARTO_BOARD_SIZE_X 4
-#define QUARTO_BOARD_SIZE_Y 4
-#define QUARTO_BOARD_AVAILABLE_SLOTS 16
+//QUARTO_* board dimensions
+#include "QuartoCore/Board/Board.h"
 
 UENUM(BlueprintType)
 enum class EQuartoPlayerType : uint8 /*brU8 -> UE header tool doesn't like it*/
@@ -1,4 +1,5 @@
 #include "Quarto/QuartoGame/QuartoData.h"
+#include "QuartoCore/Common/BitUtils.h"
 
 TArray<QuartoTokenData> QuartoTokenData::s_possiblePermutations =
 {
@@ -24,11 +25,29 @@ QuartoTokenData::QuartoTokenData(EQuartoTokenColor color, TArray<EQuartoTokenPro
 	: m_color(color)
 	, m_properties(properties)
 	, m_propertiesBitmask(0u)
+	, m_tokenId(quarto::InvalidToken)
 {
 	for (EQuartoTokenProperties property : properties)
 	{
 		m_propertiesBitmask |= static_cast<brS32>(property);
 	}
+
+	auto const hasExactlyOne = [this](EQuartoTokenProperties property, EQuartoTokenProperties opposite)
+	{
+		return ((m_propertiesBitmask & static_cast<brU32>(property)) > 0) != ((m_propertiesBitmask & static_cast<brU32>(opposite)) > 0);
+	};
+	if (m_color != EQuartoTokenColor::Undefined
+		&& hasExactlyOne(EQuartoTokenProperties::Tall, EQuartoTokenProperties::Small)
+		&& hasExactlyOne(EQuartoTokenProperties::Hole, EQuartoTokenProperties::Filled)
+		&& hasExactlyOne(EQuartoTokenProperties::Round, EQuartoTokenProperties::Quadratic))
+	{
+		//see quarto::TokenAttribute, s_possiblePermutations is ordered the same way
+		m_tokenId = 0;
+		m_tokenId |= (m_propertiesBitmask & static_cast<brU32>(EQuartoTokenProperties::Tall)) ? quarto::TokenAttribute_Tall : 0;
+		m_tokenId |= (m_propertiesBitmask & static_cast<brU32>(EQuartoTokenProperties::Hole)) ? quarto::TokenAttribute_Hole : 0;
+		m_tokenId |= (m_propertiesBitmask & static_cast<brU32>(EQuartoTokenProperties::Round)) ? quarto::TokenAttribute_Round : 0;
+		m_tokenId |= m_color == EQuartoTokenColor::Color2 ? quarto::TokenAttribute_Color2 : 0;
+	}
 }
 
 bool QuartoTokenData::operator==(QuartoTokenData const& other) const
@@ -41,9 +60,10 @@ bool QuartoBoardSlotCoordinates::operator==(QuartoBoardSlotCoordinates const& ot
 	return X == other.X && Y == other.Y;
 }
 
-brU32 QuartoBoardData::GetNumberOfFreeSlots() const
+QuartoBoardData::GameStatus QuartoBoardData::GetStatus() const
 {
-	return GetEmptySlotCoordinates().Num();
+	QUARTO_SCOPE_CYCLE_COUNTER(Board_GetStatus);
+	return m_board.GetStatus();
 }
 
 TArray<QuartoBoardSlotCoordinates> QuartoBoardData::GetEmptySlotCoordinates() const
@@ -51,7 +71,7 @@ TArray<QuartoBoardSlotCoordinates> QuartoBoardData::GetEmptySlotCoordinates() co
 	TArray<QuartoBoardSlotCoordinates> freeSlotCoordinates;
 	for (brU32 i = 0; i < QUARTO_BOARD_AVAILABLE_SLOTS; ++i)
 	{
-		if (!m_tokensOnBoardGrid[i].IsValid())
+		if (m_board.IsSlotEmpty(i))
 		{
 			freeSlotCoordinates.Push(ConvertIndexToSlotCoordinates(i));
 		}
@@ -59,25 +79,32 @@ TArray<QuartoBoardSlotCoordinates> QuartoBoardData::GetEmptySlotCoordinates() co
 	return freeSlotCoordinates;
 }
 
-TArray<QuartoTokenData> QuartoBoardData::GetFreeTokens() const
+TArray<QuartoBoardSlotCoordinates> QuartoBoardData::GetWinningSlotCoordinates(QuartoTokenData const& token) const
 {
-	TArray<QuartoTokenData> tokens = QuartoTokenData::s_possiblePermutations;
-	for(auto& token : m_tokensOnBoardGrid)
+	TArray<QuartoBoardSlotCoordinates> winningSlotCoordinates;
+	if (token.GetTokenId() == quarto::InvalidToken)
 	{
-		if(token.IsValid())
-		{
-			tokens.Remove(token);
-		}
+		return winningSlotCoordinates;
 	}
-	return tokens;
+
+	for (brU32 slots = m_board.GetWinningSlotsMask(token.GetTokenId()); slots; slots &= slots - 1)
+	{
+		winningSlotCoordinates.Push(ConvertIndexToSlotCoordinates(quarto::GetIndexOfLowestSetBit(slots)));
+	}
+	return winningSlotCoordinates;
 }
 
-void QuartoBoardData::Reset()
+TArray<QuartoTokenData> QuartoBoardData::GetFreeTokens() const
 {
-	for (auto& tokenData : m_tokensOnBoardGrid)
+	TArray<QuartoTokenData> tokens;
+	for (quarto::TokenId tokenId = 0; tokenId < quarto::NumTokens; ++tokenId)
 	{
-		tokenData.Invalidate();
+		if (m_board.IsTokenFree(tokenId))
+		{
+			tokens.Add(QuartoTokenData::FromTokenId(tokenId));
+		}
 	}
+	return tokens;
 }
 
 QuartoBoardSlotCoordinates QuartoBoardData::ConvertIndexToSlotCoordinates(brU32 slotIndex)
@@ -90,72 +117,25 @@ brU32 QuartoBoardData::ConvertCoordinatesToSlotIndex(QuartoBoardSlotCoordinates
 	return coordinates.Y * QUARTO_BOARD_SIZE_Y + coordinates.X;
 }
 
-QuartoBoardData::GameStatus QuartoBoardData::GetStatus() const
+void QuartoBoardData::SetTokenOnBoard(QuartoBoardSlotCoordinates coordinates, QuartoTokenData const& token)
 {
-	static constexpr brU8 numWinConstellations = 10;
-	static brU32 winConstellations[numWinConstellations][4] =
+	if (!coordinates.AreValid())
 	{
-		//vertical
-		{0,4,8,12},
-		{1,5,9,13},
-		{2,6,10,14},
-		{3,7,11,15},
-
-		//horizontal
-		{0,1,2,3},
-		{4,5,6,7},
-		{8,9,10,11},
-		{12,13,14,15},
-
-		//diagonal
-		{0,5,10,15},
-		{12,9,6,3}
-	};
-
-	for (brU8 y = 0; y < numWinConstellations; ++y)
-	{
-		brU32* indices = winConstellations[y];
-
-		if (!m_tokensOnBoardGrid[indices[0]].IsValid()
-			|| !m_tokensOnBoardGrid[indices[1]].IsValid()
-			|| !m_tokensOnBoardGrid[indices[2]].IsValid()
-			|| !m_tokensOnBoardGrid[indices[3]].IsValid())
-		{
-			continue;
-		}
-
-		brU32 const matchingPropertiesMask =
-			m_tokensOnBoardGrid[indices[0]].GetPropertiesBitMask() &
-			m_tokensOnBoardGrid[indices[1]].GetPropertiesBitMask() &
-			m_tokensOnBoardGrid[indices[2]].GetPropertiesBitMask() &
-			m_tokensOnBoardGrid[indices[3]].GetPropertiesBitMask();
-
-		brU32 const matchingColor =
-			m_tokensOnBoardGrid[indices[0]].GetColorBitMask() &
-			m_tokensOnBoardGrid[indices[1]].GetColorBitMask() &
-			m_tokensOnBoardGrid[indices[2]].GetColorBitMask() &
-			m_tokensOnBoardGrid[indices[3]].GetColorBitMask();
-
-		//see EQuartoTokenColor && EQuartoTokenProperties that no value starts at 0
-		if (matchingPropertiesMask > 0 || matchingColor > 0)
-		{
-			return GameStatus::End;
-		}
+		return;
 	}
 
-	//draw!
-	if(GetNumberOfFreeSlots() == 0 || GetFreeTokens().Num() == 0)
+	if (token.GetTokenId() == quarto::InvalidToken)
 	{
-		return GameStatus::End;
+		UE_LOG(LogTemp, Error, TEXT("ERROR: Token without a complete set of properties can't be placed on the board!"));
+		return;
 	}
-
-	return GameStatus::InProgress;
+	m_board.SetTokenOnBoard(ConvertCoordinatesToSlotIndex(coordinates), token.GetTokenId());
 }
 
-void QuartoBoardData::SetTokenOnBoard(QuartoBoardSlotCoordinates coordinates, QuartoTokenData const& token)
+void QuartoBoardData::RemoveTokenFromBoard(QuartoBoardSlotCoordinates coordinates)
 {
 	if (coordinates.AreValid())
 	{
-		m_tokensOnBoardGrid[ConvertCoordinatesToSlotIndex(coordinates)] = token;
+		m_board.RemoveTokenFromBoard(ConvertCoordinatesToSlotIndex(coordinates));
 	}
-}
\ No newline at end of file
+}
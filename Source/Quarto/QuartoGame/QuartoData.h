@@ -21,7 +21,11 @@ struct QuartoTokenData
 	brU32 GetColorBitMask() const { return static_cast<brU32>(m_color); }
 
 	brBool IsValid() const { return m_propertiesBitmask > 0; }
-	void Invalidate() { m_propertiesBitmask = 0; }
+	void Invalidate() { m_propertiesBitmask = 0; m_tokenId = quarto::InvalidToken; }
+
+	// Id of this token in the core board model, InvalidToken if a color or property is missing
+	quarto::TokenId GetTokenId() const { return m_tokenId; }
+	static QuartoTokenData const& FromTokenId(quarto::TokenId tokenId) { return s_possiblePermutations[tokenId]; }
 
 public:
 	static TArray<QuartoTokenData> s_possiblePermutations;
@@ -30,6 +34,7 @@ private:
 	EQuartoTokenColor m_color;
 	TArray<EQuartoTokenProperties> m_properties;
 	brU32 m_propertiesBitmask;
+	quarto::TokenId m_tokenId;
 };
 
 struct QuartoBoardSlotCoordinates
@@ -44,25 +49,32 @@ struct QuartoBoardSlotCoordinates
 	brU32 X, Y;
 };
 
+// Engine side view of the core board model
 struct QuartoBoardData
 {
-	enum class GameStatus
-	{
-		InProgress,
-		End
-	};
+	using GameStatus = quarto::Board::GameStatus;
 
-	brU32 GetNumberOfFreeSlots() const;
+	brU32 GetNumberOfFreeSlots() const { return m_board.GetNumberOfFreeSlots(); }
 	TArray<QuartoBoardSlotCoordinates> GetEmptySlotCoordinates() const;
 	TArray<QuartoTokenData> GetFreeTokens() const;
 	GameStatus GetStatus() const;
+	brBool HasWinningLine() const { return m_board.HasWinningLine(); }
+	// Number of lines with three tokens sharing a property and one free slot -> one token away from a win
+	brU32 GetNumberOfThreatLines() const { return m_board.GetNumberOfThreatLines(); }
+	// Hints: handing the token over doesn't let the opponent win right away
+	brBool IsTokenSafe(QuartoTokenData const& token) const { return token.GetTokenId() != quarto::InvalidToken && m_board.IsTokenSafe(token.GetTokenId()); }
+	// Hints: slots on which the token completes a line
+	TArray<QuartoBoardSlotCoordinates> GetWinningSlotCoordinates(QuartoTokenData const& token) const;
 
 	void SetTokenOnBoard(QuartoBoardSlotCoordinates coordinates, QuartoTokenData const& token);
-	void Reset();
+	void RemoveTokenFromBoard(QuartoBoardSlotCoordinates coordinates);
+	void Reset() { m_board.Reset(); }
+
+	quarto::Board const& GetCoreBoard() const { return m_board; }
 
-private:
 	static QuartoBoardSlotCoordinates ConvertIndexToSlotCoordinates(brU32 slotIndex);
 	static brU32 ConvertCoordinatesToSlotIndex(QuartoBoardSlotCoordinates const& coordinates);
-	
-	QuartoTokenData m_tokensOnBoardGrid[QUARTO_BOARD_AVAILABLE_SLOTS]; //xDim, yDim = 4
+
+private:
+	quarto::Board m_board;
 };
@@ -4,11 +4,16 @@
 #include "Camera/CameraComponent.h"
 #include "Engine/World.h"
 #include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
 #include "Quarto/QuartoGame/AI/MonteCarloTreeSearch.h"
+#include "Quarto/QuartoGame/AI/SearchInspector.h"
 #include "Quarto/QuartoGame/QuartoBoard.h"
 #include "Quarto/QuartoGame/QuartoBoardSlotComponent.h"
 #include "Quarto/QuartoGame/QuartoGameCameraComponent.h"
 #include "Quarto/QuartoGame/QuartoToken.h"
+#include "QuartoCore/Common/BitUtils.h"
+#include "QuartoCore/Records/GameRecordWriter.h"
 
 AQuartoGame::AQuartoGame(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
@@ -17,6 +22,17 @@ AQuartoGame::AQuartoGame(const FObjectInitializer& ObjectInitializer)
 	, m_player2(EQuartoPlayerType::Human)
 	, m_maxAiThinkTimeForNextMove(5.0f)
 	, m_maxAiThinkTimeForNextOpponentToken(0.5f)
+	, m_maxAiIterationsForNextMove(0)
+	, m_maxAiIterationsForNextOpponentToken(0)
+	, m_maxAiTreeMemoryInMB(64)
+	, m_aiUseRave(true)
+	, m_aiRaveEquivalenceParameter(1000.f)
+	, m_aiUseProgressiveWidening(true)
+	, m_aiUseDeterministicSearch(false)
+	, m_aiRandomSeed(0)
+	, m_aiPriority(1)
+	, m_showAiSearchInspector(false)
+	, m_recordGames(false)
 	, m_gameState(EQuartoGameState::GameStart)
 #ifdef DEBUG_BUILD
 	, m_oldGameState(EQuartoGameState::GameEnd)
@@ -25,6 +41,7 @@ AQuartoGame::AQuartoGame(const FObjectInitializer& ObjectInitializer)
 	, m_focusedToken(nullptr)
 	, m_currentPlayer(EQuartoPlayer::Count)
 	, m_mctsAi(nullptr)
+	, m_gameRecordWriter(nullptr)
 {
 	RootComponent = CreateDefaultSubobject<USceneComponent>(FName("Root"));
 
@@ -36,7 +53,45 @@ void AQuartoGame::BeginPlay()
 {
 	Super::BeginPlay();
 
-	m_mctsAi = new ai::mcts::MonteCarloTreeSearch(m_maxAiThinkTimeForNextMove, m_maxAiThinkTimeForNextOpponentToken);
+	ai::mcts::SearchSettings aiSettings;
+	aiSettings.MoveSearchBudget.MaxSeconds = m_maxAiThinkTimeForNextMove;
+	aiSettings.MoveSearchBudget.MaxIterations = static_cast<brU32>(FMath::Max(m_maxAiIterationsForNextMove, 0));
+	aiSettings.OpponentTokenSearchBudget.MaxSeconds = m_maxAiThinkTimeForNextOpponentToken;
+	aiSettings.OpponentTokenSearchBudget.MaxIterations = static_cast<brU32>(FMath::Max(m_maxAiIterationsForNextOpponentToken, 0));
+	aiSettings.MoveSearchBudget.MaxTreeBytes = static_cast<brU64>(FMath::Max(m_maxAiTreeMemoryInMB, 0)) * 1024 * 1024;
+	aiSettings.OpponentTokenSearchBudget.MaxTreeBytes = aiSettings.MoveSearchBudget.MaxTreeBytes;
+	aiSettings.UseRave = m_aiUseRave;
+	aiSettings.RaveEquivalenceParameter = m_aiRaveEquivalenceParameter;
+	aiSettings.UseProgressiveWidening = m_aiUseProgressiveWidening;
+	aiSettings.UseDeterministicSearch = m_aiUseDeterministicSearch;
+	aiSettings.RandomSeed = static_cast<brU64>(m_aiRandomSeed);
+	if (m_aiUseDeterministicSearch)
+	{
+		//without the clock only the iteration limits can end a search
+		for (ai::mcts::SearchBudgetSettings* budget : { &aiSettings.MoveSearchBudget, &aiSettings.OpponentTokenSearchBudget })
+		{
+			if (budget->MaxIterations == 0)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Deterministic AI search without an iteration limit, 10000 iterations will be used."));
+				budget->MaxIterations = 10000;
+			}
+		}
+	}
+	m_mctsAi = new ai::mcts::MonteCarloTreeSearch(aiSettings, static_cast<brU32>(FMath::Max(m_aiPriority, 1)));
+
+	if (m_recordGames)
+	{
+		//one file per game actor, the writer expects to be the only one appending to its file
+		FString const recordPath = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("GameRecords") / (GetName() + TEXT(".qrec")));
+		IFileManager::Get().MakeDirectory(*FPaths::GetPath(recordPath), true);
+		m_gameRecordWriter = new quarto::GameRecordWriter(TCHAR_TO_UTF8(*recordPath));
+		if (!m_gameRecordWriter->IsOpen())
+		{
+			UE_LOG(LogTemp, Error, TEXT("ERROR: Can't append game records to %s, the games of %s won't be recorded"), *recordPath, *GetName());
+			delete m_gameRecordWriter;
+			m_gameRecordWriter = nullptr;
+		}
+	}
 	
 	for (AQuartoToken* token : m_gameTokens)
 	{
@@ -70,17 +125,26 @@ void AQuartoGame::StopPlaying(APlayerController* playerController)
 		playerController->UnPossess();
 		m_gameCamera->DetachFromCamera(playerController);
 		m_isPlayed = false;
+		//an abandoned match doesn't need its decisions anymore, the state handlers search again once it is continued
+		CancelAiSearches();
 	}
 }
 
 void AQuartoGame::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	CancelAiSearches();
 	delete m_mctsAi;
+	m_mctsAi = nullptr;
+	FinishGameRecord(quarto::GameResult::Unfinished);
+	//writes the queued games before returning
+	delete m_gameRecordWriter;
+	m_gameRecordWriter = nullptr;
 	Super::EndPlay(EndPlayReason);
 }
 
 void AQuartoGame::Tick(float DeltaSeconds)
 {
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_Tick);
 	Super::Tick(DeltaSeconds);
 
 	if(!m_isPlayed)
@@ -88,6 +152,13 @@ void AQuartoGame::Tick(float DeltaSeconds)
 		return;
 	}
 
+#ifdef IMGUI_ENABLED
+	if (m_showAiSearchInspector && m_mctsAi)
+	{
+		ai::mcts::DrawSearchInspector(m_mctsAi->GetLatestSearchSnapshot());
+	}
+#endif
+
 #ifdef DEBUG_BUILD
 	if(m_oldGameState != m_gameState)
 	{
@@ -140,6 +211,11 @@ void AQuartoGame::SetupPlayerInputComponent(UInputComponent* PlayerInputComponen
 
 void AQuartoGame::HandleGameStart()
 {
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_HandleGameStart);
+	//decisions of the last game must not arrive in this one
+	CancelAiSearches();
+	FinishGameRecord(quarto::GameResult::Unfinished);
+
 	//reset board and everything else
 	m_gameBoard->Reset();
 	for(AQuartoToken* token : m_gameTokens)
@@ -159,18 +235,21 @@ void AQuartoGame::HandleGameStart()
 
 void AQuartoGame::HandleDrawEnd()
 {
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_HandleDrawEnd);
 	SetCurrentPlayer(GetNextPlayer(m_currentPlayer));
 	SetGameState(IsPlayerNpc(m_currentPlayer) ? EQuartoGameState::SlotSelection_NPC : EQuartoGameState::SlotSelection_Human);
 }
 
 void AQuartoGame::HandleGameEnd()
 {
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_HandleGameEnd);
 	//broadcast event
 	SetGameState(EQuartoGameState::GameStart);
 }
 
 void AQuartoGame::HandleTokenSelection_Human()
 {
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_HandleTokenSelection_Human);
 	AQuartoToken* token = FindToken(FetchMouseCursorTargetHitResult());
 
 	if(m_focusedToken && m_focusedToken != token)
@@ -188,31 +267,45 @@ void AQuartoGame::HandleTokenSelection_Human()
 
 void AQuartoGame::HandleTokenSelection_NPC()
 {
-	if (m_gameBoard)
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_HandleTokenSelection_NPC);
+	if (!m_gameBoard)
 	{
-		if (!m_mctsAi->IsLookingForNextOpponentToken() && !m_mctsAi->HasFoundNextOpponentToken())
-		{
-			m_mctsAi->FindNextOpponentToken(
-				m_gameBoard->GetData(),
-				static_cast<brU32>(GetNextPlayer(m_currentPlayer)),
-				static_cast<brU32>(m_currentPlayer)
-			);
-		}
+		SetGameState(EQuartoGameState::DrawEnd);
+		return;
+	}
 
-		if (m_mctsAi->IsLookingForNextOpponentToken() && !m_mctsAi->HasFoundNextOpponentToken())
-		{
-			// do random stuff
-			return;
-		}
-		
-		auto const findToken = [&](QuartoTokenData const& data) { return m_gameTokens.FindByPredicate([&data](AQuartoToken* t) { return t && t->GetData() == data; }); };
-		PickUpToken(*findToken(m_mctsAi->GetNextOpponentToken()));
+	//the search runs in the background and hands its decision over to OnNextOpponentTokenFound
+	if (!m_opponentTokenSearch.IsValid())
+	{
+		TWeakObjectPtr<AQuartoGame> weakThis(this);
+		m_opponentTokenSearch = m_mctsAi->FindNextOpponentToken(
+			m_gameBoard->GetData(),
+			static_cast<brU32>(GetNextPlayer(m_currentPlayer)),
+			static_cast<brU32>(m_currentPlayer),
+			[weakThis](QuartoTokenData const& token) { if (weakThis.IsValid()) { weakThis->OnNextOpponentTokenFound(token); } }
+		);
 	}
+}
+
+void AQuartoGame::OnNextOpponentTokenFound(QuartoTokenData const& token)
+{
+	m_opponentTokenSearch = {};
+	if (m_gameState != EQuartoGameState::TokenSelection_NPC)
+	{
+		return;
+	}
+
+	auto const findToken = [&](QuartoTokenData const& data) { return m_gameTokens.FindByPredicate([&data](AQuartoToken* t) { return t && t->GetData() == data; }); };
+	PickUpToken(*findToken(token));
+#ifdef DEBUG_BUILD
+	UE_LOG(LogTemp, Display, TEXT("MCTS token search: %s"), UTF8_TO_TCHAR(m_mctsAi->GetLastOpponentTokenSearchStats().ToString().c_str()));
+#endif
 	SetGameState(EQuartoGameState::DrawEnd);
 }
 
 void AQuartoGame::HandleSlotSelection_Human()
 {
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_HandleSlotSelection_Human);
 	brBool showDebug = true; // todo: move to imgui
 	if (m_pickedUpToken && m_gameBoard 
 		&& m_gameBoard->CanFindFreeSlot(FetchMouseCursorTargetHitResult(), showDebug))
@@ -223,49 +316,76 @@ void AQuartoGame::HandleSlotSelection_Human()
 
 void AQuartoGame::HandleSlotSelection_NPC()
 {
-	if(m_gameBoard && m_pickedUpToken)
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_HandleSlotSelection_NPC);
+	if (!m_gameBoard || !m_pickedUpToken)
 	{
-		if(!m_mctsAi->IsLookingForNextMove() && !m_mctsAi->HasFoundNextMove())
-		{
-			m_mctsAi->FindNextMove(
-				m_pickedUpToken->GetData(),
-				m_gameBoard->GetData(),
-				static_cast<brU32>(m_currentPlayer),
-				static_cast<brU32>(GetNextPlayer(m_currentPlayer))
-			);
-		}
-		
-		if(m_mctsAi->IsLookingForNextMove() && !m_mctsAi->HasFoundNextMove())
-		{
-			// do random stuff
-			return;
-		}
-		
-		QuartoBoardSlotCoordinates const moveCoordinates = m_mctsAi->GetNextMoveCoordinates();
+		SetGameState(EQuartoGameState::GameBoardValidation);
+		return;
+	}
 
-		m_gameBoard->HoverTokenOverSlot(m_pickedUpToken, moveCoordinates);
-		//wait
-		m_gameBoard->PlaceTokenOnBoardSlot(m_pickedUpToken, moveCoordinates);
+	//the search runs in the background and hands its decision over to OnNextMoveFound
+	if (!m_moveSearch.IsValid())
+	{
+		TWeakObjectPtr<AQuartoGame> weakThis(this);
+		m_moveSearch = m_mctsAi->FindNextMove(
+			m_pickedUpToken->GetData(),
+			m_gameBoard->GetData(),
+			static_cast<brU32>(m_currentPlayer),
+			static_cast<brU32>(GetNextPlayer(m_currentPlayer)),
+			[weakThis](QuartoBoardSlotCoordinates const& moveCoordinates) { if (weakThis.IsValid()) { weakThis->OnNextMoveFound(moveCoordinates); } }
+		);
 	}
-	
+}
+
+void AQuartoGame::OnNextMoveFound(QuartoBoardSlotCoordinates const& moveCoordinates)
+{
+	m_moveSearch = {};
+	if (m_gameState != EQuartoGameState::SlotSelection_NPC || !m_gameBoard || !m_pickedUpToken)
+	{
+		return;
+	}
+
+#ifdef DEBUG_BUILD
+	UE_LOG(LogTemp, Display, TEXT("MCTS move search: %s"), UTF8_TO_TCHAR(m_mctsAi->GetLastMoveSearchStats().ToString().c_str()));
+	UE_LOG(LogTemp, Display, TEXT("MCTS: %.3f seconds saved per decision on average"), m_mctsAi->GetAverageSecondsSavedPerDecision());
+#endif
+
+	m_gameBoard->HoverTokenOverSlot(m_pickedUpToken, moveCoordinates);
+	//wait
+	m_gameBoard->PlaceTokenOnBoardSlot(m_pickedUpToken, moveCoordinates);
 	SetGameState(EQuartoGameState::GameBoardValidation);
 }
 
 void AQuartoGame::HandleGameBoardValidation()
 {
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_HandleGameBoardValidation);
 	//evaluate game
-	brBool const isGameWon = m_gameBoard && m_gameBoard->GetData().GetStatus() == QuartoBoardData::GameStatus::End;
+	brBool const isGameOver = m_gameBoard && m_gameBoard->GetData().GetStatus() == QuartoBoardData::GameStatus::End;
+	//the status also ends a full board without a line, only the line makes it a win
+	brBool const isGameWon = m_gameBoard && m_gameBoard->GetData().HasWinningLine();
 	brBool const canContinuePlaying = m_gameBoard && m_gameBoard->GetData().GetNumberOfFreeSlots() > 0;
+	RecordLastPlacement();
 
 	if (isGameWon)
 	{
 		//broadcast event
 	}
 
-	if (isGameWon || !canContinuePlaying)
+	if (isGameOver || !canContinuePlaying)
 	{
+		//the current player placed the last token, the first player places every odd token
+		brBool const isFirstPlayerPlacing = m_gameRecord.NumPlacements % 2 == 1;
+		FinishGameRecord(!isGameWon ? quarto::GameResult::Draw
+			: isFirstPlayerPlacing ? quarto::GameResult::FirstPlayerWon : quarto::GameResult::SecondPlayerWon);
 		SetGameState(EQuartoGameState::GameEnd);
-		UE_LOG(LogTemp, Display, TEXT("%s won!"), *GetPlayerName(m_currentPlayer));
+		if (isGameWon)
+		{
+			UE_LOG(LogTemp, Display, TEXT("%s won!"), *GetPlayerName(m_currentPlayer));
+		}
+		else
+		{
+			UE_LOG(LogTemp, Display, TEXT("Draw!"));
+		}
 	}
 	else
 	{
@@ -365,6 +485,59 @@ void AQuartoGame::PlaceTokenOnFocusedSlot()
 	}
 }
 
+void AQuartoGame::CancelAiSearches()
+{
+	m_moveSearch = {};
+	m_opponentTokenSearch = {};
+	if (m_mctsAi)
+	{
+		m_mctsAi->CancelAllRequests();
+	}
+}
+
+void AQuartoGame::RecordLastPlacement()
+{
+	if (!m_gameRecordWriter || !m_gameBoard)
+	{
+		return;
+	}
+
+	//the slot filled since the last validation, placements of both the humans and the AI pass through here
+	quarto::Board const& board = m_gameBoard->GetData().GetCoreBoard();
+	brU16 const placedSlotsMask = m_gameRecordBoard.GetEmptySlotsMask() & ~board.GetEmptySlotsMask();
+	if (quarto::CountSetBits(placedSlotsMask) != 1)
+	{
+		return;
+	}
+
+	quarto::SlotIndex const slot = static_cast<quarto::SlotIndex>(quarto::GetIndexOfLowestSetBit(placedSlotsMask));
+	quarto::TokenId const token = board.GetToken(slot);
+	m_gameRecordBoard.SetTokenOnBoard(slot, token);
+	if (IsPlayerNpc(m_currentPlayer) && m_mctsAi)
+	{
+		ai::mcts::SearchStats const stats = m_mctsAi->GetLastMoveSearchStats();
+		m_gameRecord.AddPlacement(slot, token, stats.NumIterations, stats.EstimatedWinRate);
+	}
+	else
+	{
+		m_gameRecord.AddPlacement(slot, token);
+	}
+}
+
+void AQuartoGame::FinishGameRecord(quarto::GameResult result)
+{
+	if (m_gameRecordWriter && m_gameRecord.NumPlacements > 0)
+	{
+		m_gameRecord.Result = result;
+		if (!m_gameRecordWriter->Push(m_gameRecord))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Game record queue of %s is full, the game is dropped"), *GetName());
+		}
+	}
+	m_gameRecord.Reset();
+	m_gameRecordBoard.Reset();
+}
+
 void AQuartoGame::SetCurrentPlayer(EQuartoPlayer player)
 {
 	if(m_currentPlayer != player)
@@ -402,6 +575,7 @@ FHitResult AQuartoGame::FetchMouseCursorTargetHitResult() const
 		queryParams.AddIgnoredActor(m_pickedUpToken);
 	}
 
+	QUARTO_SCOPE_CYCLE_COUNTER(Game_LineTrace);
 	FHitResult hitResult;
 	GetWorld()->LineTraceSingleByChannel(hitResult, start, end, ECC_Visibility, queryParams);
 	return hitResult;
@@ -4,21 +4,19 @@
 #include "GameFramework/Pawn.h"
 #include "Quarto/Common/UnrealCommon.h"
 #include "Quarto/QuartoGame/QuartoCommon.h"
+#include "Quarto/QuartoGame/AI/MonteCarloTreeSearch.h"
+#include "QuartoCore/Records/GameRecord.h"
 #include "QuartoGame.generated.h"
 
-struct QuartoBoardData;
 class APlayerController;
 class AQuartoBoard;
 class AQuartoToken;
 class UQuartoBoardSlotComponent;
 class UQuartoGameCameraComponent;
 
-namespace ai
+namespace quarto
 {
-	namespace mcts
-	{
-		class MonteCarloTreeSearch;
-	}
+	class GameRecordWriter;
 }
 
 /*	----- Quarto Gameflow ----- (http://www.ludoteka.com/quarto-en.html)
@@ -82,6 +80,39 @@ protected:
 	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "Max time to think about next opponent token in seconds"))
 	float m_maxAiThinkTimeForNextOpponentToken;
 
+	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "Max iterations to think about next move (0 = unlimited)", ClampMin = "0"))
+	int32 m_maxAiIterationsForNextMove;
+
+	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "Max iterations to think about next opponent token (0 = unlimited)", ClampMin = "0"))
+	int32 m_maxAiIterationsForNextOpponentToken;
+
+	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "Max memory of the AI search tree in MB (0 = unlimited)", ClampMin = "0"))
+	int32 m_maxAiTreeMemoryInMB;
+
+	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "Use RAVE statistics"))
+	bool m_aiUseRave;
+
+	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "RAVE equivalence parameter", EditCondition = "m_aiUseRave"))
+	float m_aiRaveEquivalenceParameter;
+
+	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "Use progressive widening"))
+	bool m_aiUseProgressiveWidening;
+
+	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "Deterministic search (ignores the time limits)"))
+	bool m_aiUseDeterministicSearch;
+
+	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "Random seed of the deterministic search", EditCondition = "m_aiUseDeterministicSearch"))
+	int32 m_aiRandomSeed;
+
+	UPROPERTY(EditInstanceOnly, Category = "AI Settings", BlueprintReadWrite, meta = (DisplayName = "Priority of the AI search among the searches of all running games", ClampMin = "1"))
+	int32 m_aiPriority;
+
+	UPROPERTY(EditInstanceOnly, Category = "Debug", BlueprintReadWrite, meta = (DisplayName = "Show the live AI search inspector (ImGui, non-shipping builds)"))
+	bool m_showAiSearchInspector;
+
+	UPROPERTY(EditInstanceOnly, Category = "Debug", BlueprintReadWrite, meta = (DisplayName = "Record the played games to Saved/GameRecords/<game name>.qrec"))
+	bool m_recordGames;
+
 	UPROPERTY(Category = "QuartoGame", BlueprintReadOnly)
 	bool m_isPlayed = false;
 	
@@ -117,6 +148,15 @@ private:
 	void HandleSlotSelection_NPC();
 	void HandleGameBoardValidation();
 
+	/** AI */
+	void OnNextOpponentTokenFound(QuartoTokenData const& token);
+	void OnNextMoveFound(QuartoBoardSlotCoordinates const& moveCoordinates);
+	void CancelAiSearches();
+
+	/** Game Records */
+	void RecordLastPlacement();
+	void FinishGameRecord(quarto::GameResult result);
+
 	/** Player Input */
 	void HandlePlayerSelectInput();
 	void SetCameraMovementEnabled();
@@ -146,6 +186,11 @@ private:
 	EQuartoPlayer m_players[QUARTO_NUM_OF_PLAYERS];
 	EQuartoPlayer m_currentPlayer;
 	ai::mcts::MonteCarloTreeSearch* m_mctsAi;
+	ai::mcts::SearchHandle<QuartoTokenData> m_opponentTokenSearch;
+	ai::mcts::SearchHandle<QuartoBoardSlotCoordinates> m_moveSearch;
+	quarto::GameRecordWriter* m_gameRecordWriter;
+	quarto::GameRecord m_gameRecord;
+	quarto::Board m_gameRecordBoard;
 	
 #ifdef DEBUG_BUILD
 	EQuartoGameState m_oldGameState;
@@ -0,0 +1,253 @@
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/Common/BitUtils.h"
+
+using namespace quarto;
+
+SlotIndex const Board::s_lines[NumLines][4] =
+{
+	//vertical
+	{0,4,8,12},
+	{1,5,9,13},
+	{2,6,10,14},
+	{3,7,11,15},
+
+	//horizontal
+	{0,1,2,3},
+	{4,5,6,7},
+	{8,9,10,11},
+	{12,13,14,15},
+
+	//diagonal
+	{0,5,10,15},
+	{12,9,6,3}
+};
+
+namespace
+{
+	// Bit i is set if line i of Board::s_lines goes through the slot
+	struct SlotLinesTable
+	{
+		SlotLinesTable()
+		{
+			for (brU8 line = 0; line < Board::NumLines; ++line)
+			{
+				for (SlotIndex slot : Board::s_lines[line])
+				{
+					LinesMask[slot] |= static_cast<brU16>(1u << line);
+				}
+			}
+		}
+
+		brU16 LinesMask[QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+	};
+
+	SlotLinesTable const s_slotLines;
+
+	// Tokens which keep at least one attribute a line shares, indexed by the shared attributes of the line (see Board::m_lineSharedAttributes)
+	struct CompletingTokensTable
+	{
+		CompletingTokensTable()
+		{
+			for (brU32 shared = 0; shared < 256; ++shared)
+			{
+				for (TokenId token = 0; token < NumTokens; ++token)
+				{
+					if ((token & shared) | (~token & (shared >> 4) & TokenAttribute_All))
+					{
+						TokensMask[shared] |= static_cast<brU16>(1u << token);
+					}
+				}
+			}
+		}
+
+		brU16 TokensMask[256] = {};
+	};
+
+	CompletingTokensTable const s_completingTokens;
+}
+
+void Board::Reset()
+{
+	for (TokenId& token : m_slots)
+	{
+		token = InvalidToken;
+	}
+	m_emptySlotsMask = 0xFFFF;
+	m_freeTokensMask = 0xFFFF;
+
+	for (brU8 line = 0; line < NumLines; ++line)
+	{
+		m_lineNumTokens[line] = 0;
+		m_lineSharedAttributes[line] = 0xFF;
+	}
+	m_threatLinesMask = 0;
+	m_winningLinesMask = 0;
+	m_completingTokensMask = 0;
+}
+
+void Board::SetTokenOnBoard(SlotIndex slot, TokenId token)
+{
+	if (slot >= QUARTO_BOARD_AVAILABLE_SLOTS || token >= NumTokens)
+	{
+		return;
+	}
+
+	if (!IsSlotEmpty(slot))
+	{
+		RemoveTokenFromBoard(slot);
+	}
+	m_slots[slot] = token;
+	m_emptySlotsMask &= ~static_cast<brU16>(1u << slot);
+	m_freeTokensMask &= ~static_cast<brU16>(1u << token);
+
+	//every attribute the token doesn't have (or has) is no longer shared by the lines through the slot
+	brU8 const tokenAttributes = static_cast<brU8>(token | (~token << 4));
+	brU16 const oldThreatLinesMask = m_threatLinesMask;
+	for (brU32 lines = s_slotLines.LinesMask[slot]; lines; lines &= lines - 1)
+	{
+		brU32 const line = GetIndexOfLowestSetBit(lines);
+		brU8 const numTokens = ++m_lineNumTokens[line];
+		brU8 const shared = m_lineSharedAttributes[line] &= tokenAttributes;
+		//a line through the slot only gains tokens: it becomes a threat with the third one and stops being one with the fourth
+		brU16 const lineBit = static_cast<brU16>(1u << line);
+		m_threatLinesMask = (m_threatLinesMask & ~lineBit) | (numTokens == 3 && shared ? lineBit : 0);
+		m_winningLinesMask |= numTokens == 4 && shared ? lineBit : 0;
+	}
+	if (m_threatLinesMask != oldThreatLinesMask)
+	{
+		UpdateCompletingTokens();
+	}
+}
+
+void Board::RemoveTokenFromBoard(SlotIndex slot)
+{
+	if (slot >= QUARTO_BOARD_AVAILABLE_SLOTS || IsSlotEmpty(slot))
+	{
+		return;
+	}
+
+	m_freeTokensMask |= static_cast<brU16>(1u << m_slots[slot]);
+	m_emptySlotsMask |= static_cast<brU16>(1u << slot);
+	m_slots[slot] = InvalidToken;
+
+	//the masks can't take a token back, the lines are recomputed from their slots
+	brU16 const oldThreatLinesMask = m_threatLinesMask;
+	for (brU32 lines = s_slotLines.LinesMask[slot]; lines; lines &= lines - 1)
+	{
+		brU32 const line = GetIndexOfLowestSetBit(lines);
+		brU8 numTokens = 0;
+		brU8 shared = 0xFF;
+		//without branches, an empty slot holds InvalidToken, which keeps every attribute
+		for (SlotIndex lineSlot : s_lines[line])
+		{
+			TokenId const token = m_slots[lineSlot];
+			numTokens += token != InvalidToken;
+			shared &= static_cast<brU8>(token | (~token << 4));
+		}
+		m_lineNumTokens[line] = numTokens;
+		m_lineSharedAttributes[line] = shared;
+
+		brU16 const lineBit = static_cast<brU16>(1u << line);
+		m_threatLinesMask = (m_threatLinesMask & ~lineBit) | (numTokens == 3 && shared ? lineBit : 0);
+		m_winningLinesMask &= ~lineBit;
+	}
+	if (m_threatLinesMask != oldThreatLinesMask)
+	{
+		UpdateCompletingTokens();
+	}
+}
+
+void Board::UpdateCompletingTokens()
+{
+	m_completingTokensMask = 0;
+	for (brU32 lines = m_threatLinesMask; lines; lines &= lines - 1)
+	{
+		m_completingTokensMask |= s_completingTokens.TokensMask[m_lineSharedAttributes[GetIndexOfLowestSetBit(lines)]];
+	}
+}
+
+brU32 Board::GetNumberOfFreeSlots() const
+{
+	return CountSetBits(m_emptySlotsMask);
+}
+
+brU32 Board::GetNumberOfFreeTokens() const
+{
+	return CountSetBits(m_freeTokensMask);
+}
+
+Board::GameStatus Board::GetStatus() const
+{
+	if (HasWinningLine())
+	{
+		return GameStatus::End;
+	}
+
+	//draw!
+	if (m_emptySlotsMask == 0 || m_freeTokensMask == 0)
+	{
+		return GameStatus::End;
+	}
+
+	return GameStatus::InProgress;
+}
+
+brBool Board::HasWinningLineThrough(SlotIndex slot) const
+{
+	return (m_winningLinesMask & s_slotLines.LinesMask[slot]) != 0;
+}
+
+brU32 Board::GetNumberOfThreatLines() const
+{
+	return CountSetBits(m_threatLinesMask);
+}
+
+brU16 Board::GetWinningSlotsMask(TokenId token) const
+{
+	brU16 slots = 0;
+	for (brU32 lines = m_threatLinesMask; lines; lines &= lines - 1)
+	{
+		brU32 const line = GetIndexOfLowestSetBit(lines);
+		if ((s_completingTokens.TokensMask[m_lineSharedAttributes[line]] >> token) & 1u)
+		{
+			for (SlotIndex lineSlot : s_lines[line])
+			{
+				slots |= m_emptySlotsMask & static_cast<brU16>(1u << lineSlot);
+			}
+		}
+	}
+	return slots;
+}
+
+brU16 Board::GetCompletingTokensMaskAfter(SlotIndex slot, TokenId token) const
+{
+	brU16 const slotLines = s_slotLines.LinesMask[slot];
+	brU16 tokens = 0;
+	//the threat lines through the slot are full afterwards, lines with two tokens become threats if the token keeps an attribute they share
+	for (brU32 lines = m_threatLinesMask & ~slotLines; lines; lines &= lines - 1)
+	{
+		brU32 const line = GetIndexOfLowestSetBit(lines);
+		tokens |= s_completingTokens.TokensMask[m_lineSharedAttributes[line]];
+	}
+	for (brU32 lines = slotLines; lines; lines &= lines - 1)
+	{
+		brU32 const line = GetIndexOfLowestSetBit(lines);
+		if (m_lineNumTokens[line] == 2)
+		{
+			tokens |= s_completingTokens.TokensMask[m_lineSharedAttributes[line] & static_cast<brU8>(token | (~token << 4))];
+		}
+	}
+	return tokens & m_freeTokensMask & ~static_cast<brU16>(1u << token);
+}
+
+bool Board::operator==(Board const& other) const
+{
+	for (brU8 i = 0; i < QUARTO_BOARD_AVAILABLE_SLOTS; ++i)
+	{
+		if (m_slots[i] != other.m_slots[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
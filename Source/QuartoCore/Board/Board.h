@@ -0,0 +1,97 @@
+#pragma once
+
+#include "QuartoCore/Common/Types.h"
+
+#define QUARTO_NUM_OF_PLAYERS 2
+#define QUARTO_BOARD_SIZE_X 4
+#define QUARTO_BOARD_SIZE_Y 4
+#define QUARTO_BOARD_AVAILABLE_SLOTS 16
+
+namespace quarto
+{
+	// Slots are numbered row by row: index = y * QUARTO_BOARD_SIZE_Y + x
+	using SlotIndex = brU8;
+	// Every bit of a token id is one of the four attributes of the token, see TokenAttribute
+	using TokenId = brU8;
+
+	constexpr SlotIndex InvalidSlot = 0xFF;
+	constexpr TokenId InvalidToken = 0xFF;
+	constexpr brU8 NumTokens = 16;
+
+	// Bit layout of a TokenId, a cleared bit stands for the opposite attribute (small, filled, quadratic, color 1)
+	enum TokenAttribute : brU8
+	{
+		TokenAttribute_Tall = 0x01,
+		TokenAttribute_Hole = 0x02,
+		TokenAttribute_Round = 0x04,
+		TokenAttribute_Color2 = 0x08,
+		TokenAttribute_All = 0x0F
+	};
+
+	// Engine independent board model, tokens and slots are plain indices and bitmasks
+	class QUARTOCORE_API Board
+	{
+	public:
+		enum class GameStatus : brU8
+		{
+			InProgress,
+			End
+		};
+
+		static constexpr brU8 NumLines = 10;
+
+		Board() { Reset(); }
+
+		void Reset();
+		void SetTokenOnBoard(SlotIndex slot, TokenId token);
+		void RemoveTokenFromBoard(SlotIndex slot);
+
+		TokenId GetToken(SlotIndex slot) const { return m_slots[slot]; }
+		brBool IsSlotEmpty(SlotIndex slot) const { return (m_emptySlotsMask >> slot) & 1u; }
+		brBool IsTokenFree(TokenId token) const { return (m_freeTokensMask >> token) & 1u; }
+		// Bit i is set if slot i is empty
+		brU16 GetEmptySlotsMask() const { return m_emptySlotsMask; }
+		// Bit i is set if token i is not on the board yet
+		brU16 GetFreeTokensMask() const { return m_freeTokensMask; }
+		brU32 GetNumberOfFreeSlots() const;
+		brU32 GetNumberOfFreeTokens() const;
+
+		GameStatus GetStatus() const;
+		brBool HasWinningLine() const { return m_winningLinesMask != 0; }
+		// Only checks the lines through the slot, enough to know if placing a token there has won the game
+		brBool HasWinningLineThrough(SlotIndex slot) const;
+		// Number of lines with three tokens sharing an attribute and one free slot -> one token away from a win
+		brU32 GetNumberOfThreatLines() const;
+
+		// Tactics, answered from the line state SetTokenOnBoard and RemoveTokenFromBoard keep up to date
+		// Bit i is set if free token i completes a line -> handing it over loses the game
+		brU16 GetCompletingTokensMask() const { return m_completingTokensMask & m_freeTokensMask; }
+		brBool IsTokenSafe(TokenId token) const { return IsTokenFree(token) && !((m_completingTokensMask >> token) & 1u); }
+		// Bit i is set if placing the token on slot i completes a line
+		brU16 GetWinningSlotsMask(TokenId token) const;
+		// Free tokens which complete a line once the token is placed on the slot, for a placement which doesn't complete one itself
+		brU16 GetCompletingTokensMaskAfter(SlotIndex slot, TokenId token) const;
+
+		bool operator==(Board const& other) const;
+
+		static SlotIndex const s_lines[NumLines][4];
+
+	private:
+		// Recomputes the tokens which complete a threat line, they only change with the set of threat lines
+		void UpdateCompletingTokens();
+
+		TokenId m_slots[QUARTO_BOARD_AVAILABLE_SLOTS];
+		brU16 m_emptySlotsMask;
+		brU16 m_freeTokensMask;
+
+		// Per line: number of tokens on it and the attributes they share, bits 0-3 the ones all of them have (AND of the token ids)
+		// and bits 4-7 the ones none of them has (NOR of the token ids), all bits set on an empty line
+		brU8 m_lineNumTokens[NumLines];
+		brU8 m_lineSharedAttributes[NumLines];
+		// Bit i is set if line i has three tokens sharing an attribute, four for a winning line
+		brU16 m_threatLinesMask;
+		brU16 m_winningLinesMask;
+		// Tokens which complete one of the threat lines, free or not
+		brU16 m_completingTokensMask;
+	};
+}
@@ -0,0 +1,165 @@
+#include "QuartoCore/Board/Symmetry.h"
+
+#include <algorithm>
+
+using namespace quarto;
+
+namespace
+{
+	constexpr brU8 s_numAttributePermutations = 24;
+	// Sorts after every token, so positions with the tokens on the first slots are the smallest
+	constexpr brU8 s_emptyKey = NumTokens;
+
+	// Rows and columns may be permuted by any permutation which commutes with the reversal (keeps the diagonals diagonal),
+	// the columns either like the rows or additionally reversed (swaps the diagonals), and the board may be transposed: 8 * 2 * 2
+	struct BoardSymmetriesTable
+	{
+		BoardSymmetriesTable()
+		{
+			brU8 permutation[4] = { 0, 1, 2, 3 };
+			brU8 numSymmetries = 0;
+			do
+			{
+				brBool const commutesWithReversal = std::all_of(permutation, permutation + 4, [&permutation](brU8 i) { return permutation[3 - i] == 3 - permutation[i]; });
+				if (!commutesWithReversal)
+				{
+					continue;
+				}
+				for (brU8 reverseColumns = 0; reverseColumns < 2; ++reverseColumns)
+				{
+					for (brU8 transpose = 0; transpose < 2; ++transpose)
+					{
+						SlotIndex* const slotMap = SlotMaps[numSymmetries++];
+						for (brU8 y = 0; y < QUARTO_BOARD_SIZE_Y; ++y)
+						{
+							for (brU8 x = 0; x < QUARTO_BOARD_SIZE_X; ++x)
+							{
+								brU8 const row = permutation[y];
+								brU8 const column = reverseColumns ? 3 - permutation[x] : permutation[x];
+								slotMap[y * QUARTO_BOARD_SIZE_X + x] = static_cast<SlotIndex>(transpose ? column * QUARTO_BOARD_SIZE_X + row : row * QUARTO_BOARD_SIZE_X + column);
+							}
+						}
+					}
+				}
+			} while (std::next_permutation(permutation, permutation + 4));
+		}
+
+		SlotIndex SlotMaps[Symmetry::NumBoardSymmetries][QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+	};
+
+	// Token ids with permuted attribute bits, for every permutation of the four attributes
+	struct AttributePermutationsTable
+	{
+		AttributePermutationsTable()
+		{
+			brU8 permutation[Symmetry::NumAttributes] = { 0, 1, 2, 3 };
+			brU8 index = 0;
+			do
+			{
+				std::copy(permutation, permutation + Symmetry::NumAttributes, AttributeMaps[index]);
+				for (TokenId token = 0; token < NumTokens; ++token)
+				{
+					TokenId permuted = 0;
+					for (brU8 bit = 0; bit < Symmetry::NumAttributes; ++bit)
+					{
+						permuted |= static_cast<TokenId>(((token >> bit) & 1u) << permutation[bit]);
+					}
+					Tokens[index][token] = permuted;
+				}
+				++index;
+			} while (std::next_permutation(permutation, permutation + Symmetry::NumAttributes));
+		}
+
+		brU8 AttributeMaps[s_numAttributePermutations][Symmetry::NumAttributes] = {};
+		TokenId Tokens[s_numAttributePermutations][NumTokens] = {};
+	};
+
+	BoardSymmetriesTable const s_boardSymmetries;
+	AttributePermutationsTable const s_attributePermutations;
+}
+
+TokenId Symmetry::TransformToken(TokenId token) const
+{
+	if (token == InvalidToken)
+	{
+		return InvalidToken;
+	}
+	TokenId transformed = 0;
+	for (brU8 bit = 0; bit < NumAttributes; ++bit)
+	{
+		transformed |= static_cast<TokenId>(((token >> bit) & 1u) << AttributeMap[bit]);
+	}
+	return transformed ^ TokenMask;
+}
+
+Board Symmetry::TransformBoard(Board const& board) const
+{
+	Board transformed;
+	for (SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+	{
+		if (!board.IsSlotEmpty(slot))
+		{
+			transformed.SetTokenOnBoard(SlotMap[slot], TransformToken(board.GetToken(slot)));
+		}
+	}
+	return transformed;
+}
+
+SlotIndex const (&Symmetry::GetBoardSymmetries())[NumBoardSymmetries][QUARTO_BOARD_AVAILABLE_SLOTS]
+{
+	return s_boardSymmetries.SlotMaps;
+}
+
+Symmetry quarto::FindCanonicalSymmetry(Board const& board, TokenId token)
+{
+	//the key of a candidate: the transformed slots in order, then the token
+	constexpr brU8 keySize = QUARTO_BOARD_AVAILABLE_SLOTS + 1;
+	brU8 bestKey[keySize];
+	std::fill(bestKey, bestKey + keySize, 0xFF);
+	brU8 bestBoardSymmetry = 0;
+	brU8 bestAttributePermutation = 0;
+	TokenId bestMask = 0;
+
+	for (brU8 boardSymmetry = 0; boardSymmetry < Symmetry::NumBoardSymmetries; ++boardSymmetry)
+	{
+		SlotIndex const* const slotMap = s_boardSymmetries.SlotMaps[boardSymmetry];
+		TokenId slots[QUARTO_BOARD_AVAILABLE_SLOTS];
+		std::fill(slots, slots + QUARTO_BOARD_AVAILABLE_SLOTS, InvalidToken);
+		for (SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+		{
+			if (!board.IsSlotEmpty(slot))
+			{
+				slots[slotMap[slot]] = board.GetToken(slot);
+			}
+		}
+		TokenId const* const firstToken = std::find_if(slots, slots + QUARTO_BOARD_AVAILABLE_SLOTS, [](TokenId slotToken) { return slotToken != InvalidToken; });
+
+		for (brU8 attributePermutation = 0; attributePermutation < s_numAttributePermutations; ++attributePermutation)
+		{
+			TokenId const* const permuted = s_attributePermutations.Tokens[attributePermutation];
+			//the smallest key of this board symmetry and permutation negates the first token to 0
+			TokenId const mask = firstToken != slots + QUARTO_BOARD_AVAILABLE_SLOTS ? permuted[*firstToken] : token != InvalidToken ? permuted[token] : 0;
+
+			brU8 key[keySize];
+			for (SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+			{
+				key[slot] = slots[slot] == InvalidToken ? s_emptyKey : permuted[slots[slot]] ^ mask;
+			}
+			key[QUARTO_BOARD_AVAILABLE_SLOTS] = token == InvalidToken ? s_emptyKey : permuted[token] ^ mask;
+
+			if (std::lexicographical_compare(key, key + keySize, bestKey, bestKey + keySize))
+			{
+				std::copy(key, key + keySize, bestKey);
+				bestBoardSymmetry = boardSymmetry;
+				bestAttributePermutation = attributePermutation;
+				bestMask = mask;
+			}
+		}
+	}
+
+	Symmetry symmetry;
+	std::copy(s_boardSymmetries.SlotMaps[bestBoardSymmetry], s_boardSymmetries.SlotMaps[bestBoardSymmetry] + QUARTO_BOARD_AVAILABLE_SLOTS, symmetry.SlotMap);
+	std::copy(s_attributePermutations.AttributeMaps[bestAttributePermutation], s_attributePermutations.AttributeMaps[bestAttributePermutation] + Symmetry::NumAttributes, symmetry.AttributeMap);
+	symmetry.TokenMask = bestMask;
+	return symmetry;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "QuartoCore/Board/Board.h"
+
+namespace quarto
+{
+	// Maps a position onto an equivalent one: the winning lines map onto winning lines and the shared attributes of tokens stay shared
+	// Combines one of the 32 slot permutations which keep the set of lines with a permutation and a negation of the token attributes
+	struct QUARTOCORE_API Symmetry
+	{
+		static constexpr brU8 NumBoardSymmetries = 32;
+		static constexpr brU8 NumAttributes = 4;
+
+		SlotIndex TransformSlot(SlotIndex slot) const { return slot == InvalidSlot ? InvalidSlot : SlotMap[slot]; }
+		// InvalidToken stays invalid
+		TokenId TransformToken(TokenId token) const;
+		Board TransformBoard(Board const& board) const;
+
+		// The slot permutations, the first one is the identity
+		static SlotIndex const (&GetBoardSymmetries())[NumBoardSymmetries][QUARTO_BOARD_AVAILABLE_SLOTS];
+
+		SlotIndex SlotMap[QUARTO_BOARD_AVAILABLE_SLOTS] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+		// Attribute bit i of a token becomes bit AttributeMap[i]
+		brU8 AttributeMap[NumAttributes] = { 0, 1, 2, 3 };
+		// Negated attributes, applied after the permutation
+		TokenId TokenMask = 0;
+	};
+
+	// Symmetry which maps the position onto its canonical form, the smallest of all equivalent positions (slots in order, empty after all tokens, then the token)
+	// Equivalent positions have the same canonical form. The token is the one to place, InvalidToken for a position in which a token is handed over.
+	QUARTOCORE_API Symmetry FindCanonicalSymmetry(Board const& board, TokenId token = InvalidToken);
+}
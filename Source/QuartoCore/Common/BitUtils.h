@@ -0,0 +1,54 @@
+#pragma once
+
+#include "QuartoCore/Common/Types.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace quarto
+{
+	inline brU32 CountSetBits(brU32 mask)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<brU32>(__builtin_popcount(mask));
+#else
+		brU32 count = 0;
+		for (; mask; mask &= mask - 1)
+		{
+			++count;
+		}
+		return count;
+#endif
+	}
+
+	// mask must not be 0
+	inline brU32 GetIndexOfLowestSetBit(brU32 mask)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return static_cast<brU32>(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+		unsigned long index = 0;
+		_BitScanForward(&index, mask);
+		return static_cast<brU32>(index);
+#else
+		brU32 index = 0;
+		while (!(mask & 1u))
+		{
+			mask >>= 1;
+			++index;
+		}
+		return index;
+#endif
+	}
+
+	// Index of the n-th (zero based) set bit, n has to be smaller than CountSetBits(mask)
+	inline brU32 GetIndexOfNthSetBit(brU32 mask, brU32 n)
+	{
+		for (; n > 0; --n)
+		{
+			mask &= mask - 1;
+		}
+		return GetIndexOfLowestSetBit(mask);
+	}
+}
@@ -0,0 +1,37 @@
+#include "QuartoCore/Common/Crc32.h"
+
+using namespace quarto;
+
+namespace
+{
+	struct Crc32Table
+	{
+		Crc32Table()
+		{
+			for (brU32 i = 0; i < 256; ++i)
+			{
+				brU32 crc = i;
+				for (brU32 bit = 0; bit < 8; ++bit)
+				{
+					crc = (crc >> 1) ^ ((crc & 1u) ? 0xEDB88320u : 0u);
+				}
+				Entries[i] = crc;
+			}
+		}
+
+		brU32 Entries[256];
+	};
+}
+
+brU32 quarto::ComputeCrc32(void const* data, size_t size, brU32 crc)
+{
+	static Crc32Table const s_table;
+
+	brU8 const* bytes = static_cast<brU8 const*>(data);
+	crc = ~crc;
+	for (size_t i = 0; i < size; ++i)
+	{
+		crc = s_table.Entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "QuartoCore/Common/Types.h"
+
+#include <cstddef>
+
+namespace quarto
+{
+	// CRC-32 (IEEE 802.3, as used by zlib), crc continues a previous checksum
+	QUARTOCORE_API brU32 ComputeCrc32(void const* data, size_t size, brU32 crc = 0);
+}
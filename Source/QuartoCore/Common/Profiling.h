@@ -0,0 +1,18 @@
+#pragma once
+
+// Profiling hooks of the core: the Unreal build maps them to the "Quarto" stat group (stat Quarto, Unreal Insights), elsewhere they compile to nothing
+#if defined(QUARTO_WITH_UNREAL_STATS) && QUARTO_WITH_UNREAL_STATS
+
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("Quarto"), STATGROUP_Quarto, STATCAT_Advanced);
+
+#ifndef QUARTO_SCOPE_CYCLE_COUNTER
+#define QUARTO_SCOPE_CYCLE_COUNTER(name) DECLARE_SCOPE_CYCLE_COUNTER(TEXT(#name), STAT_Quarto_##name, STATGROUP_Quarto)
+#endif
+
+#endif
+
+#ifndef QUARTO_SCOPE_CYCLE_COUNTER
+#define QUARTO_SCOPE_CYCLE_COUNTER(name)
+#endif
@@ -0,0 +1,55 @@
+#include "QuartoCore/Common/Random.h"
+
+#include <chrono>
+#include <random>
+
+using namespace quarto;
+
+namespace
+{
+	brU64 SplitMix64(brU64& state)
+	{
+		brU64 z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	brU32 RotateLeft(brU32 value, brU32 count)
+	{
+		return (value << count) | (value >> (32 - count));
+	}
+}
+
+void Random::Seed(brU64 seed)
+{
+	//splitmix makes sure that even seeds like 0 or 1 result in a well mixed state
+	brU64 const a = SplitMix64(seed);
+	brU64 const b = SplitMix64(seed);
+	m_state[0] = static_cast<brU32>(a);
+	m_state[1] = static_cast<brU32>(a >> 32);
+	m_state[2] = static_cast<brU32>(b);
+	m_state[3] = static_cast<brU32>(b >> 32);
+}
+
+brU32 Random::Next()
+{
+	brU32 const result = RotateLeft(m_state[1] * 5, 7) * 9;
+	brU32 const t = m_state[1] << 9;
+
+	m_state[2] ^= m_state[0];
+	m_state[3] ^= m_state[1];
+	m_state[1] ^= m_state[2];
+	m_state[0] ^= m_state[3];
+	m_state[2] ^= t;
+	m_state[3] = RotateLeft(m_state[3], 11);
+
+	return result;
+}
+
+brU64 Random::MakeNondeterministicSeed()
+{
+	std::random_device device;
+	brU64 const ticks = static_cast<brU64>(std::chrono::steady_clock::now().time_since_epoch().count());
+	return (static_cast<brU64>(device()) << 32) ^ device() ^ ticks;
+}
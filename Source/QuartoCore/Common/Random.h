@@ -0,0 +1,26 @@
+#pragma once
+
+#include "QuartoCore/Common/Types.h"
+
+namespace quarto
+{
+	// xoshiro128** - small, fast and good enough for playouts, every search owns its own generator
+	class QUARTOCORE_API Random
+	{
+	public:
+		explicit Random(brU64 seed) { Seed(seed); }
+
+		void Seed(brU64 seed);
+		brU32 Next();
+		// Uniformly distributed in [0, bound), bound must be > 0
+		brU32 NextBelow(brU32 bound) { return static_cast<brU32>((static_cast<brU64>(Next()) * bound) >> 32); }
+		// Uniformly distributed in [0, 1)
+		brFloat NextFloat() { return (Next() >> 8) * (1.f / 16777216.f); }
+
+		// Seed from the random device, for searches which don't have to be reproducible
+		static brU64 MakeNondeterministicSeed();
+
+	private:
+		brU32 m_state[4];
+	};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "QuartoCore/Common/Types.h"
+
+#include <atomic>
+
+namespace quarto
+{
+	// Lock-free bounded queue from one producer thread to one consumer thread
+	// Neither side ever waits: pushing into a full queue and popping from an empty one fail right away
+	template <typename T, brU32 Capacity>
+	class SpscQueue
+	{
+		static_assert((Capacity & (Capacity - 1)) == 0, "the capacity has to be a power of two");
+
+	public:
+		// Producer
+		brBool Push(T const& value)
+		{
+			brU32 const tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_cachedHead == Capacity)
+			{
+				//only reload the index of the other side when the cached one says the queue is full
+				m_cachedHead = m_head.load(std::memory_order_acquire);
+				if (tail - m_cachedHead == Capacity)
+				{
+					return false;
+				}
+			}
+			m_slots[tail & s_indexMask] = value;
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer
+		brBool Pop(T& value)
+		{
+			brU32 const head = m_head.load(std::memory_order_relaxed);
+			if (head == m_cachedTail)
+			{
+				m_cachedTail = m_tail.load(std::memory_order_acquire);
+				if (head == m_cachedTail)
+				{
+					return false;
+				}
+			}
+			value = m_slots[head & s_indexMask];
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		static constexpr brU32 s_indexMask = Capacity - 1;
+
+		T m_slots[Capacity] = {};
+		// The indices only ever grow and wrap around, both sides get their own cache line
+		alignas(64) std::atomic<brU32> m_head { 0 };
+		brU32 m_cachedTail = 0;
+		alignas(64) std::atomic<brU32> m_tail { 0 };
+		brU32 m_cachedHead = 0;
+	};
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "QuartoCore/Common/Types.h"
+
+#include <atomic>
+
+namespace quarto
+{
+	// Lock-free hand over of the latest value from one producer thread to one consumer thread
+	// Neither side ever waits: the producer always has a buffer to write to and the consumer keeps reading its buffer until a newer one was published
+	template <typename T>
+	class TripleBuffer
+	{
+	public:
+		// Producer: fill the write buffer, then publish it
+		T& GetWriteBuffer() { return m_buffers[m_writeIndex]; }
+		void Publish()
+		{
+			m_writeIndex = m_middleIndex.exchange(m_writeIndex | s_dirtyBit, std::memory_order_acq_rel) & s_indexMask;
+		}
+
+		// Consumer: swaps in the latest published buffer, returns false if nothing was published since the last call
+		brBool Update()
+		{
+			if ((m_middleIndex.load(std::memory_order_relaxed) & s_dirtyBit) == 0)
+			{
+				return false;
+			}
+			m_readIndex = m_middleIndex.exchange(m_readIndex, std::memory_order_acq_rel) & s_indexMask;
+			return true;
+		}
+		T const& GetReadBuffer() const { return m_buffers[m_readIndex]; }
+
+	private:
+		static constexpr brU8 s_indexMask = 0x3;
+		static constexpr brU8 s_dirtyBit = 0x4;
+
+		T m_buffers[3] = {};
+		brU8 m_writeIndex = 0;
+		std::atomic<brU8> m_middleIndex { 1 };
+		brU8 m_readIndex = 2;
+	};
+}
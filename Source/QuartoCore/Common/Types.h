@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+
+// Engine independent on purpose: the Quarto core is built by the Unreal Build Tool as the QuartoCore module and by CMake as a plain library
+#ifndef QUARTOCORE_API
+#define QUARTOCORE_API
+#endif
+
+using brBool = bool;
+
+using brFloat = float;
+using brDouble = double;
+
+using brU64 = std::uint64_t;
+using brU32 = std::uint32_t;
+using brU16 = std::uint16_t;
+using brU8 = std::uint8_t;
+
+using brS64 = std::int64_t;
+using brS32 = std::int32_t;
+using brS16 = std::int16_t;
+using brS8 = std::int8_t;
+
+using PlayerId = brU32;
+
+#define brFloatMax FLT_MAX
+#define brFloatMin FLT_MIN
@@ -0,0 +1,201 @@
+#include "QuartoCore/Eval/NTupleNetwork.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace ai::eval;
+
+quarto::SlotIndex const NTupleState::s_tuples[NumTuples][TupleSize] =
+{
+	//vertical
+	{0,4,8,12},
+	{1,5,9,13},
+	{2,6,10,14},
+	{3,7,11,15},
+
+	//horizontal
+	{0,1,2,3},
+	{4,5,6,7},
+	{8,9,10,11},
+	{12,13,14,15},
+
+	//diagonal
+	{0,5,10,15},
+	{12,9,6,3},
+
+	//squares
+	{0,1,4,5},
+	{1,2,5,6},
+	{2,3,6,7},
+	{4,5,8,9},
+	{5,6,9,10},
+	{6,7,10,11},
+	{8,9,12,13},
+	{9,10,13,14},
+	{10,11,14,15}
+};
+
+namespace
+{
+	constexpr brU8 s_fileMagic[4] = { 'Q', 'N', 'T', 'N' };
+	constexpr brU8 s_maxTuplesPerSlot = 7;
+
+	// The tuples through every slot and what a token on the slot adds to their index
+	struct SlotTuplesTable
+	{
+		SlotTuplesTable()
+		{
+			for (brU8 tuple = 0; tuple < NTupleState::NumTuples; ++tuple)
+			{
+				brU32 weight = 1;
+				for (quarto::SlotIndex slot : NTupleState::s_tuples[tuple])
+				{
+					brU8& count = NumTuples[slot];
+					Tuples[slot][count] = tuple;
+					IndexWeights[slot][count] = weight;
+					++count;
+					weight *= NTupleState::NumSlotStates;
+				}
+			}
+		}
+
+		brU8 NumTuples[QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+		brU8 Tuples[QUARTO_BOARD_AVAILABLE_SLOTS][s_maxTuplesPerSlot] = {};
+		brU32 IndexWeights[QUARTO_BOARD_AVAILABLE_SLOTS][s_maxTuplesPerSlot] = {};
+	};
+
+	SlotTuplesTable const s_slotTuples;
+
+	void WriteU32(std::FILE* file, brU32 value)
+	{
+		brU8 const bytes[4] = { static_cast<brU8>(value), static_cast<brU8>(value >> 8), static_cast<brU8>(value >> 16), static_cast<brU8>(value >> 24) };
+		std::fwrite(bytes, 1, sizeof(bytes), file);
+	}
+
+	brBool ReadU32(std::FILE* file, brU32& value)
+	{
+		brU8 bytes[4];
+		if (std::fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes))
+		{
+			return false;
+		}
+		value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<brU32>(bytes[3]) << 24);
+		return true;
+	}
+}
+
+void NTupleState::Reset()
+{
+	for (brU32& index : m_indices)
+	{
+		index = 0;
+	}
+}
+
+void NTupleState::Reset(quarto::Board const& board)
+{
+	Reset();
+	for (quarto::SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+	{
+		if (!board.IsSlotEmpty(slot))
+		{
+			SetToken(slot, board.GetToken(slot));
+		}
+	}
+}
+
+void NTupleState::SetToken(quarto::SlotIndex slot, quarto::TokenId token)
+{
+	brU32 const state = token + 1u;
+	for (brU8 i = 0; i < s_slotTuples.NumTuples[slot]; ++i)
+	{
+		m_indices[s_slotTuples.Tuples[slot][i]] += state * s_slotTuples.IndexWeights[slot][i];
+	}
+}
+
+void NTupleState::RemoveToken(quarto::SlotIndex slot, quarto::TokenId token)
+{
+	brU32 const state = token + 1u;
+	for (brU8 i = 0; i < s_slotTuples.NumTuples[slot]; ++i)
+	{
+		m_indices[s_slotTuples.Tuples[slot][i]] -= state * s_slotTuples.IndexWeights[slot][i];
+	}
+}
+
+NTupleNetwork::NTupleNetwork()
+	: m_weights(static_cast<size_t>(NTupleState::NumTuples) * NTupleState::NumTupleIndices, 0.f)
+{
+}
+
+brFloat NTupleNetwork::Evaluate(NTupleState const& state) const
+{
+	brFloat sum = 0.f;
+	for (brU8 tuple = 0; tuple < NTupleState::NumTuples; ++tuple)
+	{
+		sum += m_weights[tuple * NTupleState::NumTupleIndices + state.GetIndex(tuple)];
+	}
+	return 1.f / (1.f + std::exp(-sum));
+}
+
+void NTupleNetwork::Train(NTupleState const& state, brFloat target, brFloat learningRate)
+{
+	brFloat const delta = learningRate * (target - Evaluate(state));
+	for (brU8 tuple = 0; tuple < NTupleState::NumTuples; ++tuple)
+	{
+		m_weights[tuple * NTupleState::NumTupleIndices + state.GetIndex(tuple)] += delta;
+	}
+}
+
+brBool NTupleNetwork::Save(std::string const& path) const
+{
+	std::FILE* const file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	brU8 const header[8] = { s_fileMagic[0], s_fileMagic[1], s_fileMagic[2], s_fileMagic[3], FormatVersion, 0, 0, 0 };
+	std::fwrite(header, 1, sizeof(header), file);
+	WriteU32(file, NTupleState::NumTuples);
+	WriteU32(file, NTupleState::NumTupleIndices);
+	for (brFloat weight : m_weights)
+	{
+		brU32 bits;
+		std::memcpy(&bits, &weight, sizeof(bits));
+		WriteU32(file, bits);
+	}
+	return std::fclose(file) == 0;
+}
+
+brBool NTupleNetwork::Load(std::string const& path)
+{
+	std::FILE* const file = std::fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	brU8 header[8];
+	brU32 numTuples = 0;
+	brU32 numTupleIndices = 0;
+	brBool isValid = std::fread(header, 1, sizeof(header), file) == sizeof(header)
+		&& std::memcmp(header, s_fileMagic, sizeof(s_fileMagic)) == 0 && header[4] == FormatVersion
+		&& ReadU32(file, numTuples) && numTuples == NTupleState::NumTuples
+		&& ReadU32(file, numTupleIndices) && numTupleIndices == NTupleState::NumTupleIndices;
+
+	std::vector<brFloat> weights(m_weights.size());
+	for (size_t i = 0; isValid && i < weights.size(); ++i)
+	{
+		brU32 bits = 0;
+		isValid = ReadU32(file, bits);
+		std::memcpy(&weights[i], &bits, sizeof(bits));
+	}
+	std::fclose(file);
+
+	if (isValid)
+	{
+		m_weights.swap(weights);
+	}
+	return isValid;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "QuartoCore/Board/Board.h"
+
+#include <string>
+#include <vector>
+
+namespace ai
+{
+	namespace eval
+	{
+		// Indices of the tuples into their weight tables for one board, kept up to date placement by placement
+		// A tuple is 4 slots (the 10 lines and the 9 2x2 squares), its index packs the contents of its slots: empty = 0, token + 1
+		class QUARTOCORE_API NTupleState
+		{
+		public:
+			static constexpr brU8 NumTuples = 19;
+			static constexpr brU8 TupleSize = 4;
+			static constexpr brU32 NumSlotStates = quarto::NumTokens + 1;
+			static constexpr brU32 NumTupleIndices = NumSlotStates * NumSlotStates * NumSlotStates * NumSlotStates;
+
+			NTupleState() { Reset(); }
+			explicit NTupleState(quarto::Board const& board) { Reset(board); }
+
+			// Empty board
+			void Reset();
+			void Reset(quarto::Board const& board);
+			// Mirror Board::SetTokenOnBoard and Board::RemoveTokenFromBoard, a few additions per placement
+			void SetToken(quarto::SlotIndex slot, quarto::TokenId token);
+			void RemoveToken(quarto::SlotIndex slot, quarto::TokenId token);
+
+			brU32 GetIndex(brU8 tuple) const { return m_indices[tuple]; }
+
+			static quarto::SlotIndex const s_tuples[NumTuples][TupleSize];
+
+		private:
+			brU32 m_indices[NumTuples];
+		};
+
+		// Value function of a board: one weight per tuple and content of its slots, summed up and squashed into a chance to win
+		// The value is seen from the player who placed the last token, before that player hands over the next one
+		// Trained by temporal difference learning from self-play (Tools/QuartoTrain), the search can use it to cut its playouts short
+		class QUARTOCORE_API NTupleNetwork
+		{
+		public:
+			static constexpr brU8 FormatVersion = 1;
+
+			NTupleNetwork();
+
+			// Chance that the player who placed the last token wins, costs one lookup per tuple
+			brFloat Evaluate(NTupleState const& state) const;
+			// Moves the value of the state towards the target, gradient step of the cross entropy of the squashed sum
+			void Train(NTupleState const& state, brFloat target, brFloat learningRate);
+
+			// File: "QNTN", u8 version, 3 reserved bytes, u32 number of tuples, u32 indices per tuple, then all weights as little endian floats
+			brBool Save(std::string const& path) const;
+			// False if the file can't be read or doesn't match this network, the weights are unchanged then
+			brBool Load(std::string const& path);
+
+		private:
+			std::vector<brFloat> m_weights;
+		};
+	}
+}
@@ -0,0 +1,497 @@
+#include "QuartoCore/Eval/PolicyValueNetwork.h"
+#include "QuartoCore/Common/BitUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace ai::eval;
+
+namespace
+{
+	constexpr brU8 s_fileMagic[4] = { 'Q', 'P', 'V', 'N' };
+
+	//quantization: the hidden layer runs in 16 bit with 1.0 = 127, so the clipped activation fits into 8 bit
+	//with at most NumInputs active inputs of at most 254 the sums can't overflow 16 bit
+	constexpr brFloat s_hiddenScale = 127.f;
+	constexpr brS32 s_maxActivation = 127;
+	constexpr brFloat s_maxInputWeight = 254.f / s_hiddenScale;
+	//the output weights run in 8 bit with 1.0 = 64, two products of 8 bit activations and weights still fit into 16 bit (AVX2 maddubs)
+	constexpr brFloat s_outputScale = 64.f;
+	constexpr brFloat s_maxOutputWeight = 127.f / s_outputScale;
+
+	constexpr brU32 s_valueOutput = 0;
+	constexpr brU32 s_firstSlotOutput = 1;
+	constexpr brU32 s_firstTokenOutput = 1 + QUARTO_BOARD_AVAILABLE_SLOTS;
+
+	static_assert(PolicyValueNetwork::NumHidden % 32 == 0, "the AVX2 kernels process 32 hidden units at once");
+
+	constexpr brU32 s_numAttributes = 4;
+
+	// Active inputs of the token on the given slot, the slot after the board stands for the token in hand
+	// A cleared attribute bit is an attribute of its own (small, filled, ...), so both get a plane and a line of either kind looks the same
+	brU32 AddTokenFeatures(brU32 slot, quarto::TokenId token, brU32* features)
+	{
+		brU32 const firstFeature = slot * PolicyValueNetwork::NumFeaturesPerSlot;
+		features[0] = firstFeature;
+		for (brU32 attribute = 0; attribute < s_numAttributes; ++attribute)
+		{
+			features[1 + attribute] = firstFeature + 1 + 2 * attribute + ((token >> attribute) & 1u);
+		}
+		return 1 + s_numAttributes;
+	}
+
+	brU32 GetFeatures(quarto::Board const& board, quarto::TokenId token, brU32 (&features)[PolicyValueNetwork::NumInputs])
+	{
+		brU32 numFeatures = 0;
+		for (brU32 occupiedSlots = ~board.GetEmptySlotsMask() & 0xFFFFu; occupiedSlots != 0; occupiedSlots &= occupiedSlots - 1)
+		{
+			quarto::SlotIndex const slot = static_cast<quarto::SlotIndex>(quarto::GetIndexOfLowestSetBit(occupiedSlots));
+			numFeatures += AddTokenFeatures(slot, board.GetToken(slot), features + numFeatures);
+		}
+		if (token != quarto::InvalidToken)
+		{
+			numFeatures += AddTokenFeatures(QUARTO_BOARD_AVAILABLE_SLOTS, token, features + numFeatures);
+		}
+		return numFeatures;
+	}
+
+	brFloat Sigmoid(brFloat x)
+	{
+		return 1.f / (1.f + std::exp(-x));
+	}
+
+	// Softmax over the logits of the set bits of the mask, the others get 0
+	void Softmax(brFloat const* logits, brU32 mask, brFloat (&probabilities)[16])
+	{
+		brFloat maxLogit = -brFloatMax;
+		for (brU32 i = 0; i < 16; ++i)
+		{
+			if ((mask >> i) & 1u)
+			{
+				maxLogit = std::max(maxLogit, logits[i]);
+			}
+		}
+		brFloat sum = 0.f;
+		for (brU32 i = 0; i < 16; ++i)
+		{
+			probabilities[i] = (mask >> i) & 1u ? std::exp(logits[i] - maxLogit) : 0.f;
+			sum += probabilities[i];
+		}
+		for (brFloat& probability : probabilities)
+		{
+			probability = sum > 0.f ? probability / sum : 0.f;
+		}
+	}
+
+	template<typename T>
+	T QuantizeWeight(brFloat value, brFloat scale, brFloat maxValue)
+	{
+		return static_cast<T>(std::lround(std::min(std::max(value * scale, -maxValue), maxValue)));
+	}
+
+	void WriteU32(std::FILE* file, brU32 value)
+	{
+		brU8 const bytes[4] = { static_cast<brU8>(value), static_cast<brU8>(value >> 8), static_cast<brU8>(value >> 16), static_cast<brU8>(value >> 24) };
+		std::fwrite(bytes, 1, sizeof(bytes), file);
+	}
+
+	brBool ReadU32(std::FILE* file, brU32& value)
+	{
+		brU8 bytes[4];
+		if (std::fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes))
+		{
+			return false;
+		}
+		value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<brU32>(bytes[3]) << 24);
+		return true;
+	}
+}
+
+PolicyValueNetwork::PolicyValueNetwork()
+	: m_inputWeights(NumInputs * NumHidden, 0.f)
+	, m_hiddenBiases(NumHidden, 0.f)
+	, m_outputWeights(NumOutputs * NumHidden, 0.f)
+	, m_outputBiases(NumOutputs, 0.f)
+{
+	Quantize();
+}
+
+void PolicyValueNetwork::Evaluate(quarto::Board const& board, quarto::TokenId token, PolicyValue& output) const
+{
+	alignas(32) brS16 accumulator[NumHidden];
+	AccumulateBoard(board, accumulator);
+	if (token != quarto::InvalidToken)
+	{
+		AccumulateToken(token, accumulator);
+	}
+	EvaluateAccumulator(accumulator, output);
+}
+
+brFloat PolicyValueNetwork::EvaluatePriors(quarto::Board const& board, quarto::TokenId token, brFloat (&priors)[NumPlacements]) const
+{
+	std::fill(std::begin(priors), std::end(priors), 0.f);
+
+	alignas(32) brS16 boardAccumulator[NumHidden];
+	AccumulateBoard(board, boardAccumulator);
+
+	brU32 const emptySlots = board.GetEmptySlotsMask();
+	PolicyValue output;
+	brFloat slotPriors[QUARTO_BOARD_AVAILABLE_SLOTS];
+	auto const addPlacements = [&](quarto::TokenId placedToken, brFloat tokenPrior)
+	{
+		alignas(32) brS16 accumulator[NumHidden];
+		std::copy(std::begin(boardAccumulator), std::end(boardAccumulator), accumulator);
+		AccumulateToken(placedToken, accumulator);
+		EvaluateAccumulator(accumulator, output);
+		Softmax(output.SlotLogits, emptySlots, slotPriors);
+		for (brU32 slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+		{
+			priors[(slot << 4) | placedToken] = tokenPrior * slotPriors[slot];
+		}
+		return output.Value;
+	};
+
+	if (token != quarto::InvalidToken)
+	{
+		return addPlacements(token, 1.f);
+	}
+
+	EvaluateAccumulator(boardAccumulator, output);
+	brFloat const value = output.Value;
+	brFloat tokenPriors[quarto::NumTokens];
+	Softmax(output.TokenLogits, board.GetFreeTokensMask(), tokenPriors);
+	for (brU32 freeTokens = board.GetFreeTokensMask(); freeTokens != 0; freeTokens &= freeTokens - 1)
+	{
+		quarto::TokenId const freeToken = static_cast<quarto::TokenId>(quarto::GetIndexOfLowestSetBit(freeTokens));
+		addPlacements(freeToken, tokenPriors[freeToken]);
+	}
+	return value;
+}
+
+void PolicyValueNetwork::EvaluateReference(quarto::Board const& board, quarto::TokenId token, PolicyValue& output) const
+{
+	brFloat hidden[NumHidden];
+	brFloat outputs[NumOutputs];
+	ForwardReference(board, token, hidden, outputs);
+	output.Value = Sigmoid(outputs[s_valueOutput]);
+	std::copy(outputs + s_firstSlotOutput, outputs + s_firstTokenOutput, output.SlotLogits);
+	std::copy(outputs + s_firstTokenOutput, outputs + NumOutputs, output.TokenLogits);
+}
+
+void PolicyValueNetwork::Randomize(quarto::Random& random)
+{
+	auto const uniform = [&random](brFloat range) { return (2.f * random.NextFloat() - 1.f) * range; };
+	for (brFloat& weight : m_inputWeights)
+	{
+		weight = uniform(0.1f);
+	}
+	//a small positive bias keeps the clipped units alive at the start
+	for (brFloat& bias : m_hiddenBiases)
+	{
+		bias = 0.1f;
+	}
+	for (brFloat& weight : m_outputWeights)
+	{
+		weight = uniform(0.1f);
+	}
+	std::fill(m_outputBiases.begin(), m_outputBiases.end(), 0.f);
+	Quantize();
+}
+
+brFloat PolicyValueNetwork::Train(quarto::Board const& board, quarto::TokenId token, brFloat valueTarget, brFloat const (&policyTarget)[QUARTO_BOARD_AVAILABLE_SLOTS], brFloat learningRate)
+{
+	brFloat hidden[NumHidden];
+	brFloat outputs[NumOutputs];
+	ForwardReference(board, token, hidden, outputs);
+
+	//gradients of the losses by the outputs: sigmoid and softmax with cross entropy both give prediction - target
+	brFloat outputGradients[NumOutputs] = {};
+	brFloat const value = Sigmoid(outputs[s_valueOutput]);
+	outputGradients[s_valueOutput] = value - valueTarget;
+	brFloat const clampedValue = std::min(std::max(value, 1e-6f), 1.f - 1e-6f);
+	brFloat loss = -(valueTarget * std::log(clampedValue) + (1.f - valueTarget) * std::log(1.f - clampedValue));
+
+	brBool const isPlacing = token != quarto::InvalidToken;
+	brU32 const firstPolicyOutput = isPlacing ? s_firstSlotOutput : s_firstTokenOutput;
+	brU32 const legalMask = isPlacing ? board.GetEmptySlotsMask() : board.GetFreeTokensMask();
+	brFloat probabilities[16];
+	Softmax(outputs + firstPolicyOutput, legalMask, probabilities);
+	for (brU32 i = 0; i < 16; ++i)
+	{
+		if ((legalMask >> i) & 1u)
+		{
+			outputGradients[firstPolicyOutput + i] = probabilities[i] - policyTarget[i];
+			loss -= policyTarget[i] > 0.f ? policyTarget[i] * std::log(std::max(probabilities[i], 1e-6f)) : 0.f;
+		}
+	}
+
+	brFloat hiddenGradients[NumHidden] = {};
+	for (brU32 output = 0; output < NumOutputs; ++output)
+	{
+		brFloat const gradient = outputGradients[output];
+		if (gradient == 0.f)
+		{
+			continue;
+		}
+		brFloat* const weights = &m_outputWeights[output * NumHidden];
+		for (brU32 unit = 0; unit < NumHidden; ++unit)
+		{
+			brFloat const activation = std::min(std::max(hidden[unit], 0.f), 1.f);
+			hiddenGradients[unit] += gradient * weights[unit];
+			weights[unit] = std::min(std::max(weights[unit] - learningRate * gradient * activation, -s_maxOutputWeight), s_maxOutputWeight);
+		}
+		m_outputBiases[output] -= learningRate * gradient;
+	}
+
+	//the clipped activation only passes the gradient on between 0 and 1
+	for (brU32 unit = 0; unit < NumHidden; ++unit)
+	{
+		hiddenGradients[unit] = hidden[unit] > 0.f && hidden[unit] < 1.f ? learningRate * hiddenGradients[unit] : 0.f;
+		m_hiddenBiases[unit] = std::min(std::max(m_hiddenBiases[unit] - hiddenGradients[unit], -s_maxInputWeight), s_maxInputWeight);
+	}
+	brU32 features[NumInputs];
+	brU32 const numFeatures = GetFeatures(board, token, features);
+	for (brU32 i = 0; i < numFeatures; ++i)
+	{
+		brFloat* const weights = &m_inputWeights[features[i] * NumHidden];
+		for (brU32 unit = 0; unit < NumHidden; ++unit)
+		{
+			weights[unit] = std::min(std::max(weights[unit] - hiddenGradients[unit], -s_maxInputWeight), s_maxInputWeight);
+		}
+	}
+	return loss;
+}
+
+void PolicyValueNetwork::Quantize()
+{
+	for (brU32 input = 0; input < NumInputs; ++input)
+	{
+		for (brU32 unit = 0; unit < NumHidden; ++unit)
+		{
+			m_quantizedInputWeights[input][unit] = QuantizeWeight<brS16>(m_inputWeights[input * NumHidden + unit], s_hiddenScale, 254.f);
+		}
+	}
+	for (brU32 unit = 0; unit < NumHidden; ++unit)
+	{
+		m_quantizedHiddenBiases[unit] = QuantizeWeight<brS16>(m_hiddenBiases[unit], s_hiddenScale, 254.f);
+	}
+	for (brU32 output = 0; output < NumOutputs; ++output)
+	{
+		for (brU32 unit = 0; unit < NumHidden; ++unit)
+		{
+			m_quantizedOutputWeights[output][unit] = QuantizeWeight<brS8>(m_outputWeights[output * NumHidden + unit], s_outputScale, 127.f);
+		}
+		m_quantizedOutputBiases[output] = QuantizeWeight<brS32>(m_outputBiases[output], s_hiddenScale * s_outputScale, 1e9f);
+	}
+}
+
+brBool PolicyValueNetwork::Save(std::string const& path) const
+{
+	std::FILE* const file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	brU8 const header[8] = { s_fileMagic[0], s_fileMagic[1], s_fileMagic[2], s_fileMagic[3], FormatVersion, 0, 0, 0 };
+	std::fwrite(header, 1, sizeof(header), file);
+	WriteU32(file, NumInputs);
+	WriteU32(file, NumHidden);
+	WriteU32(file, NumOutputs);
+	for (std::vector<brFloat> const* weights : { &m_inputWeights, &m_hiddenBiases, &m_outputWeights, &m_outputBiases })
+	{
+		for (brFloat weight : *weights)
+		{
+			brU32 bits;
+			std::memcpy(&bits, &weight, sizeof(bits));
+			WriteU32(file, bits);
+		}
+	}
+	return std::fclose(file) == 0;
+}
+
+brBool PolicyValueNetwork::Load(std::string const& path)
+{
+	std::FILE* const file = std::fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	brU8 header[8];
+	brU32 numInputs = 0;
+	brU32 numHidden = 0;
+	brU32 numOutputs = 0;
+	brBool isValid = std::fread(header, 1, sizeof(header), file) == sizeof(header)
+		&& std::memcmp(header, s_fileMagic, sizeof(s_fileMagic)) == 0 && header[4] == FormatVersion
+		&& ReadU32(file, numInputs) && numInputs == NumInputs
+		&& ReadU32(file, numHidden) && numHidden == NumHidden
+		&& ReadU32(file, numOutputs) && numOutputs == NumOutputs;
+
+	std::vector<brFloat> inputWeights(m_inputWeights.size());
+	std::vector<brFloat> hiddenBiases(m_hiddenBiases.size());
+	std::vector<brFloat> outputWeights(m_outputWeights.size());
+	std::vector<brFloat> outputBiases(m_outputBiases.size());
+	for (std::vector<brFloat>* weights : { &inputWeights, &hiddenBiases, &outputWeights, &outputBiases })
+	{
+		for (size_t i = 0; isValid && i < weights->size(); ++i)
+		{
+			brU32 bits = 0;
+			isValid = ReadU32(file, bits);
+			std::memcpy(&(*weights)[i], &bits, sizeof(bits));
+		}
+	}
+	std::fclose(file);
+
+	if (isValid)
+	{
+		m_inputWeights.swap(inputWeights);
+		m_hiddenBiases.swap(hiddenBiases);
+		m_outputWeights.swap(outputWeights);
+		m_outputBiases.swap(outputBiases);
+		Quantize();
+	}
+	return isValid;
+}
+
+void PolicyValueNetwork::AccumulateBoard(quarto::Board const& board, brS16 (&accumulator)[NumHidden]) const
+{
+	brU32 features[NumInputs];
+	brU32 const numFeatures = GetFeatures(board, quarto::InvalidToken, features);
+	std::copy(std::begin(m_quantizedHiddenBiases), std::end(m_quantizedHiddenBiases), accumulator);
+#if defined(__AVX2__)
+	constexpr brU32 numRegisters = NumHidden / 16;
+	__m256i sums[numRegisters];
+	for (brU32 i = 0; i < numRegisters; ++i)
+	{
+		sums[i] = _mm256_load_si256(reinterpret_cast<__m256i const*>(accumulator) + i);
+	}
+	for (brU32 feature = 0; feature < numFeatures; ++feature)
+	{
+		__m256i const* const weights = reinterpret_cast<__m256i const*>(m_quantizedInputWeights[features[feature]]);
+		for (brU32 i = 0; i < numRegisters; ++i)
+		{
+			sums[i] = _mm256_add_epi16(sums[i], _mm256_load_si256(weights + i));
+		}
+	}
+	for (brU32 i = 0; i < numRegisters; ++i)
+	{
+		_mm256_store_si256(reinterpret_cast<__m256i*>(accumulator) + i, sums[i]);
+	}
+#else
+	for (brU32 feature = 0; feature < numFeatures; ++feature)
+	{
+		brS16 const* const weights = m_quantizedInputWeights[features[feature]];
+		for (brU32 unit = 0; unit < NumHidden; ++unit)
+		{
+			accumulator[unit] = static_cast<brS16>(accumulator[unit] + weights[unit]);
+		}
+	}
+#endif
+}
+
+void PolicyValueNetwork::AccumulateToken(quarto::TokenId token, brS16 (&accumulator)[NumHidden]) const
+{
+	brU32 features[NumFeaturesPerSlot];
+	brU32 const numFeatures = AddTokenFeatures(QUARTO_BOARD_AVAILABLE_SLOTS, token, features);
+	for (brU32 feature = 0; feature < numFeatures; ++feature)
+	{
+		brS16 const* const weights = m_quantizedInputWeights[features[feature]];
+		for (brU32 unit = 0; unit < NumHidden; ++unit)
+		{
+			accumulator[unit] = static_cast<brS16>(accumulator[unit] + weights[unit]);
+		}
+	}
+}
+
+void PolicyValueNetwork::EvaluateAccumulator(brS16 const (&accumulator)[NumHidden], PolicyValue& output) const
+{
+	brS32 sums[NumOutputs];
+#if defined(__AVX2__)
+	//clipped activations as 8 bit, packus works per 128 bit lane, the permutation puts the units back in order
+	constexpr brU32 numRegisters = NumHidden / 32;
+	__m256i activations[numRegisters];
+	__m256i const zero = _mm256_setzero_si256();
+	__m256i const maxActivation = _mm256_set1_epi16(s_maxActivation);
+	for (brU32 i = 0; i < numRegisters; ++i)
+	{
+		__m256i const low = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256(reinterpret_cast<__m256i const*>(accumulator) + 2 * i), zero), maxActivation);
+		__m256i const high = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256(reinterpret_cast<__m256i const*>(accumulator) + 2 * i + 1), zero), maxActivation);
+		activations[i] = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+	}
+
+	__m256i const ones = _mm256_set1_epi16(1);
+	for (brU32 output = 0; output < NumOutputs; ++output)
+	{
+		__m256i const* const weights = reinterpret_cast<__m256i const*>(m_quantizedOutputWeights[output]);
+		__m256i sum = zero;
+		for (brU32 i = 0; i < numRegisters; ++i)
+		{
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(activations[i], _mm256_load_si256(weights + i)), ones));
+		}
+		__m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+		sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+		sums[output] = m_quantizedOutputBiases[output] + _mm_cvtsi128_si32(sum128);
+	}
+#else
+	brU8 activations[NumHidden];
+	for (brU32 unit = 0; unit < NumHidden; ++unit)
+	{
+		activations[unit] = static_cast<brU8>(std::min<brS32>(std::max<brS32>(accumulator[unit], 0), s_maxActivation));
+	}
+	for (brU32 output = 0; output < NumOutputs; ++output)
+	{
+		brS8 const* const weights = m_quantizedOutputWeights[output];
+		brS32 sum = m_quantizedOutputBiases[output];
+		for (brU32 unit = 0; unit < NumHidden; ++unit)
+		{
+			sum += activations[unit] * weights[unit];
+		}
+		sums[output] = sum;
+	}
+#endif
+
+	brFloat const scale = 1.f / (s_hiddenScale * s_outputScale);
+	output.Value = Sigmoid(sums[s_valueOutput] * scale);
+	for (brU32 i = 0; i < QUARTO_BOARD_AVAILABLE_SLOTS; ++i)
+	{
+		output.SlotLogits[i] = sums[s_firstSlotOutput + i] * scale;
+	}
+	for (brU32 i = 0; i < quarto::NumTokens; ++i)
+	{
+		output.TokenLogits[i] = sums[s_firstTokenOutput + i] * scale;
+	}
+}
+
+void PolicyValueNetwork::ForwardReference(quarto::Board const& board, quarto::TokenId token, brFloat (&hidden)[NumHidden], brFloat (&outputs)[NumOutputs]) const
+{
+	brU32 features[NumInputs];
+	brU32 const numFeatures = GetFeatures(board, token, features);
+	std::copy(m_hiddenBiases.begin(), m_hiddenBiases.end(), hidden);
+	for (brU32 i = 0; i < numFeatures; ++i)
+	{
+		brFloat const* const weights = &m_inputWeights[features[i] * NumHidden];
+		for (brU32 unit = 0; unit < NumHidden; ++unit)
+		{
+			hidden[unit] += weights[unit];
+		}
+	}
+
+	for (brU32 output = 0; output < NumOutputs; ++output)
+	{
+		brFloat const* const weights = &m_outputWeights[output * NumHidden];
+		brFloat sum = m_outputBiases[output];
+		for (brU32 unit = 0; unit < NumHidden; ++unit)
+		{
+			sum += std::min(std::max(hidden[unit], 0.f), 1.f) * weights[unit];
+		}
+		outputs[output] = sum;
+	}
+}
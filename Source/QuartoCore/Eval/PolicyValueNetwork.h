@@ -0,0 +1,86 @@
+#pragma once
+
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/Common/Random.h"
+
+#include <string>
+#include <vector>
+
+namespace ai
+{
+	namespace eval
+	{
+		// Output of the network for one decision, seen from the deciding player
+		struct PolicyValue
+		{
+			// Chance of the deciding player to win
+			brFloat Value = 0.5f;
+			// Where to place the token in hand, only meaningful with a token in hand
+			brFloat SlotLogits[QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+			// Which token to hand over, only meaningful without a token in hand
+			brFloat TokenLogits[quarto::NumTokens] = {};
+		};
+
+		// Small MLP with a value and a policy head for the leaves of a PUCT search, evaluated on the CPU
+		// Inputs: per slot occupied and a plane per attribute and its opposite, the same for the token in hand. One hidden layer with clipped ReLU.
+		// The search runs on 16 bit input and 8 bit output weights, with AVX2 kernels when built with AVX2 (QUARTO_ENABLE_AVX2) and bit-identical scalar ones otherwise.
+		// The float weights are kept for the training (Tools/QuartoTrainNet) and the files, Quantize() derives the weights of the search from them.
+		class QUARTOCORE_API PolicyValueNetwork
+		{
+		public:
+			static constexpr brU8 FormatVersion = 1;
+			static constexpr brU32 NumFeaturesPerSlot = 9;
+			static constexpr brU32 NumInputs = (QUARTO_BOARD_AVAILABLE_SLOTS + 1) * NumFeaturesPerSlot;
+			static constexpr brU32 NumHidden = 128;
+			// value, slot logits, token logits
+			static constexpr brU32 NumOutputs = 1 + QUARTO_BOARD_AVAILABLE_SLOTS + quarto::NumTokens;
+			// Placements (slot, token), indexed like mcts::Action
+			static constexpr brU32 NumPlacements = QUARTO_BOARD_AVAILABLE_SLOTS * quarto::NumTokens;
+
+			// All weights zero: a value of 0.5 and uniform priors
+			PolicyValueNetwork();
+
+			// The decision of the position: where to place the token, InvalidToken for the token to hand over
+			void Evaluate(quarto::Board const& board, quarto::TokenId token, PolicyValue& output) const;
+			// Priors of the placements which can follow the position and its value for the deciding player
+			// With a token the prior of a placement is the one of its slot, without one it is the chance of handing over the token times the one of its slot then.
+			// The evaluations of all free tokens are one batch which shares the board part of the hidden layer.
+			brFloat EvaluatePriors(quarto::Board const& board, quarto::TokenId token, brFloat (&priors)[NumPlacements]) const;
+			// Same as Evaluate with the float weights, for the training and to check the quantized kernels
+			void EvaluateReference(quarto::Board const& board, quarto::TokenId token, PolicyValue& output) const;
+
+			// Small random weights to start a training from
+			void Randomize(quarto::Random& random);
+			// One gradient step of the float weights on a decision: cross entropy of the value and of the policy of the decision
+			// The policy target is a distribution over the slots with a token and over the tokens without one. Returns the loss before the step.
+			brFloat Train(quarto::Board const& board, quarto::TokenId token, brFloat valueTarget, brFloat const (&policyTarget)[QUARTO_BOARD_AVAILABLE_SLOTS], brFloat learningRate);
+			// Derives the weights of the search from the float weights, needed after training
+			void Quantize();
+
+			// File: "QPVN", u8 version, 3 reserved bytes, u32 inputs, u32 hidden, u32 outputs, then the float weights as little endian floats:
+			// input weights (hidden per input), hidden biases, output weights (hidden per output), output biases
+			brBool Save(std::string const& path) const;
+			// False if the file can't be read or doesn't match this network, the weights are unchanged then
+			brBool Load(std::string const& path);
+
+		private:
+			// Hidden layer of the board alone and of the board with a token in hand, before the activation
+			void AccumulateBoard(quarto::Board const& board, brS16 (&accumulator)[NumHidden]) const;
+			void AccumulateToken(quarto::TokenId token, brS16 (&accumulator)[NumHidden]) const;
+			void EvaluateAccumulator(brS16 const (&accumulator)[NumHidden], PolicyValue& output) const;
+			// Float hidden layer before the activation and the outputs, the policy logits are raw
+			void ForwardReference(quarto::Board const& board, quarto::TokenId token, brFloat (&hidden)[NumHidden], brFloat (&outputs)[NumOutputs]) const;
+
+			std::vector<brFloat> m_inputWeights;
+			std::vector<brFloat> m_hiddenBiases;
+			std::vector<brFloat> m_outputWeights;
+			std::vector<brFloat> m_outputBiases;
+
+			// 1.0 is 127 in the hidden layer, 64 in the output weights
+			alignas(32) brS16 m_quantizedInputWeights[NumInputs][NumHidden];
+			alignas(32) brS16 m_quantizedHiddenBiases[NumHidden];
+			alignas(32) brS8 m_quantizedOutputWeights[NumOutputs][NumHidden];
+			brS32 m_quantizedOutputBiases[NumOutputs];
+		};
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "QuartoCore/Board/Board.h"
+
+namespace ai
+{
+	namespace mcts
+	{
+		// A move is a (slot, token) placement: slot index in the high nibble, token id in the low nibble
+		// All 256 byte values are valid moves, so the invalid action lies outside of them
+		using Action = brU16;
+		constexpr Action InvalidAction = 0xFFFF;
+		constexpr brU32 NumActions = 256;
+
+		inline Action MakeAction(quarto::SlotIndex slot, quarto::TokenId token) { return static_cast<Action>((slot << 4) | token); }
+		inline quarto::SlotIndex GetActionSlot(Action action) { return static_cast<quarto::SlotIndex>(action >> 4); }
+		inline quarto::TokenId GetActionToken(Action action) { return static_cast<quarto::TokenId>(action & 0x0F); }
+	}
+}
@@ -0,0 +1,79 @@
+#include "QuartoCore/MCTS/SearchBudget.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace ai::mcts;
+
+SearchBudget::SearchBudget(SearchBudgetSettings const& settings)
+	: m_settings(settings)
+	, m_startTime(Clock::now())
+	, m_deadline(m_startTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<brDouble>(settings.MaxSeconds)))
+{
+	m_settings.DeadlineCheckInterval = std::max(m_settings.DeadlineCheckInterval, 1u);
+}
+
+brBool SearchBudget::IsExhausted()
+{
+	if ((m_settings.MaxIterations > 0 && m_numIterations >= m_settings.MaxIterations)
+		|| (m_settings.MaxPlayouts > 0 && m_numPlayouts >= m_settings.MaxPlayouts))
+	{
+		return true;
+	}
+
+	if (m_settings.MaxSeconds > 0.f && !m_isDeadlineReached && m_numIterations >= m_nextDeadlineCheck)
+	{
+		//the steady clock is monotonic and cheap, but still not for free
+		m_isDeadlineReached = Clock::now() >= m_deadline;
+		m_nextDeadlineCheck = m_numIterations + m_settings.DeadlineCheckInterval;
+	}
+	return m_isDeadlineReached;
+}
+
+void SearchBudget::SetDeadline(Clock::time_point deadline)
+{
+	m_deadline = deadline;
+	//a deadline before the start still needs a time limit > 0
+	m_settings.MaxSeconds = std::max(std::chrono::duration<brFloat>(deadline - m_startTime).count(), std::numeric_limits<brFloat>::min());
+	m_isDeadlineReached = false;
+	m_nextDeadlineCheck = m_numIterations;
+}
+
+void SearchBudget::AddNodes(brU32 numNodes, brU64 numBytes)
+{
+	m_numNodes += numNodes;
+	m_numTreeBytes += numBytes;
+	m_peakTreeBytes = std::max(m_peakTreeBytes, m_numTreeBytes);
+}
+
+brBool SearchBudget::IsTreeFull(brFloat fillRatio) const
+{
+	return (m_settings.MaxNodes > 0 && m_numNodes >= m_settings.MaxNodes * fillRatio)
+		|| (m_settings.MaxTreeBytes > 0 && m_numTreeBytes >= m_settings.MaxTreeBytes * fillRatio);
+}
+
+brDouble SearchBudget::GetElapsedSeconds() const
+{
+	return std::chrono::duration<brDouble>(Clock::now() - m_startTime).count();
+}
+
+brDouble SearchBudget::GetRemainingSeconds() const
+{
+	return m_settings.MaxSeconds > 0.f ? std::max(std::chrono::duration<brDouble>(m_deadline - Clock::now()).count(), 0.0) : 0.0;
+}
+
+brDouble SearchBudget::EstimateRemainingIterations() const
+{
+	brDouble remainingIterations = std::numeric_limits<brDouble>::max();
+	if (m_settings.MaxIterations > 0)
+	{
+		remainingIterations = std::min(remainingIterations, static_cast<brDouble>(m_settings.MaxIterations) - m_numIterations);
+	}
+	//the playout limit doesn't bound the iterations, iterations ending in a terminal node don't play out
+	if (m_settings.MaxSeconds > 0.f && m_numIterations > 0)
+	{
+		brDouble const elapsedSeconds = std::max(GetElapsedSeconds(), 1e-8);
+		remainingIterations = std::min(remainingIterations, m_numIterations / elapsedSeconds * GetRemainingSeconds());
+	}
+	return std::max(remainingIterations, 0.0);
+}
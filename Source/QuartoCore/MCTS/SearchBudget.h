@@ -0,0 +1,59 @@
+#pragma once
+
+#include "QuartoCore/MCTS/SearchSettings.h"
+
+#include <chrono>
+
+namespace ai
+{
+	namespace mcts
+	{
+		class QUARTOCORE_API SearchBudget
+		{
+		public:
+			using Clock = std::chrono::steady_clock;
+
+			explicit SearchBudget(SearchBudgetSettings const& settings);
+
+			// Cheap enough to be called every iteration
+			brBool IsExhausted();
+			// The tree may not grow any further, searching with deeper playouts is still possible
+			// fillRatio < 1 checks whether the tree uses more than this share of its limits
+			brBool IsTreeFull(brFloat fillRatio = 1.f) const;
+
+			void AddIteration() { ++m_numIterations; }
+			void AddPlayout() { ++m_numPlayouts; }
+			void AddNodes(brU32 numNodes, brU64 numBytes);
+			void RemoveNodes(brU32 numNodes, brU64 numBytes) { m_numNodes -= numNodes; m_numTreeBytes -= numBytes; }
+
+			brU32 GetNumIterations() const { return m_numIterations; }
+			brU32 GetNumPlayouts() const { return m_numPlayouts; }
+			brU32 GetNumNodes() const { return m_numNodes; }
+			brU64 GetNumTreeBytes() const { return m_numTreeBytes; }
+			brU64 GetPeakTreeBytes() const { return m_peakTreeBytes; }
+			brDouble GetElapsedSeconds() const;
+			// Only meaningful with a time limit
+			Clock::time_point GetDeadline() const { return m_deadline; }
+			// Replaces the time limit, the deadline is checked again right away
+			void SetDeadline(Clock::time_point deadline);
+			// Seconds left until the deadline, 0 without a time limit
+			brDouble GetRemainingSeconds() const;
+			// Upper bound of the iterations still to come, based on the limits and on the iteration rate so far
+			brDouble EstimateRemainingIterations() const;
+			brU32 GetDeadlineCheckInterval() const { return m_settings.DeadlineCheckInterval; }
+			SearchBudgetSettings const& GetSettings() const { return m_settings; }
+
+		private:
+			SearchBudgetSettings m_settings;
+			Clock::time_point m_startTime;
+			Clock::time_point m_deadline;
+			brU32 m_numIterations = 0;
+			brU32 m_numPlayouts = 0;
+			brU32 m_numNodes = 0;
+			brU64 m_numTreeBytes = 0;
+			brU64 m_peakTreeBytes = 0;
+			brU32 m_nextDeadlineCheck = 0;
+			brBool m_isDeadlineReached = false;
+		};
+	}
+}
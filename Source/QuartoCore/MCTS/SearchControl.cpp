@@ -0,0 +1,60 @@
+#include "QuartoCore/MCTS/SearchControl.h"
+
+using namespace ai::mcts;
+
+void SearchControl::SetDeadline(Clock::time_point deadline)
+{
+	std::lock_guard<std::mutex> lock(m_deadlineMutex);
+	m_hasDeadline = true;
+	m_deadline = deadline;
+	m_pendingExtension = Clock::duration::zero();
+	m_deadlineVersion.fetch_add(1, std::memory_order_release);
+}
+
+void SearchControl::ExtendDeadline(Clock::duration extension)
+{
+	std::lock_guard<std::mutex> lock(m_deadlineMutex);
+	if (m_hasDeadline)
+	{
+		m_deadline += extension;
+	}
+	else
+	{
+		m_pendingExtension += extension;
+	}
+	m_deadlineVersion.fetch_add(1, std::memory_order_release);
+}
+
+void SearchControl::SetDeadlineFromNow(brDouble seconds)
+{
+	SetDeadline(Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<brDouble>(seconds)));
+}
+
+void SearchControl::ExtendDeadline(brDouble seconds)
+{
+	ExtendDeadline(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<brDouble>(seconds)));
+}
+
+SearchControl::Clock::time_point SearchControl::GetDeadline() const
+{
+	std::lock_guard<std::mutex> lock(m_deadlineMutex);
+	return m_hasDeadline ? m_deadline : Clock::time_point::max();
+}
+
+void SearchControl::BeginSearch(SearchBudget const& budget)
+{
+	std::lock_guard<std::mutex> lock(m_deadlineMutex);
+	if (!m_hasDeadline && budget.GetSettings().MaxSeconds > 0.f)
+	{
+		m_hasDeadline = true;
+		m_deadline = budget.GetDeadline() + m_pendingExtension;
+	}
+	m_pendingExtension = Clock::duration::zero();
+	m_deadlineVersion.fetch_add(1, std::memory_order_release);
+}
+
+void SearchControl::PublishProgress(Action bestAction, brU32 numIterations)
+{
+	m_bestAction.store(bestAction, std::memory_order_relaxed);
+	m_numIterations.store(numIterations, std::memory_order_relaxed);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "QuartoCore/MCTS/Action.h"
+#include "QuartoCore/MCTS/SearchBudget.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace ai
+{
+	namespace mcts
+	{
+		// Remote control of a search, shared between the searching threads and any thread controlling the search
+		// Every method is thread-safe and can be called before the search starts, while it runs and after it finished
+		class QUARTOCORE_API SearchControl
+		{
+		public:
+			using Clock = SearchBudget::Clock;
+
+			// Ends the search as soon as possible, it still returns its best decision so far (after at least one iteration)
+			void Stop() { m_isStopRequested.store(true, std::memory_order_relaxed); }
+			brBool IsStopRequested() const { return m_isStopRequested.load(std::memory_order_relaxed); }
+
+			// Replaces the time limit of the budget, the search ends at the deadline however long it is already running
+			void SetDeadline(Clock::time_point deadline);
+			// Moves the deadline, a negative extension pulls it in. A search without any time limit keeps running without one.
+			void ExtendDeadline(Clock::duration extension);
+			void SetDeadlineFromNow(brDouble seconds);
+			void ExtendDeadline(brDouble seconds);
+			// Clock::time_point::max() without a time limit
+			Clock::time_point GetDeadline() const;
+
+			// Most visited root child of the running search, refreshed every SearchBudgetSettings::DeadlineCheckInterval iterations
+			// A root parallel search reports the tree of its calling thread
+			Action GetBestActionSoFar() const { return m_bestAction.load(std::memory_order_relaxed); }
+			brU32 GetNumIterationsSoFar() const { return m_numIterations.load(std::memory_order_relaxed); }
+
+			// Search side: takes over the time limit of the budget unless a deadline was set already
+			void BeginSearch(SearchBudget const& budget);
+			// Search side: the deadline changes whenever the version does
+			brU32 GetDeadlineVersion() const { return m_deadlineVersion.load(std::memory_order_acquire); }
+			void PublishProgress(Action bestAction, brU32 numIterations);
+
+		private:
+			std::atomic<brBool> m_isStopRequested { false };
+			std::atomic<Action> m_bestAction { InvalidAction };
+			std::atomic<brU32> m_numIterations { 0 };
+			std::atomic<brU32> m_deadlineVersion { 0 };
+
+			mutable std::mutex m_deadlineMutex;
+			brBool m_hasDeadline = false;
+			Clock::time_point m_deadline;
+			// Extensions before the search took over the time limit of its budget
+			Clock::duration m_pendingExtension = Clock::duration::zero();
+		};
+	}
+}
@@ -0,0 +1,87 @@
+#include "QuartoCore/MCTS/SearchOptions.h"
+
+#include "QuartoCore/Eval/NTupleNetwork.h"
+#include "QuartoCore/Eval/PolicyValueNetwork.h"
+
+#include <cstdlib>
+
+using namespace ai::mcts;
+
+namespace
+{
+	void SetBudget(SearchSettings& settings, void (*apply)(SearchBudgetSettings&, brDouble), brDouble value)
+	{
+		apply(settings.MoveSearchBudget, value);
+		apply(settings.OpponentTokenSearchBudget, value);
+	}
+
+	brBool ParseNumber(std::string const& text, brDouble& value)
+	{
+		char* end = nullptr;
+		value = std::strtod(text.c_str(), &end);
+		return !text.empty() && *end == '\0';
+	}
+}
+
+char const* ai::mcts::GetSearchOptionKeys()
+{
+	return "seconds iterations playouts nodes memory threads exploration rave rave-k widening widening-c widening-alpha "
+		"early recycling tactics deterministic seed ntuple cutoff network puct priors";
+}
+
+SearchOptionStatus ai::mcts::SetSearchOption(SearchSettings& settings, std::string const& key, std::string const& value)
+{
+	//the weights of the evaluators are files, every other option is a number
+	if (key == "ntuple")
+	{
+		std::shared_ptr<ai::eval::NTupleNetwork> network = std::make_shared<ai::eval::NTupleNetwork>();
+		if (!network->Load(value))
+		{
+			return SearchOptionStatus::InvalidValue;
+		}
+		settings.PlayoutEvaluator = std::move(network);
+		return SearchOptionStatus::Ok;
+	}
+	if (key == "network")
+	{
+		std::shared_ptr<ai::eval::PolicyValueNetwork> network = std::make_shared<ai::eval::PolicyValueNetwork>();
+		if (!network->Load(value))
+		{
+			return SearchOptionStatus::InvalidValue;
+		}
+		settings.LeafEvaluator = std::move(network);
+		return SearchOptionStatus::Ok;
+	}
+
+	brDouble number = 0.0;
+	brBool const isNumber = ParseNumber(value, number);
+	SearchSettings parsed = settings;
+	if (key == "seconds") SetBudget(parsed, [](SearchBudgetSettings& b, brDouble v) { b.MaxSeconds = static_cast<brFloat>(v); }, number);
+	else if (key == "iterations") SetBudget(parsed, [](SearchBudgetSettings& b, brDouble v) { b.MaxIterations = static_cast<brU32>(v); }, number);
+	else if (key == "playouts") SetBudget(parsed, [](SearchBudgetSettings& b, brDouble v) { b.MaxPlayouts = static_cast<brU32>(v); }, number);
+	else if (key == "nodes") SetBudget(parsed, [](SearchBudgetSettings& b, brDouble v) { b.MaxNodes = static_cast<brU32>(v); }, number);
+	else if (key == "memory") SetBudget(parsed, [](SearchBudgetSettings& b, brDouble v) { b.MaxTreeBytes = static_cast<brU64>(v * 1024 * 1024); }, number);
+	else if (key == "threads") parsed.NumThreads = static_cast<brU32>(number);
+	else if (key == "exploration") parsed.ExplorationParameter = static_cast<brFloat>(number);
+	else if (key == "rave") parsed.UseRave = number != 0.0;
+	else if (key == "rave-k") parsed.RaveEquivalenceParameter = static_cast<brFloat>(number);
+	else if (key == "widening") parsed.UseProgressiveWidening = number != 0.0;
+	else if (key == "widening-c") parsed.ProgressiveWideningCoefficient = static_cast<brFloat>(number);
+	else if (key == "widening-alpha") parsed.ProgressiveWideningExponent = static_cast<brFloat>(number);
+	else if (key == "early") parsed.UseEarlyTermination = number != 0.0;
+	else if (key == "recycling") parsed.UseNodeRecycling = number != 0.0;
+	else if (key == "tactics") parsed.UseTacticalFilter = number != 0.0;
+	else if (key == "deterministic") parsed.UseDeterministicSearch = number != 0.0;
+	else if (key == "seed") parsed.RandomSeed = static_cast<brU64>(number);
+	else if (key == "cutoff") parsed.PlayoutCutoffPlacements = static_cast<brU32>(number);
+	else if (key == "puct") parsed.PuctExplorationParameter = static_cast<brFloat>(number);
+	else if (key == "priors") parsed.UsePuct = number != 0.0;
+	else return SearchOptionStatus::UnknownKey;
+
+	if (!isNumber)
+	{
+		return SearchOptionStatus::InvalidValue;
+	}
+	settings = parsed;
+	return SearchOptionStatus::Ok;
+}
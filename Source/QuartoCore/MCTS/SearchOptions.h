@@ -0,0 +1,27 @@
+#pragma once
+
+#include "QuartoCore/MCTS/SearchSettings.h"
+
+#include <string>
+
+namespace ai
+{
+	namespace mcts
+	{
+		enum class SearchOptionStatus : brU8
+		{
+			Ok,
+			UnknownKey,
+			// Not a number, or weights which can't be loaded
+			InvalidValue
+		};
+
+		// Keys of SetSearchOption separated by spaces, for usage texts and option lists
+		QUARTOCORE_API char const* GetSearchOptionKeys();
+
+		// Applies one option of the search by its key, shared by the QuartoArena configs and the QuartoEngine setoption command
+		// The value is a number, for ntuple and network the path of the weights which are loaded right away
+		// The settings are unchanged unless Ok is returned
+		QUARTOCORE_API SearchOptionStatus SetSearchOption(SearchSettings& settings, std::string const& key, std::string const& value);
+	}
+}
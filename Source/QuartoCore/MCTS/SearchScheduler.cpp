@@ -0,0 +1,153 @@
+#include "QuartoCore/MCTS/SearchScheduler.h"
+#include "QuartoCore/Common/Profiling.h"
+
+#include <algorithm>
+
+using namespace ai::mcts;
+
+SearchScheduler::SearchScheduler(brU32 numWorkers, brDouble sliceSeconds)
+	: m_sliceDuration(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<brDouble>(std::max(sliceSeconds, 0.0001))))
+	, m_urgencyWindow(m_sliceDuration * 4)
+{
+	if (numWorkers == 0)
+	{
+		numWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	for (brU32 i = 0; i < numWorkers; ++i)
+	{
+		m_workers.emplace_back(&SearchScheduler::RunWorker, this);
+	}
+}
+
+SearchScheduler::~SearchScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isShuttingDown = true;
+		for (std::unique_ptr<Job> const& job : m_jobs)
+		{
+			job->Control->Stop();
+		}
+	}
+	m_wakeUp.notify_all();
+
+	//the workers finish every search before they quit, stopped searches only run one more iteration
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void SearchScheduler::Submit(SearchSettings const& settings, SearchRequest const& request, std::shared_ptr<SearchControl> control, brU32 priority,
+	OnSearchFinished onFinished, SearchSnapshotBuffer* snapshots)
+{
+	std::unique_ptr<Job> job = std::make_unique<Job>();
+	job->Control = control ? std::move(control) : std::make_shared<SearchControl>();
+	job->Task = std::make_unique<SearchTask>(settings, request, 0, job->Control.get(), true, snapshots);
+	job->OnFinished = std::move(onFinished);
+	job->Weight = 1.0 / std::max(priority, 1u);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_isShuttingDown)
+		{
+			job->Control->Stop();
+		}
+		job->VirtualTime = m_virtualTime;
+		m_jobs.push_back(std::move(job));
+		++m_numWaitingJobs;
+	}
+	m_wakeUp.notify_one();
+}
+
+brU32 SearchScheduler::GetNumPendingSearches() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return static_cast<brU32>(m_jobs.size());
+}
+
+SearchScheduler& SearchScheduler::Get()
+{
+	static SearchScheduler s_scheduler;
+	return s_scheduler;
+}
+
+void SearchScheduler::RunWorker()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_wakeUp.wait(lock, [this]() { return m_numWaitingJobs > 0 || m_isShuttingDown; });
+		if (m_numWaitingJobs == 0)
+		{
+			//shutting down, running jobs are finished by their own workers
+			break;
+		}
+
+		Job* const job = PickNextJob();
+		job->IsRunning = true;
+		--m_numWaitingJobs;
+		m_virtualTime = job->VirtualTime;
+		lock.unlock();
+
+		Clock::time_point const sliceStart = Clock::now();
+		brBool const isFinished = job->Task->RunSlice(m_sliceDuration);
+		brDouble const sliceSeconds = std::chrono::duration<brDouble>(Clock::now() - sliceStart).count();
+
+		lock.lock();
+		if (!isFinished)
+		{
+			job->IsRunning = false;
+			job->VirtualTime += sliceSeconds * job->Weight;
+			++m_numWaitingJobs;
+			continue;
+		}
+
+		//out of the list before the callback, so whoever reacts to it doesn't count the search as pending anymore
+		std::unique_ptr<Job> const finishedJob = TakeJob(job);
+		lock.unlock();
+		{
+			QUARTO_SCOPE_CYCLE_COUNTER(MCTS_FinishScheduledSearch);
+			finishedJob->OnFinished(finishedJob->Task->Finish());
+		}
+		lock.lock();
+	}
+}
+
+SearchScheduler::Job* SearchScheduler::PickNextJob()
+{
+	Clock::time_point const now = Clock::now();
+	Job* mostUrgentJob = nullptr;
+	Clock::time_point earliestDeadline = Clock::time_point::max();
+	Job* fairestJob = nullptr;
+	for (std::unique_ptr<Job> const& job : m_jobs)
+	{
+		if (job->IsRunning)
+		{
+			continue;
+		}
+
+		//a search close to its deadline can't wait for its fair share
+		Clock::time_point const deadline = job->Control->GetDeadline();
+		if (deadline != Clock::time_point::max() && deadline - now < m_urgencyWindow && deadline < earliestDeadline)
+		{
+			earliestDeadline = deadline;
+			mostUrgentJob = job.get();
+		}
+		if (!fairestJob || job->VirtualTime < fairestJob->VirtualTime)
+		{
+			fairestJob = job.get();
+		}
+	}
+	return mostUrgentJob ? mostUrgentJob : fairestJob;
+}
+
+std::unique_ptr<SearchScheduler::Job> SearchScheduler::TakeJob(Job* job)
+{
+	auto const it = std::find_if(m_jobs.begin(), m_jobs.end(), [job](std::unique_ptr<Job> const& other) { return other.get() == job; });
+	std::unique_ptr<Job> takenJob = std::move(*it);
+	*it = std::move(m_jobs.back());
+	m_jobs.pop_back();
+	return takenJob;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "QuartoCore/MCTS/SearchTask.h"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ai
+{
+	namespace mcts
+	{
+		// Fixed pool of worker threads shared by the searches of any number of games
+		// The searches are time-sliced: a worker runs a search for one slice and then picks the next one, so many concurrent searches share the cores fairly
+		// A search whose deadline is within a few slices goes first (earliest deadline first), all others get cpu time in proportion to their priority
+		// Every search is a single tree (SearchSettings::NumThreads is ignored), the throughput scales with the number of concurrent searches instead
+		class QUARTOCORE_API SearchScheduler
+		{
+		public:
+			using Clock = SearchBudget::Clock;
+			using OnSearchFinished = std::function<void(SearchResult const& result)>;
+
+			// 0 workers = one per hardware thread
+			explicit SearchScheduler(brU32 numWorkers = 0, brDouble sliceSeconds = 0.002);
+			// Stops all searches, their callbacks still get the best decision so far
+			~SearchScheduler();
+			SearchScheduler(SearchScheduler const&) = delete;
+			SearchScheduler& operator=(SearchScheduler const&) = delete;
+
+			// The budget counts from now on. The control may be null, otherwise it stays usable while the search is waiting for a worker.
+			// A search with priority 2 gets twice the cpu time of one with priority 1 (0 counts as 1)
+			// onFinished runs on a worker thread, it must not block
+			void Submit(SearchSettings const& settings, SearchRequest const& request, std::shared_ptr<SearchControl> control, brU32 priority,
+				OnSearchFinished onFinished, SearchSnapshotBuffer* snapshots = nullptr);
+
+			brU32 GetNumWorkers() const { return static_cast<brU32>(m_workers.size()); }
+			// Running and waiting searches
+			brU32 GetNumPendingSearches() const;
+
+			// Process wide scheduler with one worker per hardware thread, created on first use
+			static SearchScheduler& Get();
+
+		private:
+			struct Job
+			{
+				std::unique_ptr<SearchTask> Task;
+				std::shared_ptr<SearchControl> Control;
+				OnSearchFinished OnFinished;
+				brDouble Weight = 1.0;
+				// Cpu seconds received, divided by the priority. The waiting job with the least virtual time is next.
+				brDouble VirtualTime = 0.0;
+				brBool IsRunning = false;
+			};
+
+			void RunWorker();
+			// Next waiting job, requires m_mutex
+			Job* PickNextJob();
+			// Removes the job from the list, requires m_mutex
+			std::unique_ptr<Job> TakeJob(Job* job);
+
+		private:
+			Clock::duration m_sliceDuration;
+			// Searches with a deadline closer than this are urgent
+			Clock::duration m_urgencyWindow;
+			std::vector<std::thread> m_workers;
+
+			mutable std::mutex m_mutex;
+			std::condition_variable m_wakeUp;
+			std::vector<std::unique_ptr<Job>> m_jobs;
+			brU32 m_numWaitingJobs = 0;
+			// Virtual time of the last picked job, new jobs start there instead of starving all others
+			brDouble m_virtualTime = 0.0;
+			brBool m_isShuttingDown = false;
+		};
+	}
+}
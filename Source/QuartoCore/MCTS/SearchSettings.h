@@ -0,0 +1,95 @@
+#pragma once
+
+#include "QuartoCore/Common/Types.h"
+
+#include <memory>
+
+namespace ai
+{
+	namespace eval
+	{
+		class NTupleNetwork;
+		class PolicyValueNetwork;
+	}
+
+	namespace mcts
+	{
+		// Limits of a single search request, every limit is optional (0 = unlimited)
+		// Without any limit the search only ends when it is stopped from the outside
+		struct SearchBudgetSettings
+		{
+			brFloat MaxSeconds = 0.f;
+			brU32 MaxIterations = 0;
+			brU32 MaxPlayouts = 0;
+			brU32 MaxNodes = 0;
+			brU64 MaxTreeBytes = 0;
+
+			// The clock is only read every n iterations
+			brU32 DeadlineCheckInterval = 32;
+		};
+
+		struct SearchSettings
+		{
+			SearchBudgetSettings MoveSearchBudget;
+			SearchBudgetSettings OpponentTokenSearchBudget;
+
+			// UCB1 exploration constant
+			brFloat ExplorationParameter = 1.41f; // sqrt(2)
+
+			// All-Moves-As-First statistics, blended into the UCT value with beta = sqrt(k / (3n + k))
+			brBool UseRave = true;
+			// k of the RAVE schedule -> number of visits at which UCT and RAVE values are weighted equally
+			brFloat RaveEquivalenceParameter = 1000.f;
+
+			// Progressive widening: a node only considers its ceil(C * (n + 1)^alpha) most promising children, ordered by a cheap heuristic
+			brBool UseProgressiveWidening = true;
+			brFloat ProgressiveWideningCoefficient = 2.f; // C
+			brFloat ProgressiveWideningExponent = 0.5f; // alpha
+
+			// Learned value of a board which cuts the random playouts short: after the given number of random placements the winner is drawn by its estimate
+			// Shared and never changed by the searches, null plays every playout to its end
+			std::shared_ptr<eval::NTupleNetwork const> PlayoutEvaluator;
+			brU32 PlayoutCutoffPlacements = 4;
+
+			// AlphaZero style search: the leaves are valued by the network instead of a playout and their children are selected by PUCT with its priors,
+			// Q + c * P * sqrt(N) / (1 + n). All children are added at once (no progressive widening) and RAVE isn't used then.
+			// Shared and never changed by the searches, null searches with playouts and UCT
+			std::shared_ptr<eval::PolicyValueNetwork const> LeafEvaluator;
+			brFloat PuctExplorationParameter = 2.5f; // c
+
+			// PUCT selection without a network: the priors of the children come from a cheap tactical heuristic (don't hand over a token
+			// which completes a line, take the win, keep safe tokens to hand over), the leaves are still valued by playouts.
+			// All children are added at once and RAVE isn't used, like with the leaf evaluator, whose priors take precedence.
+			brBool UsePuct = false;
+
+			// Expansion skips the children a player who sees one move ahead wouldn't choose: with a token which completes a line only the winning
+			// placements are left, tokens which complete a line are only handed over if every token does and placements after which
+			// every token left completes a line are dropped if the token has another slot. Computed from the shared attributes of the lines.
+			brBool UseTacticalFilter = true;
+
+			// Stops a search as soon as its decision is fixed: the root is solved or the most visited child can't be overtaken within the remaining budget
+			brBool UseEarlyTermination = true;
+
+			// Once the tree hits the node or memory limit of its budget, the least visited leaves are pruned and their nodes recycled
+			// until the tree is back at the given share of its limits. Without recycling the tree just stops growing.
+			brBool UseNodeRecycling = true;
+			brFloat NodeRecyclingTargetRatio = 0.9f;
+
+			// Root parallelization: every thread searches its own tree, the root statistics are merged for the decision
+			// The time limit is shared, the iteration, playout and tree limits of the budget are split between the threads
+			// Searches of the SearchScheduler always use a single tree, the scheduler runs many searches in parallel instead
+			brU32 NumThreads = 1;
+
+			// Reproducible searches: seeded random numbers and no wall clock, the same request always results in the same trees and decision
+			// Time limits are ignored, so the budget needs an iteration or playout limit. Thread i of a parallel search uses RandomSeed + i.
+			brBool UseDeterministicSearch = false;
+			brU64 RandomSeed = 0;
+
+			// Time spent in the single phases of an iteration for SearchStats, costs a few clock reads per iteration
+			brBool MeasurePhaseTimes = true;
+
+			// Iterations between two SearchSnapshots of a watched search
+			brU32 SnapshotInterval = 256;
+		};
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "QuartoCore/Common/TripleBuffer.h"
+#include "QuartoCore/MCTS/Action.h"
+
+namespace ai
+{
+	namespace mcts
+	{
+		// State of a running search for live inspection, published every SearchSettings::SnapshotInterval iterations and once more when the search is finished
+		// Root parallel searches publish the tree of the calling thread while running and the merged trees at the end
+		struct SearchSnapshot
+		{
+			brBool IsValid = false;
+			brBool IsFinished = false;
+			brBool IsOpponentTokenSearch = false;
+			quarto::Board Board;
+			quarto::TokenId Token = quarto::InvalidToken;
+
+			brU32 NumThreads = 1;
+			brU32 NumIterations = 0;
+			brU32 NumPlayouts = 0;
+			brU32 NumNodes = 0;
+			brU64 PeakTreeBytes = 0;
+			brDouble ElapsedSeconds = 0.0;
+			// Time limit of the budget, 0 = none
+			brDouble MaxSeconds = 0.0;
+
+			// Root children summed up by the slot and by the token they play, win rates of the deciding player
+			brU32 SlotVisits[QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+			brFloat SlotWinRates[QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+			brU32 TokenVisits[quarto::NumTokens] = {};
+			brFloat TokenWinRates[quarto::NumTokens] = {};
+
+			Action BestAction = InvalidAction;
+			brFloat EstimatedWinRate = 0.f;
+		};
+
+		using SearchSnapshotBuffer = quarto::TripleBuffer<SearchSnapshot>;
+	}
+}
@@ -0,0 +1,22 @@
+#include "QuartoCore/MCTS/SearchStats.h"
+
+#include <cstdio>
+
+using namespace ai::mcts;
+
+std::string SearchStats::ToString() const
+{
+	char buffer[512];
+	std::snprintf(buffer, sizeof(buffer),
+		"%u iterations, %u playouts, %u nodes (%u pruned, %.1f KB peak), depth %u, %.1f ms (select %.1f, expand %.1f, simulate %.1f, backpropagate %.1f), %zu root children, win rate %.1f%%",
+		NumIterations, NumPlayouts, NumNodesAllocated, NumNodesPruned, PeakTreeBytes / 1024.0, MaxDepth,
+		1000.0 * TotalSeconds, 1000.0 * SelectSeconds, 1000.0 * ExpandSeconds, 1000.0 * SimulateSeconds, 1000.0 * BackPropagateSeconds,
+		RootChildren.size(), 100.0 * EstimatedWinRate);
+
+	std::string result = buffer;
+	if (NumThreads > 1)
+	{
+		result += ", " + std::to_string(NumThreads) + " threads";
+	}
+	return result;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "QuartoCore/MCTS/Action.h"
+
+#include <string>
+#include <vector>
+
+namespace ai
+{
+	namespace mcts
+	{
+		struct RootChildStats
+		{
+			Action PlayedAction = InvalidAction;
+			brU32 VisitCount = 0;
+			// Share of the visits won by the deciding player
+			brFloat WinRate = 0.f;
+		};
+
+		// Work done for a single decision, summed up over all threads of a parallel search
+		struct SearchStats
+		{
+			// Single line summary for logs
+			QUARTOCORE_API std::string ToString() const;
+
+			brU32 NumThreads = 1;
+			brU32 NumIterations = 0;
+			brU32 NumPlayouts = 0;
+			// Every node ever added to the tree, including the ones recycled later on
+			brU32 NumNodesAllocated = 0;
+			brU32 NumNodesPruned = 0;
+			brU64 PeakTreeBytes = 0;
+			brU32 MaxDepth = 0;
+
+			// Only measured with SearchSettings::MeasurePhaseTimes
+			brDouble SelectSeconds = 0.0;
+			brDouble ExpandSeconds = 0.0;
+			brDouble SimulateSeconds = 0.0;
+			brDouble BackPropagateSeconds = 0.0;
+			// Wall clock time of the whole search
+			brDouble TotalSeconds = 0.0;
+
+			// Most visited first
+			std::vector<RootChildStats> RootChildren;
+			// Chance to win of the deciding player, judged by the chosen root child
+			brFloat EstimatedWinRate = 0.f;
+		};
+	}
+}
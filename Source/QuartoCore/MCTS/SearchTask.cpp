@@ -0,0 +1,154 @@
+#include "QuartoCore/MCTS/SearchTask.h"
+
+#include <algorithm>
+
+using namespace ai::mcts;
+
+namespace
+{
+	brU64 GetTreeSeed(SearchSettings const& settings, brU32 treeIndex)
+	{
+		return settings.UseDeterministicSearch ? settings.RandomSeed + treeIndex : quarto::Random::MakeNondeterministicSeed();
+	}
+}
+
+SearchTask::SearchTask(SearchSettings const& settings, SearchRequest const& request, brU32 treeIndex, SearchControl* control, brBool isPrimary, SearchSnapshotBuffer* snapshots)
+	: m_tree(settings, request, GetTreeSeed(settings, treeIndex))
+	, m_control(control)
+	, m_snapshots(isPrimary ? snapshots : nullptr)
+	, m_isPrimary(isPrimary)
+	, m_checkInterval(m_tree.GetBudget().GetDeadlineCheckInterval())
+	, m_snapshotInterval(std::max(settings.SnapshotInterval, 1u))
+	, m_iterationsUntilCheck(m_checkInterval)
+	, m_iterationsUntilSnapshot(m_snapshotInterval)
+{
+	if (m_control)
+	{
+		if (m_isPrimary)
+		{
+			m_control->BeginSearch(m_tree.GetBudget());
+		}
+		ApplyDeadline();
+	}
+}
+
+brBool SearchTask::RunSlice(Clock::duration maxSliceDuration)
+{
+	Clock::time_point const sliceEnd = maxSliceDuration == Clock::duration::max() ? Clock::time_point::max() : Clock::now() + maxSliceDuration;
+
+	//the first iteration always runs, so even a search which is stopped or out of time right away has a decision
+	while (!m_isFinished)
+	{
+		m_tree.Iterate();
+
+		brBool isSliceUsedUp = false;
+		if (--m_iterationsUntilCheck == 0)
+		{
+			m_iterationsUntilCheck = m_checkInterval;
+			if (m_control)
+			{
+				ApplyDeadline();
+				if (m_isPrimary)
+				{
+					m_control->PublishProgress(m_tree.GetBestAction(), m_tree.GetBudget().GetNumIterations());
+				}
+			}
+			isSliceUsedUp = sliceEnd != Clock::time_point::max() && Clock::now() >= sliceEnd;
+		}
+
+		if (m_snapshots && --m_iterationsUntilSnapshot == 0)
+		{
+			m_iterationsUntilSnapshot = m_snapshotInterval;
+			PublishSnapshot(m_tree.GetResult(), false);
+		}
+
+		m_isFinished = (m_control && m_control->IsStopRequested()) || m_tree.IsFinished();
+		if (isSliceUsedUp)
+		{
+			break;
+		}
+	}
+	return m_isFinished;
+}
+
+SearchResult SearchTask::Finish()
+{
+	SearchResult const result = m_tree.GetResult();
+	PublishResult(result);
+	return result;
+}
+
+void SearchTask::PublishResult(SearchResult const& result)
+{
+	if (!m_isPrimary)
+	{
+		return;
+	}
+
+	if (m_control)
+	{
+		m_control->PublishProgress(result.BestAction, result.Stats.NumIterations);
+	}
+	if (m_snapshots)
+	{
+		PublishSnapshot(result, true);
+	}
+}
+
+void SearchTask::ApplyDeadline()
+{
+	brU32 const version = m_control->GetDeadlineVersion();
+	if (version != m_deadlineVersion)
+	{
+		m_deadlineVersion = version;
+		SearchControl::Clock::time_point const deadline = m_control->GetDeadline();
+		if (deadline != SearchControl::Clock::time_point::max())
+		{
+			m_tree.GetBudget().SetDeadline(deadline);
+		}
+	}
+}
+
+void SearchTask::PublishSnapshot(SearchResult const& result, brBool isFinished)
+{
+	SearchRequest const& request = m_tree.GetRequest();
+	SearchStats const& stats = result.Stats;
+	SearchSnapshot& snapshot = m_snapshots->GetWriteBuffer();
+	snapshot = SearchSnapshot();
+	snapshot.IsValid = true;
+	snapshot.IsFinished = isFinished;
+	snapshot.IsOpponentTokenSearch = request.IsOpponentTokenSearch();
+	snapshot.Board = request.Board;
+	snapshot.Token = request.Token;
+	snapshot.NumThreads = stats.NumThreads;
+	snapshot.NumIterations = stats.NumIterations;
+	snapshot.NumPlayouts = stats.NumPlayouts;
+	snapshot.NumNodes = stats.NumNodesAllocated - stats.NumNodesPruned;
+	snapshot.PeakTreeBytes = stats.PeakTreeBytes;
+	snapshot.ElapsedSeconds = stats.TotalSeconds;
+	snapshot.MaxSeconds = m_tree.GetBudget().GetSettings().MaxSeconds;
+	snapshot.BestAction = result.BestAction;
+	snapshot.EstimatedWinRate = stats.EstimatedWinRate;
+
+	brFloat slotWins[QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+	brFloat tokenWins[quarto::NumTokens] = {};
+	for (RootChildStats const& child : stats.RootChildren)
+	{
+		quarto::SlotIndex const slot = GetActionSlot(child.PlayedAction);
+		quarto::TokenId const token = GetActionToken(child.PlayedAction);
+		snapshot.SlotVisits[slot] += child.VisitCount;
+		slotWins[slot] += child.VisitCount * child.WinRate;
+		snapshot.TokenVisits[token] += child.VisitCount;
+		tokenWins[token] += child.VisitCount * child.WinRate;
+	}
+	for (brU32 i = 0; i < QUARTO_BOARD_AVAILABLE_SLOTS; ++i)
+	{
+		snapshot.SlotWinRates[i] = snapshot.SlotVisits[i] > 0 ? slotWins[i] / snapshot.SlotVisits[i] : 0.f;
+	}
+	for (brU32 i = 0; i < quarto::NumTokens; ++i)
+	{
+		snapshot.TokenWinRates[i] = snapshot.TokenVisits[i] > 0 ? tokenWins[i] / snapshot.TokenVisits[i] : 0.f;
+	}
+
+	m_snapshots->Publish();
+}
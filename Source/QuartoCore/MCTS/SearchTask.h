@@ -0,0 +1,51 @@
+#pragma once
+
+#include "QuartoCore/MCTS/SearchTree.h"
+
+namespace ai
+{
+	namespace mcts
+	{
+		// A single tree of a search, which can be run in slices (by one thread at a time)
+		// The primary task of a search applies the deadline of its control and reports to it and to the snapshots, other tasks only follow the control
+		class QUARTOCORE_API SearchTask
+		{
+		public:
+			using Clock = SearchBudget::Clock;
+
+			// treeIndex picks the random seed of a deterministic search
+			SearchTask(SearchSettings const& settings, SearchRequest const& request, brU32 treeIndex, SearchControl* control, brBool isPrimary, SearchSnapshotBuffer* snapshots);
+			SearchTask(SearchTask const&) = delete;
+			SearchTask& operator=(SearchTask const&) = delete;
+
+			// Iterates until the search is finished or the slice is used up, returns whether the search is finished
+			// The slice is checked every SearchBudgetSettings::DeadlineCheckInterval iterations, the first slice always runs at least one iteration
+			brBool RunSlice(Clock::duration maxSliceDuration = Clock::duration::max());
+			brBool IsFinished() const { return m_isFinished; }
+
+			// Result of this tree, reported to the control and the snapshots by the primary task
+			SearchResult Finish();
+			// Reports a result of the whole search, e.g. the merged trees of a root parallel search
+			void PublishResult(SearchResult const& result);
+
+			SearchTree& GetTree() { return m_tree; }
+			SearchTree const& GetTree() const { return m_tree; }
+
+		private:
+			void ApplyDeadline();
+			void PublishSnapshot(SearchResult const& result, brBool isFinished);
+
+		private:
+			SearchTree m_tree;
+			SearchControl* m_control;
+			SearchSnapshotBuffer* m_snapshots;
+			brBool m_isPrimary;
+			brBool m_isFinished = false;
+			brU32 m_checkInterval;
+			brU32 m_snapshotInterval;
+			brU32 m_iterationsUntilCheck;
+			brU32 m_iterationsUntilSnapshot;
+			brU32 m_deadlineVersion = 0;
+		};
+	}
+}
@@ -0,0 +1,986 @@
+#include "QuartoCore/MCTS/SearchTree.h"
+#include "QuartoCore/MCTS/SearchTask.h"
+#include "QuartoCore/Common/BitUtils.h"
+#include "QuartoCore/Common/Profiling.h"
+#include "QuartoCore/Eval/NTupleNetwork.h"
+#include "QuartoCore/Eval/PolicyValueNetwork.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+using namespace ai::mcts;
+
+namespace
+{
+	void PlayActionOnBoard(quarto::Board& board, Action action)
+	{
+		board.SetTokenOnBoard(GetActionSlot(action), GetActionToken(action));
+	}
+
+	// The wall clock would make the budget depend on the machine and its load
+	SearchBudgetSettings GetTreeBudget(SearchSettings const& settings, SearchBudgetSettings budget)
+	{
+		if (settings.UseDeterministicSearch)
+		{
+			budget.MaxSeconds = 0.f;
+		}
+		return budget;
+	}
+
+	// The time is shared, work and memory are split so the search as a whole stays within the budget
+	SearchBudgetSettings SplitBudget(SearchBudgetSettings budget, brU32 numThreads)
+	{
+		auto const split = [numThreads](auto limit) { return limit > 0 ? std::max<decltype(limit)>((limit + numThreads - 1) / numThreads, 1) : 0; };
+		budget.MaxIterations = split(budget.MaxIterations);
+		budget.MaxPlayouts = split(budget.MaxPlayouts);
+		budget.MaxNodes = split(budget.MaxNodes);
+		budget.MaxTreeBytes = split(budget.MaxTreeBytes);
+		return budget;
+	}
+
+
+	constexpr brS32 s_winScore = 10;
+
+	// Weights of the heuristic priors (SearchSettings::UsePuct), relative to 1 for a quiet choice
+	constexpr brFloat s_winningPlacementWeight = 50.f;
+	constexpr brFloat s_losingChoiceWeight = 0.05f;
+
+	// Priors of the placements which can follow the position, factored like the ones of the policy network:
+	// the chance of handing over the token times the one of its slot then. Handing over a token which completes a line
+	// and placing a token so that every token left completes one are losing, placing a token which completes a line wins.
+	// Among the quiet placements the ones leaving more safe tokens to hand over are preferred.
+	void ComputeHeuristicPriors(quarto::Board const& board, quarto::TokenId givenToken, brFloat (&priors)[NumActions])
+	{
+		std::fill(std::begin(priors), std::end(priors), 0.f);
+
+		brU16 const emptySlots = board.GetEmptySlotsMask();
+		brU16 const freeTokens = board.GetFreeTokensMask();
+		brU16 const tokens = givenToken != quarto::InvalidToken ? static_cast<brU16>(1u << givenToken) : freeTokens;
+		brU32 const numEmptySlotsAfter = quarto::CountSetBits(emptySlots) - 1;
+		brFloat totalTokenWeight = 0.f;
+		for (brU32 tokensLeft = tokens; tokensLeft; tokensLeft &= tokensLeft - 1)
+		{
+			quarto::TokenId const token = static_cast<quarto::TokenId>(quarto::GetIndexOfLowestSetBit(tokensLeft));
+			brU16 const freeTokensAfter = freeTokens & ~(1u << token);
+			brU16 const winningSlots = board.GetWinningSlotsMask(token);
+			brFloat totalSlotWeight = 0.f;
+			for (brU32 slotsLeft = emptySlots; slotsLeft; slotsLeft &= slotsLeft - 1)
+			{
+				quarto::SlotIndex const slot = static_cast<quarto::SlotIndex>(quarto::GetIndexOfLowestSetBit(slotsLeft));
+				brFloat weight = 1.f;
+				if ((winningSlots >> slot) & 1u)
+				{
+					weight = s_winningPlacementWeight;
+				}
+				else if (freeTokensAfter && numEmptySlotsAfter > 0)
+				{
+					brU16 const safeTokensAfter = freeTokensAfter & ~board.GetCompletingTokensMaskAfter(slot, token);
+					weight = safeTokensAfter ? 0.5f + static_cast<brFloat>(quarto::CountSetBits(safeTokensAfter)) / quarto::CountSetBits(freeTokensAfter) : s_losingChoiceWeight;
+				}
+				priors[MakeAction(slot, token)] = weight;
+				totalSlotWeight += weight;
+			}
+
+			brFloat const tokenWeight = winningSlots && givenToken == quarto::InvalidToken ? s_losingChoiceWeight : 1.f;
+			for (brU32 slotsLeft = emptySlots; slotsLeft; slotsLeft &= slotsLeft - 1)
+			{
+				priors[MakeAction(static_cast<quarto::SlotIndex>(quarto::GetIndexOfLowestSetBit(slotsLeft)), token)] *= tokenWeight / totalSlotWeight;
+			}
+			totalTokenWeight += tokenWeight;
+		}
+
+		for (brFloat& prior : priors)
+		{
+			prior /= totalTokenWeight;
+		}
+	}
+
+	// Removes the placements which can't be the choice of a player who sees one move ahead (SearchSettings::UseTacticalFilter)
+	// Keeps at least one placement of every token which isn't dropped as a whole, so the actions never run out.
+	void ApplyTacticalFilter(quarto::Board const& board, quarto::TokenId givenToken, std::vector<Action>& actions)
+	{
+		brU16 const emptySlots = board.GetEmptySlotsMask();
+		brU16 const freeTokens = board.GetFreeTokensMask();
+		brU16 const tokens = givenToken != quarto::InvalidToken ? static_cast<brU16>(1u << givenToken) : freeTokens;
+		brBool const hasSafeToken = (freeTokens & ~board.GetCompletingTokensMask()) != 0;
+		brU32 const numEmptySlotsAfter = quarto::CountSetBits(emptySlots) - 1;
+
+		brU16 keptSlots[quarto::NumTokens] = {};
+		for (brU32 tokensLeft = tokens; tokensLeft; tokensLeft &= tokensLeft - 1)
+		{
+			quarto::TokenId const token = static_cast<quarto::TokenId>(quarto::GetIndexOfLowestSetBit(tokensLeft));
+
+			//a token in hand which completes a line is placed there, a token which completes one is only handed over if every token does
+			if (brU16 const winningSlots = board.GetWinningSlotsMask(token))
+			{
+				keptSlots[token] = givenToken != quarto::InvalidToken || !hasSafeToken ? winningSlots : 0;
+				continue;
+			}
+
+			//placing the token so that every token left completes a line loses, unless every slot does
+			brU16 const freeTokensAfter = freeTokens & ~(1u << token);
+			brU16 notLosingSlots = 0;
+			for (brU32 slotsLeft = emptySlots; slotsLeft; slotsLeft &= slotsLeft - 1)
+			{
+				quarto::SlotIndex const slot = static_cast<quarto::SlotIndex>(quarto::GetIndexOfLowestSetBit(slotsLeft));
+				if (!freeTokensAfter || numEmptySlotsAfter == 0 || (freeTokensAfter & ~board.GetCompletingTokensMaskAfter(slot, token)))
+				{
+					notLosingSlots |= static_cast<brU16>(1u << slot);
+				}
+			}
+			keptSlots[token] = notLosingSlots ? notLosingSlots : emptySlots;
+		}
+
+		actions.erase(std::remove_if(actions.begin(), actions.end(), [&keptSlots](Action action)
+		{
+			return !((keptSlots[GetActionToken(action)] >> GetActionSlot(action)) & 1u);
+		}), actions.end());
+	}
+
+	// Root statistics of one or more trees, indexed by action
+	struct RootChildTotals
+	{
+		void Add(Node const& root)
+		{
+			for (Node const* childNode = root.FirstChild; childNode; childNode = childNode->NextSibling)
+			{
+				VisitCounts[childNode->PlayedAction] += childNode->VisitCount;
+				WinScores[childNode->PlayedAction] += childNode->WinScore;
+			}
+		}
+
+		Action GetMostVisitedAction() const
+		{
+			Action mostVisited = InvalidAction;
+			for (Action action = 0; action < NumActions; ++action)
+			{
+				if (VisitCounts[action] > 0 && (mostVisited == InvalidAction || VisitCounts[action] > VisitCounts[mostVisited]))
+				{
+					mostVisited = action;
+				}
+			}
+			return mostVisited;
+		}
+
+		void FillStats(Action bestAction, SearchStats& stats) const
+		{
+			stats.RootChildren.clear();
+			for (Action action = 0; action < NumActions; ++action)
+			{
+				if (VisitCounts[action] > 0)
+				{
+					brFloat const winRate = static_cast<brFloat>(WinScores[action]) / (s_winScore * static_cast<brFloat>(VisitCounts[action]));
+					stats.RootChildren.push_back({ action, VisitCounts[action], std::min(std::max(winRate, 0.f), 1.f) });
+				}
+			}
+			std::stable_sort(stats.RootChildren.begin(), stats.RootChildren.end(), [](RootChildStats const& a, RootChildStats const& b) { return a.VisitCount > b.VisitCount; });
+
+			stats.EstimatedWinRate = 0.f;
+			for (RootChildStats const& child : stats.RootChildren)
+			{
+				if (child.PlayedAction == bestAction)
+				{
+					stats.EstimatedWinRate = child.WinRate;
+				}
+			}
+		}
+
+		brU32 VisitCounts[NumActions] = {};
+		brS64 WinScores[NumActions] = {};
+	};
+
+	// Sums up the root statistics of all trees, an immediate win found by any of them is taken right away
+	SearchResult MergeRootResults(std::vector<std::unique_ptr<SearchTask>> const& tasks)
+	{
+		SearchRequest const& request = tasks[0]->GetTree().GetRequest();
+		SearchResult result;
+		RootChildTotals totals;
+		Action winningAction = InvalidAction;
+		SearchStats& stats = result.Stats;
+		stats.NumThreads = static_cast<brU32>(tasks.size());
+		for (std::unique_ptr<SearchTask> const& task : tasks)
+		{
+			SearchTree const& tree = task->GetTree();
+			SearchResult const treeResult = tree.GetResult();
+			if (!request.IsOpponentTokenSearch() && treeResult.IsValid() && winningAction == InvalidAction)
+			{
+				quarto::Board board = request.Board;
+				PlayActionOnBoard(board, treeResult.BestAction);
+				if (board.HasWinningLineThrough(treeResult.GetSlot()))
+				{
+					winningAction = treeResult.BestAction;
+				}
+			}
+			result.SavedSeconds = std::max(result.SavedSeconds, treeResult.SavedSeconds);
+			totals.Add(tree.GetRoot());
+
+			SearchStats const& treeStats = treeResult.Stats;
+			stats.NumIterations += treeStats.NumIterations;
+			stats.NumPlayouts += treeStats.NumPlayouts;
+			stats.NumNodesAllocated += treeStats.NumNodesAllocated;
+			stats.NumNodesPruned += treeStats.NumNodesPruned;
+			stats.PeakTreeBytes += treeStats.PeakTreeBytes;
+			stats.MaxDepth = std::max(stats.MaxDepth, treeStats.MaxDepth);
+			stats.SelectSeconds += treeStats.SelectSeconds;
+			stats.ExpandSeconds += treeStats.ExpandSeconds;
+			stats.SimulateSeconds += treeStats.SimulateSeconds;
+			stats.BackPropagateSeconds += treeStats.BackPropagateSeconds;
+			stats.TotalSeconds = std::max(stats.TotalSeconds, treeStats.TotalSeconds);
+		}
+
+		result.BestAction = winningAction != InvalidAction ? winningAction : totals.GetMostVisitedAction();
+		totals.FillStats(result.BestAction, stats);
+		return result;
+	}
+}
+
+void AmafTrace::Reset()
+{
+	for (brU32 i = 0; i < QUARTO_BOARD_AVAILABLE_SLOTS; ++i)
+	{
+		m_actions[i] = InvalidAction;
+		m_playerIds[i] = 0;
+	}
+}
+
+void AmafTrace::Add(Action action, PlayerId playerId)
+{
+	if (action == InvalidAction)
+	{
+		return;
+	}
+
+	//every slot can only be played once per game, so the slot is a unique key within one trace
+	quarto::SlotIndex const slot = GetActionSlot(action);
+	m_actions[slot] = action;
+	m_playerIds[slot] = playerId;
+}
+
+brBool AmafTrace::Contains(Action action, PlayerId playerId) const
+{
+	if (action == InvalidAction)
+	{
+		return false;
+	}
+
+	quarto::SlotIndex const slot = GetActionSlot(action);
+	return m_actions[slot] == action && m_playerIds[slot] == playerId;
+}
+
+Node* NodePool::Allocate()
+{
+	if (!m_freeNodes.empty())
+	{
+		Node* node = m_freeNodes.back();
+		m_freeNodes.pop_back();
+		return node;
+	}
+
+	if (m_numNodesInLastChunk == s_chunkSize)
+	{
+		m_chunks.emplace_back(new Node[s_chunkSize]);
+		m_numNodesInLastChunk = 0;
+	}
+	return &m_chunks.back()[m_numNodesInLastChunk++];
+}
+
+void NodePool::Free(Node* node)
+{
+	if (node)
+	{
+		//releases the actions of the node as well
+		*node = Node();
+		m_freeNodes.push_back(node);
+	}
+}
+
+SearchTree::SearchTree(SearchSettings const& settings, SearchRequest const& request, brU64 randomSeed)
+	: m_settings(settings)
+	, m_request(request)
+	, m_budget(GetTreeBudget(settings, request.Budget))
+	, m_random(randomSeed)
+	, m_negate(request.IsOpponentTokenSearch())
+	//with a single free token or slot there is nothing to decide
+	, m_isDecisionForced(m_negate ? request.Board.GetNumberOfFreeTokens() <= 1 : request.Board.GetNumberOfFreeSlots() <= 1)
+{
+	m_root.Player = request.Opponent;
+}
+
+void SearchTree::Iterate()
+{
+	if (m_settings.UseNodeRecycling && m_budget.IsTreeFull())
+	{
+		PruneTree();
+	}
+
+	m_budget.AddIteration();
+
+	brBool const measurePhaseTimes = m_settings.MeasurePhaseTimes;
+	SearchBudget::Clock::time_point phaseStart = measurePhaseTimes ? SearchBudget::Clock::now() : SearchBudget::Clock::time_point();
+	auto const finishPhase = [this, measurePhaseTimes, &phaseStart](Phase phase)
+	{
+		if (measurePhaseTimes)
+		{
+			SearchBudget::Clock::time_point const now = SearchBudget::Clock::now();
+			m_phaseSeconds[phase] += std::chrono::duration<brDouble>(now - phaseStart).count();
+			phaseStart = now;
+		}
+	};
+
+	quarto::Board board = m_request.Board;
+	Node* promisingNode = Select(board);
+	finishPhase(Phase_Select);
+
+	if (board.GetStatus() == quarto::Board::GameStatus::InProgress)
+	{
+		Expand(promisingNode, board);
+	}
+	//the network values the new leaf itself, a playout starts from one of its children
+	Node* nodeToExplore = promisingNode;
+	if (promisingNode->FirstChild && !m_settings.LeafEvaluator)
+	{
+		//with priors the most promising child is tried first
+		nodeToExplore = m_settings.UsePuct ? FindBestNodeWithPuct(promisingNode) : GetRandomChild(promisingNode);
+		PlayActionOnBoard(board, nodeToExplore->PlayedAction);
+	}
+	finishPhase(Phase_Expand);
+
+	brU32 depth = 0;
+	for (Node const* node = nodeToExplore; node->Parent; node = node->Parent)
+	{
+		++depth;
+	}
+	m_maxDepth = std::max(m_maxDepth, depth);
+
+	m_trace.Reset();
+	PlayerId const winnerId = Simulate(nodeToExplore, board, m_trace);
+	finishPhase(Phase_Simulate);
+
+	BackPropagate(nodeToExplore, winnerId, m_trace);
+	finishPhase(Phase_BackPropagate);
+}
+
+brBool SearchTree::IsFinished()
+{
+	if (m_budget.IsExhausted())
+	{
+		return true;
+	}
+
+	if (m_settings.UseEarlyTermination && m_budget.GetNumIterations() >= m_nextEarlyTerminationCheck)
+	{
+		if (CanTerminateEarly())
+		{
+			m_isTerminatedEarly = true;
+			return true;
+		}
+		m_nextEarlyTerminationCheck = m_budget.GetNumIterations() + m_budget.GetDeadlineCheckInterval();
+	}
+	return false;
+}
+
+SearchResult SearchTree::GetResult() const
+{
+	SearchResult result;
+	result.BestAction = GetBestAction();
+	result.SavedSeconds = m_isTerminatedEarly ? m_budget.GetRemainingSeconds() : 0.0;
+	result.Stats = GetStats();
+	return result;
+}
+
+SearchStats SearchTree::GetStats() const
+{
+	SearchStats stats;
+	stats.NumIterations = m_budget.GetNumIterations();
+	stats.NumPlayouts = m_budget.GetNumPlayouts();
+	stats.NumNodesAllocated = m_numNodesAllocated;
+	stats.NumNodesPruned = m_numNodesPruned;
+	stats.PeakTreeBytes = m_budget.GetPeakTreeBytes();
+	stats.MaxDepth = m_maxDepth;
+	stats.SelectSeconds = m_phaseSeconds[Phase_Select];
+	stats.ExpandSeconds = m_phaseSeconds[Phase_Expand];
+	stats.SimulateSeconds = m_phaseSeconds[Phase_Simulate];
+	stats.BackPropagateSeconds = m_phaseSeconds[Phase_BackPropagate];
+	stats.TotalSeconds = m_budget.GetElapsedSeconds();
+
+	RootChildTotals totals;
+	totals.Add(m_root);
+	totals.FillStats(GetBestAction(), stats);
+	return stats;
+}
+
+Action SearchTree::GetBestAction() const
+{
+	Node const* bestChild = m_negate ? nullptr : FindWinningChild();
+	if (!bestChild)
+	{
+		bestChild = GetMostVisitedChild();
+	}
+	return bestChild ? bestChild->PlayedAction : InvalidAction;
+}
+
+brU64 SearchTree::ComputeChecksum() const
+{
+	//FNV-1a over the nodes in depth first order
+	brU64 checksum = 0xCBF29CE484222325ull;
+	auto const add = [&checksum](brU64 value)
+	{
+		checksum = (checksum ^ value) * 0x100000001B3ull;
+	};
+
+	std::vector<Node const*> nodesToVisit = { &m_root };
+	while (!nodesToVisit.empty())
+	{
+		Node const* node = nodesToVisit.back();
+		nodesToVisit.pop_back();
+
+		add(node->PlayedAction);
+		add(node->NumChildren);
+		add(node->VisitCount);
+		add(static_cast<brU32>(node->WinScore));
+		add(node->RaveVisitCount);
+		add(static_cast<brU32>(node->RaveWinScore));
+		add(static_cast<brU64>(node->ProofState));
+		for (Node const* childNode = node->FirstChild; childNode; childNode = childNode->NextSibling)
+		{
+			nodesToVisit.push_back(childNode);
+		}
+	}
+	return checksum;
+}
+
+Node* SearchTree::Select(quarto::Board& board)
+{
+	QUARTO_SCOPE_CYCLE_COUNTER(MCTS_Select);
+
+	Node* result = &m_root;
+	while (result->FirstChild)
+	{
+		if (!result->IsFullyExpanded() && !m_budget.IsTreeFull() && result->NumChildren < GetMaxNumberOfChildren(*result))
+		{
+			Node& child = AddNextChild(result);
+			PlayActionOnBoard(board, child.PlayedAction);
+			return &child;
+		}
+		result = FindBestNodeWithUct(result);
+		PlayActionOnBoard(board, result->PlayedAction);
+	}
+	return result;
+}
+
+void SearchTree::Expand(Node* node, quarto::Board const& board)
+{
+	QUARTO_SCOPE_CYCLE_COUNTER(MCTS_Expand);
+
+	//a full tree still allows to search on, the playouts just start deeper in the game
+	if (!node || node->FirstChild || m_budget.IsTreeFull())
+	{
+		return;
+	}
+
+	//the given token is only placed with the very first draw, afterwards all free tokens are possible
+	quarto::TokenId const token = node == &m_root ? m_request.Token : quarto::InvalidToken;
+
+	eval::PolicyValueNetwork const* const evaluator = m_settings.LeafEvaluator.get();
+	brBool const usePriors = evaluator || m_settings.UsePuct;
+	brFloat priors[NumActions];
+	if (evaluator)
+	{
+		m_evaluatedValue = evaluator->EvaluatePriors(board, token, priors);
+		m_evaluatedNode = node;
+	}
+	else if (usePriors)
+	{
+		ComputeHeuristicPriors(board, token, priors);
+	}
+
+	//nodes which lost all their children to the recycling keep their actions
+	if (node->IsFullyExpanded())
+	{
+		//without widening all children are added at once, the order doesn't matter then
+		node->UnexpandedActions = m_settings.UseProgressiveWidening && !usePriors
+			? GetAllPossibleActionsOrdered(board, token)
+			: GetAllPossibleActions(board, token);
+		if (m_settings.UseTacticalFilter)
+		{
+			ApplyTacticalFilter(board, token, node->UnexpandedActions);
+			node->UnexpandedActions.shrink_to_fit();
+		}
+		m_budget.AddNodes(0, node->UnexpandedActions.capacity() * sizeof(Action));
+	}
+
+	brS32 const maxNumberOfChildren = GetMaxNumberOfChildren(*node);
+	while (!node->IsFullyExpanded() && node->NumChildren < maxNumberOfChildren)
+	{
+		Node& child = AddNextChild(node);
+		child.Prior = usePriors ? priors[child.PlayedAction] : 0.f;
+	}
+}
+
+Node& SearchTree::AddNextChild(Node* node)
+{
+	Node& child = *m_pool.Allocate();
+	child.PlayedAction = node->UnexpandedActions.back();
+	node->UnexpandedActions.pop_back();
+	child.Player = node->Player == m_request.Player ? m_request.Opponent : m_request.Player;
+	child.Parent = node;
+	child.NextSibling = node->FirstChild;
+	node->FirstChild = &child;
+	++node->NumChildren;
+	++m_numNodesAllocated;
+	m_budget.AddNodes(1, child.GetAllocatedSize());
+	return child;
+}
+
+void SearchTree::PruneTree()
+{
+	QUARTO_SCOPE_CYCLE_COUNTER(MCTS_PruneTree);
+
+	//the root children are the candidates of the decision and are never pruned
+	std::vector<Node*> leaves;
+	std::vector<Node*> nodesToVisit;
+	for (Node* childNode = m_root.FirstChild; childNode; childNode = childNode->NextSibling)
+	{
+		for (Node* grandChildNode = childNode->FirstChild; grandChildNode; grandChildNode = grandChildNode->NextSibling)
+		{
+			nodesToVisit.push_back(grandChildNode);
+		}
+	}
+	while (!nodesToVisit.empty())
+	{
+		Node* node = nodesToVisit.back();
+		nodesToVisit.pop_back();
+		if (!node->FirstChild)
+		{
+			leaves.push_back(node);
+			continue;
+		}
+		for (Node* childNode = node->FirstChild; childNode; childNode = childNode->NextSibling)
+		{
+			nodesToVisit.push_back(childNode);
+		}
+	}
+
+	std::stable_sort(leaves.begin(), leaves.end(), [](Node const* a, Node const* b) { return a->VisitCount < b->VisitCount; });
+
+	for (Node* leaf : leaves)
+	{
+		if (!m_budget.IsTreeFull(m_settings.NodeRecyclingTargetRatio))
+		{
+			break;
+		}
+
+		Node* parent = leaf->Parent;
+		Node** link = &parent->FirstChild;
+		while (*link != leaf)
+		{
+			link = &(*link)->NextSibling;
+		}
+		*link = leaf->NextSibling;
+		--parent->NumChildren;
+
+		//the action goes back to the front of the parent's unexpanded actions, so it is the last one to be tried again
+		//the action came from there, so the capacity is still available
+		parent->UnexpandedActions.insert(parent->UnexpandedActions.begin(), leaf->PlayedAction);
+
+		m_budget.RemoveNodes(1, leaf->GetAllocatedSize());
+		m_pool.Free(leaf);
+		++m_numNodesPruned;
+	}
+}
+
+brS32 SearchTree::GetMaxNumberOfChildren(Node const& node) const
+{
+	if (!m_settings.UseProgressiveWidening || m_settings.UsePuct || m_settings.LeafEvaluator)
+	{
+		return std::numeric_limits<brS32>::max();
+	}
+
+	brFloat const numberOfChildren = m_settings.ProgressiveWideningCoefficient * std::pow(node.VisitCount + 1.f, m_settings.ProgressiveWideningExponent);
+	return std::max(1, static_cast<brS32>(std::ceil(numberOfChildren)));
+}
+
+PlayerId SearchTree::Simulate(Node* node, quarto::Board& board, AmafTrace& trace)
+{
+	QUARTO_SCOPE_CYCLE_COUNTER(MCTS_Simulate);
+
+	if (!node)
+	{
+		return 0;
+	}
+
+	quarto::Board::GameStatus status = board.GetStatus();
+	if (status == quarto::Board::GameStatus::End
+		&& m_request.Player != node->Player)
+	{
+		if (node->Parent)
+		{
+			node->Parent->ProofState = m_negate ? Proof::Win : Proof::Loss;
+		}
+		return node->Player;
+	}
+
+	if (status == quarto::Board::GameStatus::InProgress)
+	{
+		m_budget.AddPlayout();
+	}
+
+	if (eval::PolicyValueNetwork const* const leafEvaluator = m_settings.LeafEvaluator.get(); leafEvaluator && status == quarto::Board::GameStatus::InProgress)
+	{
+		//the value is the chance of the deciding player: the one to place the token in hand at the root of a move search, the one who placed last otherwise
+		brBool const hasToken = node == &m_root && !m_request.IsOpponentTokenSearch();
+		brFloat value = m_evaluatedValue;
+		if (node != m_evaluatedNode)
+		{
+			eval::PolicyValue output;
+			leafEvaluator->Evaluate(board, hasToken ? m_request.Token : quarto::InvalidToken, output);
+			value = output.Value;
+		}
+		m_evaluatedNode = nullptr;
+
+		PlayerId const nextPlayer = node->Player == m_request.Player ? m_request.Opponent : m_request.Player;
+		PlayerId const decidingPlayer = hasToken ? nextPlayer : node->Player;
+		PlayerId const otherPlayer = hasToken ? node->Player : nextPlayer;
+		//drawing the winner by the value keeps the statistics unbiased, like the cut playouts
+		return m_random.NextFloat() < value ? decidingPlayer : otherPlayer;
+	}
+
+	eval::NTupleNetwork const* const evaluator = m_settings.PlayoutEvaluator.get();
+	eval::NTupleState evaluatorState;
+	if (evaluator)
+	{
+		evaluatorState.Reset(board);
+	}
+
+	PlayerId currentPlayer = node->Player;
+	brU32 numPlacements = 0;
+	while (status == quarto::Board::GameStatus::InProgress)
+	{
+		if (evaluator && numPlacements == m_settings.PlayoutCutoffPlacements)
+		{
+			//the estimate is the chance of the last placing player, drawing the winner by it keeps the statistics unbiased
+			PlayerId const nextPlayer = currentPlayer == m_request.Player ? m_request.Opponent : m_request.Player;
+			return m_random.NextFloat() < evaluator->Evaluate(evaluatorState) ? currentPlayer : nextPlayer;
+		}
+
+		currentPlayer = currentPlayer == m_request.Player ? m_request.Opponent : m_request.Player;
+		Action const action = RandomPlay(board);
+		if (action == InvalidAction)
+		{
+			break;
+		}
+		trace.Add(action, currentPlayer);
+		++numPlacements;
+		if (evaluator)
+		{
+			evaluatorState.SetToken(GetActionSlot(action), GetActionToken(action));
+		}
+
+		//the board had no winning line before, so only the lines through the new token can have changed that
+		brBool const isGameOver = board.HasWinningLineThrough(GetActionSlot(action)) || board.GetEmptySlotsMask() == 0;
+		status = isGameOver ? quarto::Board::GameStatus::End : quarto::Board::GameStatus::InProgress;
+	}
+
+	return currentPlayer;
+}
+
+void SearchTree::BackPropagate(Node* node, PlayerId winnerId, AmafTrace& trace)
+{
+	QUARTO_SCOPE_CYCLE_COUNTER(MCTS_BackPropagate);
+
+	Node* tmpNode = node;
+	while (tmpNode)
+	{
+		++(tmpNode->VisitCount);
+		if (IsWinningNode(*tmpNode, winnerId))
+		{
+			tmpNode->WinScore += s_winScore;
+		}
+
+		//AMAF: every sibling whose action was played later on in this iteration by the same player gets the result too
+		for (Node* childNode = tmpNode->FirstChild; childNode; childNode = childNode->NextSibling)
+		{
+			if (trace.Contains(childNode->PlayedAction, childNode->Player))
+			{
+				++(childNode->RaveVisitCount);
+				if (IsWinningNode(*childNode, winnerId))
+				{
+					childNode->RaveWinScore += s_winScore;
+				}
+			}
+		}
+
+		trace.Add(tmpNode->PlayedAction, tmpNode->Player);
+		tmpNode = tmpNode->Parent;
+	}
+}
+
+brBool SearchTree::IsWinningNode(Node const& node, PlayerId winnerId) const
+{
+	return (!m_negate && node.Player == winnerId) || (m_negate && node.Player != winnerId);
+}
+
+Node* SearchTree::FindBestNodeWithUct(Node* node) const
+{
+	if (!node)
+	{
+		return nullptr;
+	}
+	if (m_settings.UsePuct || m_settings.LeafEvaluator)
+	{
+		return FindBestNodeWithPuct(node);
+	}
+
+	SearchSettings const& settings = m_settings;
+	auto const uctValueFct = [&settings](brU32 totalVisit, Node const& childNode) -> brFloat
+	{
+		if (childNode.ProofState != Proof::None)
+		{
+			return childNode.ProofState == Proof::Win ? brFloatMax : -brFloatMax;
+		}
+
+		brU32 const nodeVisit = childNode.VisitCount;
+		brBool const hasRaveValue = settings.UseRave && childNode.RaveVisitCount > 0;
+
+		if (nodeVisit == 0 && !hasRaveValue)
+		{
+			return brFloatMax;
+		}
+
+		brFloat const explorationValue = settings.ExplorationParameter * std::sqrt(std::log(static_cast<brFloat>(totalVisit)) / static_cast<brFloat>(std::max(nodeVisit, 1u)));
+		if (!hasRaveValue)
+		{
+			return (static_cast<brFloat>(childNode.WinScore) / nodeVisit) + explorationValue;
+		}
+
+		//unvisited nodes are judged by their AMAF value alone, which saves trying out every single one of up to 256 children
+		brFloat const raveValue = static_cast<brFloat>(childNode.RaveWinScore) / childNode.RaveVisitCount;
+		if (nodeVisit == 0)
+		{
+			return raveValue + explorationValue;
+		}
+
+		brFloat const k = settings.RaveEquivalenceParameter;
+		brFloat const beta = std::sqrt(k / (3.f * nodeVisit + k));
+		brFloat const uctValue = static_cast<brFloat>(childNode.WinScore) / nodeVisit;
+		return (1.f - beta) * uctValue + beta * raveValue + explorationValue;
+	};
+
+	Node* bestNode = nullptr;
+	brU32 const parentVisit = node->VisitCount;
+	brFloat highestUctValue = -brFloatMax;
+	for (Node* childNode = node->FirstChild; childNode; childNode = childNode->NextSibling)
+	{
+		brFloat const uctValue = uctValueFct(parentVisit, *childNode);
+		if (uctValue > highestUctValue || !bestNode)
+		{
+			bestNode = childNode;
+			highestUctValue = uctValue;
+		}
+	}
+
+	return bestNode;
+}
+
+Node* SearchTree::FindBestNodeWithPuct(Node* node) const
+{
+	Node* bestNode = nullptr;
+	brFloat const explorationFactor = m_settings.PuctExplorationParameter * std::sqrt(static_cast<brFloat>(std::max(node->VisitCount, 1u)));
+	brFloat highestValue = -brFloatMax;
+	for (Node* childNode = node->FirstChild; childNode; childNode = childNode->NextSibling)
+	{
+		brFloat value;
+		if (childNode->ProofState != Proof::None)
+		{
+			value = childNode->ProofState == Proof::Win ? brFloatMax : -brFloatMax;
+		}
+		else
+		{
+			//unvisited children count as lost until their prior makes them worth a try
+			brU32 const nodeVisit = childNode->VisitCount;
+			brFloat const winRate = nodeVisit > 0 ? static_cast<brFloat>(childNode->WinScore) / (s_winScore * static_cast<brFloat>(nodeVisit)) : 0.f;
+			value = winRate + explorationFactor * childNode->Prior / (1.f + nodeVisit);
+		}
+
+		if (value > highestValue || !bestNode)
+		{
+			bestNode = childNode;
+			highestValue = value;
+		}
+	}
+	return bestNode;
+}
+
+Node* SearchTree::GetRandomChild(Node* node)
+{
+	Node* child = node->FirstChild;
+	for (brU32 i = m_random.NextBelow(node->NumChildren); i > 0; --i)
+	{
+		child = child->NextSibling;
+	}
+	return child;
+}
+
+Node const* SearchTree::FindWinningChild() const
+{
+	for (Node const* childNode = m_root.FirstChild; childNode; childNode = childNode->NextSibling)
+	{
+		quarto::Board board = m_request.Board;
+		PlayActionOnBoard(board, childNode->PlayedAction);
+		if (board.HasWinningLineThrough(GetActionSlot(childNode->PlayedAction)))
+		{
+			return childNode;
+		}
+	}
+	return nullptr;
+}
+
+Node const* SearchTree::GetMostVisitedChild() const
+{
+	Node const* bestChild = nullptr;
+	for (Node const* childNode = m_root.FirstChild; childNode; childNode = childNode->NextSibling)
+	{
+		if (!bestChild || childNode->VisitCount > bestChild->VisitCount)
+		{
+			bestChild = childNode;
+		}
+	}
+	return bestChild;
+}
+
+brBool SearchTree::CanTerminateEarly() const
+{
+	if (!m_root.FirstChild)
+	{
+		return false;
+	}
+
+	//solved root: the decision is forced or (when searching for the own move) the game can be won right away
+	if (m_isDecisionForced || (m_root.IsFullyExpanded() && m_root.NumChildren == 1) || (!m_negate && FindWinningChild()))
+	{
+		return true;
+	}
+
+	brU32 mostVisits = 0;
+	brU32 secondMostVisits = 0;
+	for (Node const* childNode = m_root.FirstChild; childNode; childNode = childNode->NextSibling)
+	{
+		brU32 const visitCount = childNode->VisitCount;
+		if (visitCount > mostVisits)
+		{
+			secondMostVisits = mostVisits;
+			mostVisits = visitCount;
+		}
+		else if (visitCount > secondMostVisits)
+		{
+			secondMostVisits = visitCount;
+		}
+	}
+
+	//even if every remaining iteration went to the runner-up, it couldn't catch up anymore
+	return mostVisits - secondMostVisits > m_budget.EstimateRemainingIterations();
+}
+
+std::vector<Action> SearchTree::GetAllPossibleActions(quarto::Board const& board, quarto::TokenId token) const
+{
+	std::vector<Action> actions;
+	brU32 const tokensMask = token == quarto::InvalidToken ? board.GetFreeTokensMask() : (1u << token);
+	actions.reserve(quarto::CountSetBits(board.GetEmptySlotsMask()) * quarto::CountSetBits(tokensMask));
+	for (brU32 slots = board.GetEmptySlotsMask(); slots; slots &= slots - 1)
+	{
+		quarto::SlotIndex const slot = static_cast<quarto::SlotIndex>(quarto::GetIndexOfLowestSetBit(slots));
+		for (brU32 tokens = tokensMask; tokens; tokens &= tokens - 1)
+		{
+			actions.push_back(MakeAction(slot, static_cast<quarto::TokenId>(quarto::GetIndexOfLowestSetBit(tokens))));
+		}
+	}
+	return actions;
+}
+
+std::vector<Action> SearchTree::GetAllPossibleActionsOrdered(quarto::Board const& board, quarto::TokenId token) const
+{
+	struct ScoredAction
+	{
+		Action Id;
+		brS32 Score;
+	};
+
+	std::vector<ScoredAction> scoredActions;
+	std::vector<Action> actions = GetAllPossibleActions(board, token);
+	scoredActions.reserve(actions.size());
+	for (Action const action : actions)
+	{
+		//a copy is cheaper than taking the token back, which recomputes the lines of the slot
+		quarto::Board scratchBoard = board;
+		quarto::SlotIndex const slot = GetActionSlot(action);
+		scratchBoard.SetTokenOnBoard(slot, GetActionToken(action));
+
+		//winning right away beats everything, every line which is one token away from a win is a chance for the next player
+		brS32 const score = scratchBoard.HasWinningLineThrough(slot) ? 100 : -10 * static_cast<brS32>(scratchBoard.GetNumberOfThreatLines());
+		scoredActions.push_back({ action, score });
+	}
+
+	std::stable_sort(scoredActions.begin(), scoredActions.end(), [](ScoredAction const& a, ScoredAction const& b) { return a.Score < b.Score; });
+
+	for (size_t i = 0; i < scoredActions.size(); ++i)
+	{
+		actions[i] = scoredActions[i].Id;
+	}
+	return actions;
+}
+
+Action SearchTree::RandomPlay(quarto::Board& board)
+{
+	brU32 const emptySlots = board.GetEmptySlotsMask();
+	brU32 const freeTokens = board.GetFreeTokensMask();
+	if (emptySlots == 0 || freeTokens == 0)
+	{
+		return InvalidAction;
+	}
+
+	quarto::SlotIndex const slot = static_cast<quarto::SlotIndex>(quarto::GetIndexOfNthSetBit(emptySlots, m_random.NextBelow(quarto::CountSetBits(emptySlots))));
+	quarto::TokenId const token = static_cast<quarto::TokenId>(quarto::GetIndexOfNthSetBit(freeTokens, m_random.NextBelow(quarto::CountSetBits(freeTokens))));
+	board.SetTokenOnBoard(slot, token);
+	return MakeAction(slot, token);
+}
+
+SearchResult ai::mcts::RunSearch(SearchSettings const& settings, SearchRequest const& request, SearchControl* control, SearchSnapshotBuffer* snapshots)
+{
+	QUARTO_SCOPE_CYCLE_COUNTER(MCTS_RunSearch);
+
+	brU32 const numThreads = std::max(settings.NumThreads, 1u);
+	if (numThreads == 1)
+	{
+		SearchTask task(settings, request, 0, control, true, snapshots);
+		task.RunSlice();
+		return task.Finish();
+	}
+
+	SearchRequest threadRequest = request;
+	threadRequest.Budget = SplitBudget(request.Budget, numThreads);
+
+	std::vector<std::unique_ptr<SearchTask>> tasks;
+	for (brU32 i = 0; i < numThreads; ++i)
+	{
+		tasks.push_back(std::make_unique<SearchTask>(settings, threadRequest, i, control, i == 0, snapshots));
+	}
+
+	//every tree is searched by its own thread from start to end, so the schedule doesn't change the result
+	//the calling thread searches the first tree itself
+	std::vector<std::thread> threads;
+	for (brU32 i = 1; i < numThreads; ++i)
+	{
+		threads.emplace_back([&task = *tasks[i]]() { task.RunSlice(); });
+	}
+	tasks[0]->RunSlice();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	SearchResult const result = MergeRootResults(tasks);
+	tasks[0]->PublishResult(result);
+	return result;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/Common/Random.h"
+#include "QuartoCore/MCTS/Action.h"
+#include "QuartoCore/MCTS/SearchBudget.h"
+#include "QuartoCore/MCTS/SearchControl.h"
+#include "QuartoCore/MCTS/SearchSettings.h"
+#include "QuartoCore/MCTS/SearchSnapshot.h"
+#include "QuartoCore/MCTS/SearchStats.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace ai
+{
+	namespace mcts
+	{
+		struct SearchRequest
+		{
+			brBool IsOpponentTokenSearch() const { return Token == quarto::InvalidToken; }
+
+			quarto::Board Board;
+			// Token to place with the next move, InvalidToken searches for the token to hand over to the opponent instead
+			quarto::TokenId Token = quarto::InvalidToken;
+			// The searching player and its opponent, the opponent made the last move on the board
+			PlayerId Player = 0;
+			PlayerId Opponent = 1;
+			SearchBudgetSettings Budget;
+		};
+
+		struct SearchResult
+		{
+			brBool IsValid() const { return BestAction != InvalidAction; }
+			quarto::SlotIndex GetSlot() const { return GetActionSlot(BestAction); }
+			quarto::TokenId GetToken() const { return GetActionToken(BestAction); }
+
+			Action BestAction = InvalidAction;
+			// Time left in the budget because of the early termination, 0 if the budget, a limit or a stop ended the search
+			brDouble SavedSeconds = 0.0;
+			SearchStats Stats;
+		};
+
+		// Node of a search tree which was decided right away, seen from the player choosing between the node and its siblings
+		enum class Proof : brU8
+		{
+			None,
+			Win,
+			Loss
+		};
+
+		// Remembers which action was played on every slot during one iteration (tree path + random playout)
+		struct AmafTrace
+		{
+			AmafTrace() { Reset(); }
+
+			void Reset();
+			void Add(Action action, PlayerId playerId);
+			brBool Contains(Action action, PlayerId playerId) const;
+
+		private:
+			Action m_actions[QUARTO_BOARD_AVAILABLE_SLOTS];
+			PlayerId m_playerIds[QUARTO_BOARD_AVAILABLE_SLOTS];
+		};
+
+		// Nodes don't store their board, it is replayed from the root along the path of played actions
+		struct Node
+		{
+			brBool IsFullyExpanded() const { return UnexpandedActions.empty(); }
+			// Memory owned by this node, the actions don't change their capacity after the expansion
+			brU64 GetAllocatedSize() const { return sizeof(Node) + UnexpandedActions.capacity() * sizeof(Action); }
+
+			Node* Parent = nullptr;
+			// Children are a singly linked list, nodes are owned by the NodePool of the search
+			Node* FirstChild = nullptr;
+			Node* NextSibling = nullptr;
+			// Actions without a child yet, the next child to add is the last one
+			std::vector<Action> UnexpandedActions;
+			brU32 VisitCount = 0;
+			brS32 WinScore = 0;
+			brU32 RaveVisitCount = 0;
+			brS32 RaveWinScore = 0;
+			// Chance of the action by the policy of SearchSettings::LeafEvaluator or the heuristic of UsePuct, children re-added after the recycling start at 0
+			brFloat Prior = 0.f;
+			// The player who played the action
+			PlayerId Player = 0;
+			brU16 NumChildren = 0;
+			Action PlayedAction = InvalidAction;
+			Proof ProofState = Proof::None;
+		};
+
+		// Owns the nodes of one search tree, freed nodes are recycled before new memory is allocated
+		class QUARTOCORE_API NodePool
+		{
+		public:
+			Node* Allocate();
+			void Free(Node* node);
+
+		private:
+			static constexpr brU32 s_chunkSize = 1024;
+
+			// chunks never grow, so nodes never move in memory
+			std::vector<std::unique_ptr<Node[]>> m_chunks;
+			brU32 m_numNodesInLastChunk = s_chunkSize;
+			std::vector<Node*> m_freeNodes;
+		};
+
+		// State of one search, driven iteration by iteration
+		class QUARTOCORE_API SearchTree
+		{
+		public:
+			SearchTree(SearchSettings const& settings, SearchRequest const& request, brU64 randomSeed);
+			SearchTree(SearchTree const&) = delete;
+			SearchTree& operator=(SearchTree const&) = delete;
+
+			// Runs one select, expand, simulate and backpropagate iteration
+			void Iterate();
+			// The budget is exhausted or searching on can't change the decision anymore
+			brBool IsFinished();
+			SearchResult GetResult() const;
+			SearchStats GetStats() const;
+			// The decision: a winning child of the root if there is one (move search only), the most visited one otherwise
+			Action GetBestAction() const;
+
+			// The single phases of an iteration, the board always holds the state of the node and is updated along the way
+			// Selects the most promising node outgoing from the root, widens a node on the way if it is allowed to consider one more child
+			Node* Select(quarto::Board& board);
+			// Expands the given node with new possible nodes
+			void Expand(Node* node, quarto::Board const& board);
+			// Simulates a random play, records the played actions and returns the winner
+			// With a leaf evaluator the winner is drawn by the network's value of the node instead
+			PlayerId Simulate(Node* node, quarto::Board& board, AmafTrace& trace);
+			// Backpropagates the results, including the AMAF results of the siblings along the path
+			void BackPropagate(Node* node, PlayerId winnerId, AmafTrace& trace);
+			// Places a random free token on a random empty slot, one step of a playout
+			Action RandomPlay(quarto::Board& board);
+
+			// Hash over the shape and the statistics of the whole tree, equal for bit-identical trees
+			brU64 ComputeChecksum() const;
+
+			Node& GetRoot() { return m_root; }
+			Node const& GetRoot() const { return m_root; }
+			SearchBudget const& GetBudget() const { return m_budget; }
+			SearchBudget& GetBudget() { return m_budget; }
+			SearchRequest const& GetRequest() const { return m_request; }
+
+		private:
+			// Adds the next unexpanded action as a child node
+			Node& AddNextChild(Node* node);
+			// Frees the least visited leaves below the root children until the tree fits into the configured share of its budget again
+			void PruneTree();
+			brS32 GetMaxNumberOfChildren(Node const& node) const;
+			Node* FindBestNodeWithUct(Node* node) const;
+			Node* FindBestNodeWithPuct(Node* node) const;
+			Node* GetRandomChild(Node* node);
+			// Returns a child of the root which wins the game right away
+			Node const* FindWinningChild() const;
+			Node const* GetMostVisitedChild() const;
+			// True if searching on can't change the decision anymore
+			brBool CanTerminateEarly() const;
+			brBool IsWinningNode(Node const& node, PlayerId winnerId) const;
+
+			std::vector<Action> GetAllPossibleActions(quarto::Board const& board, quarto::TokenId token) const;
+			// Same as GetAllPossibleActions, but sorted by a cheap heuristic with the most promising action last
+			std::vector<Action> GetAllPossibleActionsOrdered(quarto::Board const& board, quarto::TokenId token) const;
+
+			SearchSettings m_settings;
+			SearchRequest m_request;
+			SearchBudget m_budget;
+			NodePool m_pool;
+			Node m_root;
+			AmafTrace m_trace;
+			quarto::Random m_random;
+			brBool m_negate;
+			brBool m_isDecisionForced;
+			brU32 m_nextEarlyTerminationCheck = 1;
+			brBool m_isTerminatedEarly = false;
+			// Value of the node Expand just evaluated for its priors, saves Simulate a second evaluation
+			Node const* m_evaluatedNode = nullptr;
+			brFloat m_evaluatedValue = 0.f;
+
+			brU32 m_numNodesAllocated = 0;
+			brU32 m_numNodesPruned = 0;
+			brU32 m_maxDepth = 0;
+			enum Phase : brU8
+			{
+				Phase_Select,
+				Phase_Expand,
+				Phase_Simulate,
+				Phase_BackPropagate,
+				Phase_Count
+			};
+			brDouble m_phaseSeconds[Phase_Count] = {};
+		};
+
+		// Runs a complete search, on the calling thread and SearchSettings::NumThreads - 1 additional ones
+		// control allows to stop it, move its deadline and peek at its decision from other threads
+		// snapshots receives the live state of the search for a single consumer
+		QUARTOCORE_API SearchResult RunSearch(SearchSettings const& settings, SearchRequest const& request, SearchControl* control = nullptr, SearchSnapshotBuffer* snapshots = nullptr);
+	}
+}
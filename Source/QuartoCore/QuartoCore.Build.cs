@@ -0,0 +1,16 @@
+using UnrealBuildTool;
+
+public class QuartoCore : ModuleRules
+{
+	public QuartoCore(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+		CppStandard = CppStandardVersion.Cpp17;
+
+		// The core is engine independent (see CMakeLists.txt), Core is only needed for the module boilerplate
+		PrivateDependencyModuleNames.AddRange(new string[] { "Core" });
+
+		// Maps the profiling hooks of the core (Common/Profiling.h) to the "Quarto" stat group
+		PublicDefinitions.Add("QUARTO_WITH_UNREAL_STATS=1");
+	}
+}
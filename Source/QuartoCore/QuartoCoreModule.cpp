@@ -0,0 +1,4 @@
+#include "Modules/ModuleManager.h"
+
+// Only built by the Unreal Build Tool, the standalone CMake build doesn't know about modules
+IMPLEMENT_MODULE(FDefaultModuleImpl, QuartoCore);
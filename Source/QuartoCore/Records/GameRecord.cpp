@@ -0,0 +1,226 @@
+#include "QuartoCore/Records/GameRecord.h"
+#include "QuartoCore/Common/Crc32.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+using namespace quarto;
+
+namespace
+{
+	constexpr brU8 s_fileMagic[4] = { 'Q', 'R', 'E', 'C' };
+	constexpr brU8 s_numPlacementsMask = 0x1F;
+	constexpr brU8 s_resultShift = 5;
+	constexpr brU8 s_hasSearchStatsBit = 0x80;
+
+	void AppendU32(std::vector<brU8>& buffer, brU32 value)
+	{
+		for (brU32 i = 0; i < 4; ++i)
+		{
+			buffer.push_back(static_cast<brU8>(value >> (8 * i)));
+		}
+	}
+
+	brU32 ReadU32(brU8 const* data)
+	{
+		return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<brU32>(data[3]) << 24);
+	}
+
+	void AppendVarint(std::vector<brU8>& buffer, brU32 value)
+	{
+		while (value >= 0x80)
+		{
+			buffer.push_back(static_cast<brU8>(value | 0x80));
+			value >>= 7;
+		}
+		buffer.push_back(static_cast<brU8>(value));
+	}
+
+	brBool ReadVarint(brU8 const*& data, brU8 const* end, brU32& value)
+	{
+		value = 0;
+		for (brU32 shift = 0; shift < 35 && data < end; shift += 7)
+		{
+			brU8 const byte = *data++;
+			value |= static_cast<brU32>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	brBool ReadGame(brU8 const*& data, brU8 const* end, GameRecord& record)
+	{
+		if (data >= end)
+		{
+			return false;
+		}
+		brU8 const header = *data++;
+		record.NumPlacements = header & s_numPlacementsMask;
+		record.Result = static_cast<GameResult>((header >> s_resultShift) & 0x3);
+		if (record.NumPlacements > QUARTO_BOARD_AVAILABLE_SLOTS || end - data < record.NumPlacements)
+		{
+			return false;
+		}
+
+		for (brU8 i = 0; i < record.NumPlacements; ++i)
+		{
+			PlacementRecord& placement = record.Placements[i];
+			placement.Slot = static_cast<SlotIndex>(data[i] >> 4);
+			placement.Token = static_cast<TokenId>(data[i] & 0xF);
+			placement.SearchIterations = 0;
+			placement.SearchWinRate = 0.f;
+		}
+		data += record.NumPlacements;
+
+		if (header & s_hasSearchStatsBit)
+		{
+			for (brU8 i = 0; i < record.NumPlacements; ++i)
+			{
+				PlacementRecord& placement = record.Placements[i];
+				if (!ReadVarint(data, end, placement.SearchIterations) || data >= end)
+				{
+					return false;
+				}
+				placement.SearchWinRate = *data++ / 255.f;
+			}
+		}
+		return true;
+	}
+}
+
+void GameRecord::AddPlacement(SlotIndex slot, TokenId token, brU32 searchIterations, brFloat searchWinRate)
+{
+	if (NumPlacements < QUARTO_BOARD_AVAILABLE_SLOTS)
+	{
+		Placements[NumPlacements++] = { slot, token, searchIterations, searchWinRate };
+	}
+}
+
+brBool GameRecord::Replay(Board& board) const
+{
+	board.Reset();
+	for (brU8 i = 0; i < NumPlacements; ++i)
+	{
+		PlacementRecord const& placement = Placements[i];
+		if (board.HasWinningLine() || !board.IsSlotEmpty(placement.Slot) || !board.IsTokenFree(placement.Token))
+		{
+			return false;
+		}
+		board.SetTokenOnBoard(placement.Slot, placement.Token);
+	}
+	return true;
+}
+
+void records::AppendFileHeader(std::vector<brU8>& buffer)
+{
+	buffer.insert(buffer.end(), std::begin(s_fileMagic), std::end(s_fileMagic));
+	buffer.push_back(FormatVersion);
+	buffer.insert(buffer.end(), 3, 0);
+}
+
+brBool records::IsValidFileHeader(brU8 const* data, size_t size)
+{
+	return size >= FileHeaderSize && std::equal(std::begin(s_fileMagic), std::end(s_fileMagic), data) && data[4] == FormatVersion;
+}
+
+void records::AppendGame(std::vector<brU8>& payload, GameRecord const& record)
+{
+	brU8 const numPlacements = std::min<brU8>(record.NumPlacements, QUARTO_BOARD_AVAILABLE_SLOTS);
+	brBool const hasSearchStats = std::any_of(record.Placements, record.Placements + numPlacements,
+		[](PlacementRecord const& placement) { return placement.SearchIterations > 0; });
+
+	payload.push_back(static_cast<brU8>(numPlacements | (static_cast<brU8>(record.Result) << s_resultShift) | (hasSearchStats ? s_hasSearchStatsBit : 0)));
+	for (brU8 i = 0; i < numPlacements; ++i)
+	{
+		payload.push_back(static_cast<brU8>((record.Placements[i].Slot << 4) | (record.Placements[i].Token & 0xF)));
+	}
+
+	if (hasSearchStats)
+	{
+		for (brU8 i = 0; i < numPlacements; ++i)
+		{
+			PlacementRecord const& placement = record.Placements[i];
+			AppendVarint(payload, placement.SearchIterations);
+			payload.push_back(static_cast<brU8>(std::lround(std::min(std::max(placement.SearchWinRate, 0.f), 1.f) * 255.f)));
+		}
+	}
+}
+
+void records::AppendBlock(std::vector<brU8>& buffer, brU8 const* payload, size_t payloadSize, brU32 numGames)
+{
+	AppendU32(buffer, static_cast<brU32>(payloadSize));
+	AppendU32(buffer, numGames);
+	AppendU32(buffer, ComputeCrc32(payload, payloadSize));
+	buffer.insert(buffer.end(), payload, payload + payloadSize);
+}
+
+GameRecordReader::GameRecordReader(brU8 const* data, size_t size)
+	: m_data(data)
+	, m_size(size)
+	, m_isValidFile(records::IsValidFileHeader(data, size))
+{
+	m_position = m_isValidFile ? records::FileHeaderSize : size;
+}
+
+brBool GameRecordReader::Next(GameRecord& record)
+{
+	while (true)
+	{
+		while (m_numBlockGamesLeft == 0)
+		{
+			if (!EnterNextBlock())
+			{
+				return false;
+			}
+		}
+
+		if (ReadGame(m_blockPosition, m_blockEnd, record))
+		{
+			--m_numBlockGamesLeft;
+			return true;
+		}
+
+		//a checksum collision or a writer bug, the rest of the block can't be trusted
+		++m_numCorruptBlocks;
+		m_numBlockGamesLeft = 0;
+	}
+}
+
+brBool GameRecordReader::EnterNextBlock()
+{
+	while (m_size - m_position >= records::BlockHeaderSize)
+	{
+		brU8 const* const header = m_data + m_position;
+		brU32 const payloadSize = ReadU32(header);
+		brU32 const numGames = ReadU32(header + 4);
+		brU32 const crc = ReadU32(header + 8);
+		if (m_size - m_position - records::BlockHeaderSize < payloadSize)
+		{
+			break;
+		}
+
+		brU8 const* const payload = header + records::BlockHeaderSize;
+		m_position += records::BlockHeaderSize + payloadSize;
+		if (ComputeCrc32(payload, payloadSize) != crc)
+		{
+			++m_numCorruptBlocks;
+			continue;
+		}
+
+		m_blockPosition = payload;
+		m_blockEnd = payload + payloadSize;
+		m_numBlockGamesLeft = numGames;
+		return true;
+	}
+
+	if (m_position < m_size)
+	{
+		m_isTruncated = true;
+		m_position = m_size;
+	}
+	return false;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "QuartoCore/Board/Board.h"
+
+#include <cstddef>
+#include <vector>
+
+// Append-only record files of finished games, all integers little endian
+//   file header: "QREC", u8 version, 3 reserved bytes
+//   blocks:      u32 payload size, u32 number of games, u32 CRC-32 of the payload, payload
+//   game:        u8 header: bits 0-4 number of placements, bits 5-6 GameResult, bit 7 search stats follow
+//                one byte per placement: slot << 4 | token, the first player places the first token
+//                with search stats, per placement: iterations of the search as LEB128 varint, u8 win rate * 255
+// A torn block at the end of a file (e.g. after a crash) is ignored, blocks with a wrong checksum are skipped
+
+namespace quarto
+{
+	enum class GameResult : brU8
+	{
+		Draw,
+		FirstPlayerWon,
+		SecondPlayerWon,
+		Unfinished
+	};
+
+	struct PlacementRecord
+	{
+		SlotIndex Slot = InvalidSlot;
+		TokenId Token = InvalidToken;
+		// Search which chose the slot, 0 for placements of human players
+		brU32 SearchIterations = 0;
+		// Estimated by that search for the placing player, stored with 8 bits
+		brFloat SearchWinRate = 0.f;
+	};
+
+	// One game, fixed size so records can be queued without allocations
+	struct GameRecord
+	{
+		void Reset() { NumPlacements = 0; Result = GameResult::Unfinished; }
+		// Ignored once the board is full
+		void AddPlacement(SlotIndex slot, TokenId token, brU32 searchIterations = 0, brFloat searchWinRate = 0.f);
+		// Plays the placements on an empty board, false if one of them is illegal
+		brBool Replay(Board& board) const;
+
+		PlacementRecord Placements[QUARTO_BOARD_AVAILABLE_SLOTS];
+		brU8 NumPlacements = 0;
+		GameResult Result = GameResult::Unfinished;
+	};
+
+	namespace records
+	{
+		constexpr brU8 FormatVersion = 1;
+		constexpr size_t FileHeaderSize = 8;
+		constexpr size_t BlockHeaderSize = 12;
+
+		QUARTOCORE_API void AppendFileHeader(std::vector<brU8>& buffer);
+		// False if the data doesn't start with the header of a supported version
+		QUARTOCORE_API brBool IsValidFileHeader(brU8 const* data, size_t size);
+		QUARTOCORE_API void AppendGame(std::vector<brU8>& payload, GameRecord const& record);
+		QUARTOCORE_API void AppendBlock(std::vector<brU8>& buffer, brU8 const* payload, size_t payloadSize, brU32 numGames);
+	}
+
+	// Reads the games of a whole record file in memory (or mapped into it), block by block
+	class QUARTOCORE_API GameRecordReader
+	{
+	public:
+		GameRecordReader(brU8 const* data, size_t size);
+
+		brBool IsValidFile() const { return m_isValidFile; }
+		// False at the end of the file
+		brBool Next(GameRecord& record);
+
+		// Blocks skipped because of their checksum or a malformed game
+		brU32 GetNumCorruptBlocks() const { return m_numCorruptBlocks; }
+		// The file ends with a torn block
+		brBool IsTruncated() const { return m_isTruncated; }
+
+	private:
+		// Moves to the next block with a valid checksum
+		brBool EnterNextBlock();
+
+	private:
+		brU8 const* m_data;
+		size_t m_size;
+		size_t m_position = 0;
+		brU8 const* m_blockPosition = nullptr;
+		brU8 const* m_blockEnd = nullptr;
+		brU32 m_numBlockGamesLeft = 0;
+		brU32 m_numCorruptBlocks = 0;
+		brBool m_isValidFile;
+		brBool m_isTruncated = false;
+	};
+}
@@ -0,0 +1,152 @@
+#include "QuartoCore/Records/GameRecordWriter.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+using namespace quarto;
+
+namespace
+{
+	// End of the last complete block of an existing file, found by seeking from block header to block header without reading the payloads
+	// False if it isn't a record file of this version
+	brBool FindCompleteSize(std::string const& path, brU64 fileSize, brU64& completeSize)
+	{
+		std::ifstream file(path, std::ios::binary);
+		brU8 header[records::BlockHeaderSize];
+		if (!file.read(reinterpret_cast<char*>(header), records::FileHeaderSize) || !records::IsValidFileHeader(header, records::FileHeaderSize))
+		{
+			return false;
+		}
+
+		completeSize = records::FileHeaderSize;
+		while (fileSize - completeSize >= records::BlockHeaderSize
+			&& file.seekg(static_cast<std::streamoff>(completeSize)) && file.read(reinterpret_cast<char*>(header), records::BlockHeaderSize))
+		{
+			brU32 const payloadSize = header[0] | (header[1] << 8) | (header[2] << 16) | (static_cast<brU32>(header[3]) << 24);
+			if (fileSize - completeSize - records::BlockHeaderSize < payloadSize)
+			{
+				break;
+			}
+			completeSize += records::BlockHeaderSize + payloadSize;
+		}
+		return true;
+	}
+}
+
+GameRecordWriter::GameRecordWriter(std::string const& path)
+{
+	//an existing file is only appended to if it is a record file of this version
+	std::error_code error;
+	brU64 const fileSize = std::filesystem::file_size(path, error);
+	if (!error && fileSize > 0)
+	{
+		brU64 completeSize = 0;
+		if (!FindCompleteSize(path, fileSize, completeSize))
+		{
+			return;
+		}
+
+		//the reader would skip the declared size of a torn block at the end into the appended games, so it is cut off first
+		if (completeSize < fileSize)
+		{
+			std::filesystem::resize_file(path, completeSize, error);
+			if (error)
+			{
+				return;
+			}
+		}
+	}
+	m_file = std::fopen(path.c_str(), "ab");
+
+	if (m_file && std::fseek(m_file, 0, SEEK_END) == 0 && std::ftell(m_file) == 0)
+	{
+		std::vector<brU8> header;
+		records::AppendFileHeader(header);
+		std::fwrite(header.data(), 1, header.size(), m_file);
+		std::fflush(m_file);
+	}
+
+	if (m_file)
+	{
+		m_payload.reserve(MaxBlockBytes + 256);
+		m_thread = std::thread(&GameRecordWriter::Run, this);
+	}
+}
+
+GameRecordWriter::~GameRecordWriter()
+{
+	if (m_thread.joinable())
+	{
+		m_isStopRequested = true;
+		m_thread.join();
+	}
+	if (m_file)
+	{
+		std::fclose(m_file);
+	}
+}
+
+brBool GameRecordWriter::Push(GameRecord const& record)
+{
+	if (!m_file || !m_queue.Push(record))
+	{
+		m_numDroppedGames.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+void GameRecordWriter::Run()
+{
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point blockStart = Clock::now();
+	GameRecord record;
+	while (true)
+	{
+		//read before popping, so every game pushed before the stop request is still written
+		brBool const isStopRequested = m_isStopRequested;
+		brBool isQueueEmpty = true;
+		while (m_queue.Pop(record))
+		{
+			isQueueEmpty = false;
+			if (m_numBlockGames == 0)
+			{
+				blockStart = Clock::now();
+			}
+			records::AppendGame(m_payload, record);
+			++m_numBlockGames;
+			if (m_payload.size() >= MaxBlockBytes)
+			{
+				WriteBlock();
+			}
+		}
+
+		if (m_numBlockGames > 0 && (isStopRequested || std::chrono::duration<brDouble>(Clock::now() - blockStart).count() >= MaxBlockSeconds))
+		{
+			WriteBlock();
+		}
+		if (isStopRequested)
+		{
+			return;
+		}
+		if (isQueueEmpty)
+		{
+			//games finish seconds apart, polling costs less than waking the thread from the game thread
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+	}
+}
+
+void GameRecordWriter::WriteBlock()
+{
+	m_block.clear();
+	records::AppendBlock(m_block, m_payload.data(), m_payload.size(), m_numBlockGames);
+	std::fwrite(m_block.data(), 1, m_block.size(), m_file);
+	std::fflush(m_file);
+
+	m_numWrittenGames.fetch_add(m_numBlockGames, std::memory_order_relaxed);
+	m_payload.clear();
+	m_numBlockGames = 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "QuartoCore/Common/SpscQueue.h"
+#include "QuartoCore/Records/GameRecord.h"
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace quarto
+{
+	// Appends finished games to a record file on its own I/O thread
+	// Push never waits, so recording doesn't cost the game thread more than copying the record into a lock-free queue
+	// Only one thread may push at a time, the queue is single producer
+	class QUARTOCORE_API GameRecordWriter
+	{
+	public:
+		// Games are written in blocks of up to this size, a block is also written once it is older than MaxBlockSeconds
+		static constexpr size_t MaxBlockBytes = 64 * 1024;
+		static constexpr brDouble MaxBlockSeconds = 1.0;
+
+		// Appends to an existing record file, a new one is created with its header
+		// A torn block at the end of an existing file is cut off, the games appended after it would be lost otherwise
+		explicit GameRecordWriter(std::string const& path);
+		// Writes all queued games
+		~GameRecordWriter();
+		GameRecordWriter(GameRecordWriter const&) = delete;
+		GameRecordWriter& operator=(GameRecordWriter const&) = delete;
+
+		// False if the file can't be written or isn't a record file of this version, all games are dropped then
+		brBool IsOpen() const { return m_file != nullptr; }
+		// False if the queue is full or the file isn't open, the game is dropped then
+		brBool Push(GameRecord const& record);
+
+		brU64 GetNumWrittenGames() const { return m_numWrittenGames.load(std::memory_order_relaxed); }
+		brU64 GetNumDroppedGames() const { return m_numDroppedGames.load(std::memory_order_relaxed); }
+
+	private:
+		void Run();
+		void WriteBlock();
+
+	private:
+		std::FILE* m_file = nullptr;
+		SpscQueue<GameRecord, 1024> m_queue;
+		std::atomic<brBool> m_isStopRequested { false };
+		std::atomic<brU64> m_numWrittenGames { 0 };
+		std::atomic<brU64> m_numDroppedGames { 0 };
+
+		// I/O thread only
+		std::vector<brU8> m_payload;
+		std::vector<brU8> m_block;
+		brU32 m_numBlockGames = 0;
+		std::thread m_thread;
+	};
+}
@@ -0,0 +1,132 @@
+// The line state the board keeps up to date has to match the lines recomputed from the slots, after placing and removing tokens in any order
+
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/Common/Random.h"
+
+#include <cstdio>
+
+using namespace quarto;
+
+namespace
+{
+	brU32 s_numFailures = 0;
+
+#define CHECK_EQUAL(actual, expected) \
+	if ((actual) != (expected)) \
+	{ \
+		std::printf("%s:%d: %s is %llu, expected %llu\n", __FILE__, __LINE__, #actual, static_cast<unsigned long long>(actual), static_cast<unsigned long long>(expected)); \
+		++s_numFailures; \
+	}
+
+	// Reference of the tactics: every placement tried on a copy of the board, only the lines through the slot count like for HasWinningLineThrough
+	brBool IsWinningPlacement(Board board, SlotIndex slot, TokenId token)
+	{
+		board.SetTokenOnBoard(slot, token);
+		for (SlotIndex const (&line)[4] : Board::s_lines)
+		{
+			if (line[0] != slot && line[1] != slot && line[2] != slot && line[3] != slot)
+			{
+				continue;
+			}
+
+			brU32 numTokens = 0;
+			brU32 sharedAttributes = TokenAttribute_All | (TokenAttribute_All << 4);
+			for (SlotIndex lineSlot : line)
+			{
+				if (!board.IsSlotEmpty(lineSlot))
+				{
+					++numTokens;
+					sharedAttributes &= board.GetToken(lineSlot) | (~board.GetToken(lineSlot) << 4);
+				}
+			}
+			if (numTokens == 4 && sharedAttributes != 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	brU16 GetWinningSlotsMask(Board const& board, TokenId token)
+	{
+		brU16 slots = 0;
+		for (SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+		{
+			slots |= board.IsSlotEmpty(slot) && IsWinningPlacement(board, slot, token) ? 1u << slot : 0u;
+		}
+		return slots;
+	}
+
+	brU16 GetCompletingTokensMask(Board const& board)
+	{
+		brU16 tokens = 0;
+		for (TokenId token = 0; token < NumTokens; ++token)
+		{
+			tokens |= board.IsTokenFree(token) && GetWinningSlotsMask(board, token) ? 1u << token : 0u;
+		}
+		return tokens;
+	}
+
+	void CheckBoard(Board const& board, Random& random)
+	{
+		CHECK_EQUAL(board.GetCompletingTokensMask(), GetCompletingTokensMask(board));
+		for (TokenId token = 0; token < NumTokens; ++token)
+		{
+			CHECK_EQUAL(board.GetWinningSlotsMask(token), GetWinningSlotsMask(board, token));
+			CHECK_EQUAL(board.IsTokenSafe(token), board.IsTokenFree(token) && !GetWinningSlotsMask(board, token));
+		}
+
+		//one placement which doesn't win, the tokens which complete a line afterwards
+		if (!board.GetEmptySlotsMask() || !board.GetFreeTokensMask())
+		{
+			return;
+		}
+		SlotIndex slot;
+		TokenId token;
+		do { slot = static_cast<SlotIndex>(random.NextBelow(QUARTO_BOARD_AVAILABLE_SLOTS)); } while (!board.IsSlotEmpty(slot));
+		do { token = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!board.IsTokenFree(token));
+		if (!IsWinningPlacement(board, slot, token))
+		{
+			Board boardAfter = board;
+			boardAfter.SetTokenOnBoard(slot, token);
+			CHECK_EQUAL(board.GetCompletingTokensMaskAfter(slot, token), GetCompletingTokensMask(boardAfter));
+		}
+	}
+
+	void CheckLineState()
+	{
+		std::printf("line state\n");
+		Random random(13);
+		for (brU32 game = 0; game < 500; ++game)
+		{
+			Board board;
+			for (brU32 step = 0; step < 24; ++step)
+			{
+				//mostly placements, sometimes a token is taken back
+				if (board.GetEmptySlotsMask() != 0xFFFF && random.NextBelow(4) == 0)
+				{
+					SlotIndex slot;
+					do { slot = static_cast<SlotIndex>(random.NextBelow(QUARTO_BOARD_AVAILABLE_SLOTS)); } while (board.IsSlotEmpty(slot));
+					board.RemoveTokenFromBoard(slot);
+				}
+				else if (board.GetEmptySlotsMask())
+				{
+					SlotIndex slot;
+					TokenId token;
+					do { slot = static_cast<SlotIndex>(random.NextBelow(QUARTO_BOARD_AVAILABLE_SLOTS)); } while (!board.IsSlotEmpty(slot));
+					do { token = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!board.IsTokenFree(token));
+					board.SetTokenOnBoard(slot, token);
+				}
+				CheckBoard(board, random);
+			}
+		}
+	}
+}
+
+int main()
+{
+	CheckLineState();
+
+	std::printf(s_numFailures == 0 ? "passed\n" : "%u checks failed\n", s_numFailures);
+	return s_numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+// Regression test of the deterministic search mode: the same request has to result in the same tree and decision
+// The expected node counts and decisions change with every change of the search, update them deliberately
+
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/MCTS/SearchTree.h"
+
+#include <cstdio>
+
+using namespace ai::mcts;
+
+namespace
+{
+	brU32 s_numFailures = 0;
+
+#define CHECK_EQUAL(actual, expected) \
+	if ((actual) != (expected)) \
+	{ \
+		std::printf("%s:%d: %s is %llu, expected %llu\n", __FILE__, __LINE__, #actual, static_cast<unsigned long long>(actual), static_cast<unsigned long long>(expected)); \
+		++s_numFailures; \
+	}
+
+	struct TestCase
+	{
+		char const* Name;
+		// Token ids by slot, -1 for an empty slot
+		brS8 Slots[QUARTO_BOARD_AVAILABLE_SLOTS];
+		quarto::TokenId Token;
+		brU32 ExpectedNumNodes;
+		Action ExpectedAction;
+		Action ExpectedParallelAction;
+	};
+
+	SearchSettings MakeSettings(brU32 numThreads)
+	{
+		SearchSettings settings;
+		settings.UseDeterministicSearch = true;
+		settings.RandomSeed = 42;
+		settings.NumThreads = numThreads;
+		return settings;
+	}
+
+	SearchRequest MakeRequest(TestCase const& test)
+	{
+		SearchRequest request;
+		for (brU8 slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+		{
+			if (test.Slots[slot] >= 0)
+			{
+				request.Board.SetTokenOnBoard(slot, static_cast<quarto::TokenId>(test.Slots[slot]));
+			}
+		}
+		request.Token = test.Token;
+		request.Budget.MaxIterations = 4000;
+		//ignored in the deterministic mode
+		request.Budget.MaxSeconds = 0.001f;
+		return request;
+	}
+
+	void RunTest(TestCase const& test)
+	{
+		std::printf("%s\n", test.Name);
+		SearchSettings const settings = MakeSettings(1);
+		SearchRequest const request = MakeRequest(test);
+
+		SearchTree first(settings, request, settings.RandomSeed);
+		SearchTree second(settings, request, settings.RandomSeed);
+		while (!first.IsFinished())
+		{
+			first.Iterate();
+		}
+		while (!second.IsFinished())
+		{
+			second.Iterate();
+		}
+
+		CHECK_EQUAL(first.ComputeChecksum(), second.ComputeChecksum());
+		CHECK_EQUAL(first.GetBudget().GetNumIterations(), second.GetBudget().GetNumIterations());
+		CHECK_EQUAL(first.GetBudget().GetNumNodes(), test.ExpectedNumNodes);
+		CHECK_EQUAL(first.GetResult().BestAction, test.ExpectedAction);
+		CHECK_EQUAL(RunSearch(settings, request).BestAction, test.ExpectedAction);
+
+		SearchSettings const parallelSettings = MakeSettings(4);
+		CHECK_EQUAL(RunSearch(parallelSettings, request).BestAction, test.ExpectedParallelAction);
+		CHECK_EQUAL(RunSearch(parallelSettings, request).BestAction, test.ExpectedParallelAction);
+	}
+}
+
+int main()
+{
+	TestCase const tests[] =
+	{
+		{
+			"empty board",
+			{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+			0, 8000, MakeAction(8, 0), MakeAction(8, 0)
+		},
+		{
+			"mid game",
+			{ 3, -1, 12, -1, -1, 5, -1, -1, 9, -1, -1, 0, -1, 14, -1, -1 },
+			6, 10505, MakeAction(4, 6), MakeAction(14, 6)
+		},
+		{
+			"opponent token",
+			{ 3, -1, 12, -1, -1, 5, -1, -1, 9, -1, 6, 0, -1, 14, -1, -1 },
+			quarto::InvalidToken, 9861, MakeAction(7, 13), MakeAction(7, 13)
+		},
+	};
+
+	for (TestCase const& test : tests)
+	{
+		RunTest(test);
+	}
+
+	std::printf(s_numFailures == 0 ? "passed\n" : "%u checks failed\n", s_numFailures);
+	return s_numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+# Scripted engine session: go nodes alone is refused instead of searching forever, with an iteration limit it answers,
+# a node limit of the options without a time limit is stopped at the end of the input like infinite
+# Run with cmake -DENGINE=<QuartoEngine> -DWORKING_DIRECTORY=<dir> -P EngineGoNodesTest.cmake
+
+set(input "${WORKING_DIRECTORY}/EngineGoNodesTest.in")
+file(WRITE "${input}" "quarto\nnewgame\nposition startpos\ngo nodes 1000\ngo nodes 1000 iterations 2000\nsetoption name seconds value 0\nsetoption name nodes value 1000\ngo\n")
+execute_process(COMMAND "${ENGINE}" INPUT_FILE "${input}" OUTPUT_VARIABLE output RESULT_VARIABLE result TIMEOUT 10)
+file(REMOVE "${input}")
+
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "the engine didn't finish: ${result}\n${output}")
+endif()
+if(NOT output MATCHES "info string nodes only caps the tree")
+	message(FATAL_ERROR "go nodes without another limit wasn't refused\n${output}")
+endif()
+string(REGEX MATCHALL "bestmove ([a-d][1-4]|[0-9]+)" bestMoves "${output}")
+list(LENGTH bestMoves numBestMoves)
+if(NOT numBestMoves EQUAL 2)
+	message(FATAL_ERROR "expected 2 decisions, got ${numBestMoves}\n${output}")
+endif()
@@ -0,0 +1,176 @@
+// Round trip of the game record format: encoded games have to be read back unchanged,
+// corrupt and torn blocks must be skipped without losing the games of the other blocks
+
+#include "QuartoCore/Records/GameRecord.h"
+#include "QuartoCore/Records/GameRecordWriter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+
+using namespace quarto;
+
+namespace
+{
+	brU32 s_numFailures = 0;
+
+#define CHECK_EQUAL(actual, expected) \
+	if ((actual) != (expected)) \
+	{ \
+		std::printf("%s:%d: %s is %llu, expected %llu\n", __FILE__, __LINE__, #actual, static_cast<unsigned long long>(actual), static_cast<unsigned long long>(expected)); \
+		++s_numFailures; \
+	}
+
+	// Game number i: a row of i + 1 placements, with search stats for odd games
+	GameRecord MakeGame(brU32 i)
+	{
+		GameRecord record;
+		brU8 const numPlacements = static_cast<brU8>(i % QUARTO_BOARD_AVAILABLE_SLOTS + 1);
+		for (brU8 placement = 0; placement < numPlacements; ++placement)
+		{
+			SlotIndex const slot = static_cast<SlotIndex>((placement * 5 + i) % QUARTO_BOARD_AVAILABLE_SLOTS);
+			TokenId const token = static_cast<TokenId>((placement * 7 + i) % NumTokens);
+			record.AddPlacement(slot, token, i % 2 ? 100000 + placement : 0, i % 2 ? 0.5f : 0.f);
+		}
+		record.Result = static_cast<GameResult>(i % 4);
+		return record;
+	}
+
+	void CheckGame(GameRecord const& actual, brU32 i)
+	{
+		GameRecord const expected = MakeGame(i);
+		CHECK_EQUAL(actual.NumPlacements, expected.NumPlacements);
+		CHECK_EQUAL(static_cast<brU8>(actual.Result), static_cast<brU8>(expected.Result));
+		for (brU8 placement = 0; placement < expected.NumPlacements && placement < actual.NumPlacements; ++placement)
+		{
+			CHECK_EQUAL(actual.Placements[placement].Slot, expected.Placements[placement].Slot);
+			CHECK_EQUAL(actual.Placements[placement].Token, expected.Placements[placement].Token);
+			CHECK_EQUAL(actual.Placements[placement].SearchIterations, expected.Placements[placement].SearchIterations);
+			//the win rate is stored with 8 bits
+			CHECK_EQUAL(std::fabs(actual.Placements[placement].SearchWinRate - expected.Placements[placement].SearchWinRate) <= 1.f / 255.f, true);
+		}
+	}
+
+	// Blocks of ten games each
+	std::vector<brU8> MakeFile(brU32 numBlocks = 3)
+	{
+		std::vector<brU8> file;
+		records::AppendFileHeader(file);
+		for (brU32 block = 0; block < numBlocks; ++block)
+		{
+			std::vector<brU8> payload;
+			for (brU32 i = block * 10; i < block * 10 + 10; ++i)
+			{
+				records::AppendGame(payload, MakeGame(i));
+			}
+			records::AppendBlock(file, payload.data(), payload.size(), 10);
+		}
+		return file;
+	}
+
+	std::vector<brU8> ReadFile(char const* path)
+	{
+		std::vector<brU8> data;
+		if (std::FILE* file = std::fopen(path, "rb"))
+		{
+			brU8 buffer[4096];
+			for (size_t size; (size = std::fread(buffer, 1, sizeof(buffer), file)) > 0;)
+			{
+				data.insert(data.end(), buffer, buffer + size);
+			}
+			std::fclose(file);
+		}
+		return data;
+	}
+
+	brU32 ReadAll(GameRecordReader& reader, brU32 firstGame)
+	{
+		GameRecord record;
+		brU32 numGames = 0;
+		while (reader.Next(record))
+		{
+			CheckGame(record, firstGame + numGames);
+			++numGames;
+		}
+		return numGames;
+	}
+}
+
+int main()
+{
+	std::vector<brU8> file = MakeFile();
+	{
+		std::printf("round trip\n");
+		GameRecordReader reader(file.data(), file.size());
+		CHECK_EQUAL(reader.IsValidFile(), true);
+		CHECK_EQUAL(ReadAll(reader, 0), 30u);
+		CHECK_EQUAL(reader.GetNumCorruptBlocks(), 0u);
+		CHECK_EQUAL(reader.IsTruncated(), false);
+	}
+	{
+		std::printf("torn last block\n");
+		GameRecordReader reader(file.data(), file.size() - 3);
+		CHECK_EQUAL(ReadAll(reader, 0), 20u);
+		CHECK_EQUAL(reader.IsTruncated(), true);
+	}
+	{
+		std::printf("corrupt first block\n");
+		file[records::FileHeaderSize + records::BlockHeaderSize + 2] ^= 0x10;
+		GameRecordReader reader(file.data(), file.size());
+		CHECK_EQUAL(ReadAll(reader, 10), 20u);
+		CHECK_EQUAL(reader.GetNumCorruptBlocks(), 1u);
+	}
+	{
+		std::printf("append after a torn tail\n");
+		char const* const path = "GameRecordTest.torn.qrec";
+		if (std::FILE* tornFile = std::fopen(path, "wb"))
+		{
+			//one block of 10 games, then a block header which declares 100 bytes of which only 5 made it
+			std::vector<brU8> torn = MakeFile(1);
+			brU8 const tornBlock[records::BlockHeaderSize + 5] = { 100, 0, 0, 0, 1, 0, 0, 0 };
+			torn.insert(torn.end(), std::begin(tornBlock), std::end(tornBlock));
+			std::fwrite(torn.data(), 1, torn.size(), tornFile);
+			std::fclose(tornFile);
+		}
+		{
+			GameRecordWriter writer(path);
+			CHECK_EQUAL(writer.IsOpen(), true);
+			for (brU32 i = 10; i < 60; ++i)
+			{
+				CHECK_EQUAL(writer.Push(MakeGame(i)), true);
+			}
+		}
+
+		std::vector<brU8> const written = ReadFile(path);
+		std::remove(path);
+		GameRecordReader reader(written.data(), written.size());
+		CHECK_EQUAL(ReadAll(reader, 0), 60u);
+		CHECK_EQUAL(reader.GetNumCorruptBlocks(), 0u);
+		CHECK_EQUAL(reader.IsTruncated(), false);
+	}
+	{
+		std::printf("writer\n");
+		char const* const path = "GameRecordTest.qrec";
+		std::remove(path);
+		for (brU32 session = 0; session < 2; ++session)
+		{
+			GameRecordWriter writer(path);
+			CHECK_EQUAL(writer.IsOpen(), true);
+			for (brU32 i = session * 15; i < session * 15 + 15; ++i)
+			{
+				CHECK_EQUAL(writer.Push(MakeGame(i)), true);
+			}
+		}
+
+		std::vector<brU8> const written = ReadFile(path);
+		std::remove(path);
+
+		GameRecordReader reader(written.data(), written.size());
+		CHECK_EQUAL(reader.IsValidFile(), true);
+		CHECK_EQUAL(ReadAll(reader, 0), 30u);
+	}
+
+	std::printf(s_numFailures == 0 ? "passed\n" : "%u checks failed\n", s_numFailures);
+	return s_numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// The tuple indices kept up to date placement by placement have to match the ones recomputed from the board,
+// the weights have to survive a round trip through their file and a file of another network must not be loaded
+
+#include "QuartoCore/Common/Random.h"
+#include "QuartoCore/Eval/NTupleNetwork.h"
+
+#include <cstdio>
+#include <vector>
+
+using namespace ai::eval;
+using namespace quarto;
+
+namespace
+{
+	brU32 s_numFailures = 0;
+
+#define CHECK_EQUAL(actual, expected) \
+	if ((actual) != (expected)) \
+	{ \
+		std::printf("%s:%d: %s is %llu, expected %llu\n", __FILE__, __LINE__, #actual, static_cast<unsigned long long>(actual), static_cast<unsigned long long>(expected)); \
+		++s_numFailures; \
+	}
+
+	void CheckState(NTupleState const& state, Board const& board)
+	{
+		NTupleState const reference(board);
+		for (brU8 tuple = 0; tuple < NTupleState::NumTuples; ++tuple)
+		{
+			CHECK_EQUAL(state.GetIndex(tuple), reference.GetIndex(tuple));
+		}
+	}
+
+	void CheckIncrementalState()
+	{
+		std::printf("incremental state\n");
+		Random random(17);
+		for (brU32 game = 0; game < 500; ++game)
+		{
+			Board board;
+			NTupleState state;
+			for (brU32 step = 0; step < 24; ++step)
+			{
+				//mostly placements, sometimes a token is taken back
+				if (board.GetEmptySlotsMask() != 0xFFFF && random.NextBelow(4) == 0)
+				{
+					SlotIndex slot;
+					do { slot = static_cast<SlotIndex>(random.NextBelow(QUARTO_BOARD_AVAILABLE_SLOTS)); } while (board.IsSlotEmpty(slot));
+					state.RemoveToken(slot, board.GetToken(slot));
+					board.RemoveTokenFromBoard(slot);
+				}
+				else if (board.GetEmptySlotsMask())
+				{
+					SlotIndex slot;
+					TokenId token;
+					do { slot = static_cast<SlotIndex>(random.NextBelow(QUARTO_BOARD_AVAILABLE_SLOTS)); } while (!board.IsSlotEmpty(slot));
+					do { token = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!board.IsTokenFree(token));
+					state.SetToken(slot, token);
+					board.SetTokenOnBoard(slot, token);
+				}
+				CheckState(state, board);
+			}
+		}
+	}
+
+	std::vector<Board> MakeRandomBoards(Random& random, brU32 numBoards)
+	{
+		std::vector<Board> boards(numBoards);
+		for (brU32 i = 0; i < numBoards; ++i)
+		{
+			for (brU32 numTokens = i % QUARTO_BOARD_AVAILABLE_SLOTS; numTokens > 0; --numTokens)
+			{
+				SlotIndex slot;
+				TokenId token;
+				do { slot = static_cast<SlotIndex>(random.NextBelow(QUARTO_BOARD_AVAILABLE_SLOTS)); } while (!boards[i].IsSlotEmpty(slot));
+				do { token = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!boards[i].IsTokenFree(token));
+				boards[i].SetTokenOnBoard(slot, token);
+			}
+		}
+		return boards;
+	}
+
+	void CheckFile()
+	{
+		std::printf("file\n");
+		Random random(19);
+		std::vector<Board> const boards = MakeRandomBoards(random, 50);
+
+		//a few training steps towards random targets, so the weights differ from the zeros of a new network
+		NTupleNetwork network;
+		for (brU32 step = 0; step < 200; ++step)
+		{
+			network.Train(NTupleState(boards[step % boards.size()]), random.NextBelow(2) ? 1.f : 0.f, 0.1f);
+		}
+
+		char const* const path = "NTupleNetworkTest.qntn";
+		char const* const mismatchedPath = "NTupleNetworkTest.mismatched.qntn";
+		CHECK_EQUAL(network.Save(path), true);
+		NTupleNetwork loaded;
+		CHECK_EQUAL(loaded.Load(path), true);
+		for (Board const& board : boards)
+		{
+			NTupleState const state(board);
+			CHECK_EQUAL(loaded.Evaluate(state) == network.Evaluate(state), true);
+		}
+
+		//the same file with one tuple less, as written by another version of the network
+		std::vector<brU8> data;
+		if (std::FILE* file = std::fopen(path, "rb"))
+		{
+			brU8 buffer[4096];
+			for (size_t size; (size = std::fread(buffer, 1, sizeof(buffer), file)) > 0;)
+			{
+				data.insert(data.end(), buffer, buffer + size);
+			}
+			std::fclose(file);
+		}
+		CHECK_EQUAL(data.size() > 8, true);
+		if (data.size() > 8)
+		{
+			data[8] = NTupleState::NumTuples - 1;
+		}
+		if (std::FILE* file = std::fopen(mismatchedPath, "wb"))
+		{
+			std::fwrite(data.data(), 1, data.size(), file);
+			std::fclose(file);
+		}
+
+		NTupleNetwork unchanged;
+		CHECK_EQUAL(unchanged.Load(mismatchedPath), false);
+		CHECK_EQUAL(unchanged.Load("NTupleNetworkTest.missing"), false);
+		for (Board const& board : boards)
+		{
+			CHECK_EQUAL(unchanged.Evaluate(NTupleState(board)) == 0.5f, true);
+		}
+		std::remove(path);
+		std::remove(mismatchedPath);
+	}
+}
+
+int main()
+{
+	CheckIncrementalState();
+	CheckFile();
+
+	std::printf(s_numFailures == 0 ? "passed\n" : "%u checks failed\n", s_numFailures);
+	return s_numFailures == 0 ? 0 : 1;
+}
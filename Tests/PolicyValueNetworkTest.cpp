@@ -0,0 +1,162 @@
+// The quantized kernels have to follow the float network, the priors have to be a distribution over the legal placements,
+// the weights have to survive a round trip through their file and the training has to fit a position
+
+#include "QuartoCore/Eval/PolicyValueNetwork.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+using namespace ai::eval;
+using namespace quarto;
+
+namespace
+{
+	brU32 s_numFailures = 0;
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+	if (!(std::fabs((actual) - (expected)) <= (tolerance))) \
+	{ \
+		std::printf("%s:%d: %s is %f, expected %f\n", __FILE__, __LINE__, #actual, static_cast<double>(actual), static_cast<double>(expected)); \
+		++s_numFailures; \
+	}
+
+	Board MakeRandomBoard(Random& random, brU32 numTokens)
+	{
+		Board board;
+		for (brU32 i = 0; i < numTokens; ++i)
+		{
+			SlotIndex slot;
+			TokenId token;
+			do { slot = static_cast<SlotIndex>(random.NextBelow(QUARTO_BOARD_AVAILABLE_SLOTS)); } while (!board.IsSlotEmpty(slot));
+			do { token = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!board.IsTokenFree(token));
+			board.SetTokenOnBoard(slot, token);
+		}
+		return board;
+	}
+
+	TokenId PickFreeToken(Random& random, Board const& board)
+	{
+		TokenId token;
+		do { token = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!board.IsTokenFree(token));
+		return token;
+	}
+
+	void CheckQuantization(PolicyValueNetwork const& network)
+	{
+		std::printf("quantization\n");
+		Random random(3);
+		for (brU32 test = 0; test < 200; ++test)
+		{
+			Board const board = MakeRandomBoard(random, test % QUARTO_BOARD_AVAILABLE_SLOTS);
+			TokenId const token = test % 2 ? PickFreeToken(random, board) : InvalidToken;
+			PolicyValue quantized;
+			PolicyValue reference;
+			network.Evaluate(board, token, quantized);
+			network.EvaluateReference(board, token, reference);
+			CHECK_NEAR(quantized.Value, reference.Value, 0.02f);
+			for (brU32 i = 0; i < QUARTO_BOARD_AVAILABLE_SLOTS; ++i)
+			{
+				CHECK_NEAR(quantized.SlotLogits[i], reference.SlotLogits[i], 0.1f);
+				CHECK_NEAR(quantized.TokenLogits[i], reference.TokenLogits[i], 0.1f);
+			}
+		}
+	}
+
+	void CheckPriors(PolicyValueNetwork const& network)
+	{
+		std::printf("priors\n");
+		Random random(5);
+		for (brU32 test = 0; test < 100; ++test)
+		{
+			Board const board = MakeRandomBoard(random, test % (QUARTO_BOARD_AVAILABLE_SLOTS - 1));
+			TokenId const token = test % 2 ? PickFreeToken(random, board) : InvalidToken;
+			brFloat priors[PolicyValueNetwork::NumPlacements];
+			brFloat const value = network.EvaluatePriors(board, token, priors);
+
+			PolicyValue output;
+			network.Evaluate(board, token, output);
+			CHECK_NEAR(value, output.Value, 0.f);
+
+			brFloat sum = 0.f;
+			brFloat illegalSum = 0.f;
+			for (brU32 placement = 0; placement < PolicyValueNetwork::NumPlacements; ++placement)
+			{
+				SlotIndex const slot = static_cast<SlotIndex>(placement >> 4);
+				TokenId const placedToken = static_cast<TokenId>(placement & 0x0F);
+				brBool const isLegal = board.IsSlotEmpty(slot) && (token == InvalidToken ? board.IsTokenFree(placedToken) : placedToken == token);
+				(isLegal ? sum : illegalSum) += priors[placement];
+			}
+			CHECK_NEAR(sum, 1.f, 1e-4f);
+			CHECK_NEAR(illegalSum, 0.f, 0.f);
+		}
+	}
+
+	void CheckFile(PolicyValueNetwork const& network)
+	{
+		std::printf("file\n");
+		std::unique_ptr<PolicyValueNetwork> loaded = std::make_unique<PolicyValueNetwork>();
+		CHECK_NEAR(network.Save("PolicyValueNetworkTest.qpvn") ? 1.f : 0.f, 1.f, 0.f);
+		CHECK_NEAR(loaded->Load("PolicyValueNetworkTest.qpvn") ? 1.f : 0.f, 1.f, 0.f);
+		CHECK_NEAR(loaded->Load("PolicyValueNetworkTest.missing") ? 1.f : 0.f, 0.f, 0.f);
+
+		Random random(9);
+		for (brU32 test = 0; test < 20; ++test)
+		{
+			Board const board = MakeRandomBoard(random, test % QUARTO_BOARD_AVAILABLE_SLOTS);
+			PolicyValue expected;
+			PolicyValue actual;
+			network.Evaluate(board, InvalidToken, expected);
+			loaded->Evaluate(board, InvalidToken, actual);
+			CHECK_NEAR(actual.Value, expected.Value, 0.f);
+			CHECK_NEAR(actual.TokenLogits[test % NumTokens], expected.TokenLogits[test % NumTokens], 0.f);
+		}
+	}
+
+	void CheckTraining(PolicyValueNetwork& network)
+	{
+		std::printf("training\n");
+		Random random(11);
+		Board const board = MakeRandomBoard(random, 6);
+		TokenId const token = PickFreeToken(random, board);
+		SlotIndex targetSlot = 0;
+		while (!board.IsSlotEmpty(targetSlot))
+		{
+			++targetSlot;
+		}
+		brFloat policyTarget[QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+		policyTarget[targetSlot] = 1.f;
+
+		brFloat const firstLoss = network.Train(board, token, 1.f, policyTarget, 0.05f);
+		brFloat loss = firstLoss;
+		for (brU32 step = 0; step < 200; ++step)
+		{
+			loss = network.Train(board, token, 1.f, policyTarget, 0.05f);
+		}
+		network.Quantize();
+		CHECK_NEAR(loss < 0.25f * firstLoss ? 1.f : 0.f, 1.f, 0.f);
+
+		PolicyValue output;
+		network.Evaluate(board, token, output);
+		CHECK_NEAR(output.Value > 0.8f ? 1.f : 0.f, 1.f, 0.f);
+		CHECK_NEAR(static_cast<brFloat>(std::max_element(output.SlotLogits, output.SlotLogits + QUARTO_BOARD_AVAILABLE_SLOTS) - output.SlotLogits), static_cast<brFloat>(targetSlot), 0.f);
+	}
+}
+
+int main()
+{
+	//larger than the usual stack frame
+	std::unique_ptr<PolicyValueNetwork> network = std::make_unique<PolicyValueNetwork>();
+	Random random(1);
+	network->Randomize(random);
+
+	CheckQuantization(*network);
+	CheckPriors(*network);
+	CheckFile(*network);
+	CheckTraining(*network);
+	CheckQuantization(*network);
+
+	std::printf(s_numFailures == 0 ? "passed\n" : "%u checks failed\n", s_numFailures);
+	return s_numFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+// The symmetries have to keep the winning lines, and all equivalent positions have to share one canonical form
+
+#include "QuartoCore/Board/Symmetry.h"
+#include "QuartoCore/Common/Random.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+using namespace quarto;
+
+namespace
+{
+	brU32 s_numFailures = 0;
+
+#define CHECK_EQUAL(actual, expected) \
+	if ((actual) != (expected)) \
+	{ \
+		std::printf("%s:%d: %s is %llu, expected %llu\n", __FILE__, __LINE__, #actual, static_cast<unsigned long long>(actual), static_cast<unsigned long long>(expected)); \
+		++s_numFailures; \
+	}
+
+	// Bit i is set if line i of Board::s_lines contains all of the given slots
+	brU16 GetLinesMask(SlotIndex const (&slots)[4])
+	{
+		brU16 mask = 0;
+		for (brU8 line = 0; line < Board::NumLines; ++line)
+		{
+			brBool const isLine = std::all_of(std::begin(slots), std::end(slots), [line](SlotIndex slot) { return std::count(std::begin(Board::s_lines[line]), std::end(Board::s_lines[line]), slot) == 1; });
+			mask |= isLine ? 1u << line : 0u;
+		}
+		return mask;
+	}
+
+	void CheckBoardSymmetries()
+	{
+		std::printf("board symmetries\n");
+		auto const& symmetries = Symmetry::GetBoardSymmetries();
+		for (brU8 i = 0; i < Symmetry::NumBoardSymmetries; ++i)
+		{
+			for (brU8 line = 0; line < Board::NumLines; ++line)
+			{
+				SlotIndex transformed[4];
+				std::transform(std::begin(Board::s_lines[line]), std::end(Board::s_lines[line]), transformed, [&](SlotIndex slot) { return symmetries[i][slot]; });
+				CHECK_EQUAL(GetLinesMask(transformed) != 0, true);
+			}
+			for (brU8 j = 0; j < i; ++j)
+			{
+				CHECK_EQUAL(std::equal(std::begin(symmetries[i]), std::end(symmetries[i]), std::begin(symmetries[j])), false);
+			}
+		}
+	}
+
+	Board MakeRandomBoard(Random& random, brU32 numTokens)
+	{
+		Board board;
+		for (brU32 i = 0; i < numTokens; ++i)
+		{
+			SlotIndex slot;
+			TokenId token;
+			do { slot = static_cast<SlotIndex>(random.NextBelow(QUARTO_BOARD_AVAILABLE_SLOTS)); } while (!board.IsSlotEmpty(slot));
+			do { token = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!board.IsTokenFree(token));
+			board.SetTokenOnBoard(slot, token);
+		}
+		return board;
+	}
+
+	TokenId PickFreeToken(Random& random, Board const& board)
+	{
+		if (board.GetNumberOfFreeTokens() == 0)
+		{
+			return InvalidToken;
+		}
+		TokenId token;
+		do { token = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!board.IsTokenFree(token));
+		return token;
+	}
+
+	void CheckCanonicalForms()
+	{
+		std::printf("canonical forms\n");
+		Random random(7);
+		for (brU32 test = 0; test < 200; ++test)
+		{
+			Board const board = MakeRandomBoard(random, test % QUARTO_BOARD_AVAILABLE_SLOTS);
+			TokenId const token = test % 3 ? PickFreeToken(random, board) : InvalidToken;
+			Symmetry const canonical = FindCanonicalSymmetry(board, token);
+			Board const canonicalBoard = canonical.TransformBoard(board);
+			TokenId const canonicalToken = canonical.TransformToken(token);
+			CHECK_EQUAL(canonicalBoard.HasWinningLine(), board.HasWinningLine());
+			CHECK_EQUAL(canonicalBoard.GetNumberOfThreatLines(), board.GetNumberOfThreatLines());
+
+			//a random equivalent position
+			Symmetry other;
+			auto const& symmetries = Symmetry::GetBoardSymmetries();
+			brU32 const boardSymmetry = random.NextBelow(Symmetry::NumBoardSymmetries);
+			std::copy(std::begin(symmetries[boardSymmetry]), std::end(symmetries[boardSymmetry]), other.SlotMap);
+			std::swap(other.AttributeMap[random.NextBelow(4)], other.AttributeMap[random.NextBelow(4)]);
+			other.TokenMask = static_cast<TokenId>(random.NextBelow(NumTokens));
+			Board const otherBoard = other.TransformBoard(board);
+			TokenId const otherToken = other.TransformToken(token);
+
+			Symmetry const otherCanonical = FindCanonicalSymmetry(otherBoard, otherToken);
+			CHECK_EQUAL(otherCanonical.TransformBoard(otherBoard) == canonicalBoard, true);
+			CHECK_EQUAL(otherCanonical.TransformToken(otherToken), canonicalToken);
+		}
+	}
+}
+
+int main()
+{
+	CheckBoardSymmetries();
+	CheckCanonicalForms();
+
+	std::printf(s_numFailures == 0 ? "passed\n" : "%u checks failed\n", s_numFailures);
+	return s_numFailures == 0 ? 0 : 1;
+}
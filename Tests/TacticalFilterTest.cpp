@@ -0,0 +1,195 @@
+// The children the tactical filter leaves at the root have to match a brute force one ply look ahead, which tries every placement on a copy of the board
+
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/Common/Random.h"
+#include "QuartoCore/MCTS/SearchTree.h"
+
+#include <bitset>
+#include <cstdio>
+
+using namespace ai::mcts;
+using namespace quarto;
+
+namespace
+{
+	brU32 s_numFailures = 0;
+
+#define CHECK_EQUAL(actual, expected) \
+	if ((actual) != (expected)) \
+	{ \
+		std::printf("%s:%d: %s is %llu, expected %llu\n", __FILE__, __LINE__, #actual, static_cast<unsigned long long>(actual), static_cast<unsigned long long>(expected)); \
+		++s_numFailures; \
+	}
+
+	using ActionSet = std::bitset<NumActions>;
+
+	// How often the positions ran into the cases the filter treats specially
+	struct Coverage
+	{
+		brU32 NumWinningTokensInHand = 0;
+		brU32 NumAllTokensPoisoned = 0;
+		brU32 NumAllSlotsLosing = 0;
+	};
+
+	brBool IsWinningPlacement(Board board, SlotIndex slot, TokenId token)
+	{
+		board.SetTokenOnBoard(slot, token);
+		return board.HasWinningLineThrough(slot);
+	}
+
+	brBool IsCompletingToken(Board const& board, TokenId token)
+	{
+		for (SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+		{
+			if (board.IsSlotEmpty(slot) && IsWinningPlacement(board, slot, token))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Every token left for the opponent completes a line
+	brBool IsLosingPlacement(Board board, SlotIndex slot, TokenId token)
+	{
+		board.SetTokenOnBoard(slot, token);
+		if (!board.GetEmptySlotsMask() || !board.GetFreeTokensMask())
+		{
+			return false;
+		}
+		for (TokenId nextToken = 0; nextToken < NumTokens; ++nextToken)
+		{
+			if (board.IsTokenFree(nextToken) && !IsCompletingToken(board, nextToken))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	ActionSet GetExpectedActions(Board const& board, TokenId givenToken, Coverage& coverage)
+	{
+		brBool hasSafeToken = false;
+		for (TokenId token = 0; token < NumTokens; ++token)
+		{
+			hasSafeToken |= board.IsTokenFree(token) && !IsCompletingToken(board, token);
+		}
+		coverage.NumAllTokensPoisoned += givenToken == InvalidToken && !hasSafeToken ? 1 : 0;
+
+		ActionSet expected;
+		for (TokenId token = 0; token < NumTokens; ++token)
+		{
+			if (givenToken != InvalidToken ? token != givenToken : !board.IsTokenFree(token))
+			{
+				continue;
+			}
+
+			ActionSet winning;
+			ActionSet notLosing;
+			ActionSet all;
+			for (SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+			{
+				if (!board.IsSlotEmpty(slot))
+				{
+					continue;
+				}
+				Action const action = MakeAction(slot, token);
+				all.set(action);
+				if (IsWinningPlacement(board, slot, token))
+				{
+					winning.set(action);
+				}
+				else if (!IsLosingPlacement(board, slot, token))
+				{
+					notLosing.set(action);
+				}
+			}
+
+			if (winning.any())
+			{
+				coverage.NumWinningTokensInHand += givenToken != InvalidToken ? 1 : 0;
+				expected |= givenToken != InvalidToken || !hasSafeToken ? winning : ActionSet();
+			}
+			else
+			{
+				coverage.NumAllSlotsLosing += notLosing.none() ? 1 : 0;
+				expected |= notLosing.any() ? notLosing : all;
+			}
+		}
+		return expected;
+	}
+
+	ActionSet GetRootActions(Board const& board, TokenId givenToken)
+	{
+		SearchSettings settings;
+		settings.UseDeterministicSearch = true;
+		SearchRequest request;
+		request.Board = board;
+		request.Token = givenToken;
+		request.Budget.MaxIterations = 1;
+
+		SearchTree tree(settings, request, 1);
+		tree.Expand(&tree.GetRoot(), board);
+		ActionSet actions;
+		for (Node const* childNode = tree.GetRoot().FirstChild; childNode; childNode = childNode->NextSibling)
+		{
+			actions.set(childNode->PlayedAction);
+		}
+		for (Action action : tree.GetRoot().UnexpandedActions)
+		{
+			actions.set(action);
+		}
+		return actions;
+	}
+
+	void CheckTacticalFilter()
+	{
+		std::printf("tactical filter\n");
+		Random random(7);
+		Coverage coverage;
+		for (brU32 position = 0; position < 3000; ++position)
+		{
+			//random placements up to the middle game, without a line completed on the way
+			Board board;
+			brU32 const numTokens = position % 14;
+			for (brU32 i = 0; i < numTokens && !board.HasWinningLine(); ++i)
+			{
+				SlotIndex slot;
+				TokenId token;
+				do { slot = static_cast<SlotIndex>(random.NextBelow(QUARTO_BOARD_AVAILABLE_SLOTS)); } while (!board.IsSlotEmpty(slot));
+				do { token = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!board.IsTokenFree(token));
+				board.SetTokenOnBoard(slot, token);
+			}
+			if (board.HasWinningLine())
+			{
+				continue;
+			}
+
+			TokenId givenToken = InvalidToken;
+			if (position % 2)
+			{
+				do { givenToken = static_cast<TokenId>(random.NextBelow(NumTokens)); } while (!board.IsTokenFree(givenToken));
+			}
+
+			ActionSet const expected = GetExpectedActions(board, givenToken, coverage);
+			ActionSet const actions = GetRootActions(board, givenToken);
+			CHECK_EQUAL(actions.count(), expected.count());
+			CHECK_EQUAL((actions ^ expected).count(), 0u);
+		}
+
+		//the positions have to reach every special case, else the comparison proves little
+		CHECK_EQUAL(coverage.NumWinningTokensInHand > 0, true);
+		CHECK_EQUAL(coverage.NumAllTokensPoisoned > 0, true);
+		CHECK_EQUAL(coverage.NumAllSlotsLosing > 0, true);
+		std::printf("%u winning tokens in hand, %u positions with every token poisoned, %u tokens with every slot losing\n",
+			coverage.NumWinningTokensInHand, coverage.NumAllTokensPoisoned, coverage.NumAllSlotsLosing);
+	}
+}
+
+int main()
+{
+	CheckTacticalFilter();
+
+	std::printf(s_numFailures == 0 ? "passed\n" : "%u checks failed\n", s_numFailures);
+	return s_numFailures == 0 ? 0 : 1;
+}
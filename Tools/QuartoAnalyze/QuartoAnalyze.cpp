@@ -0,0 +1,536 @@
+// Re-analyzes recorded games (Records/GameRecord.h) with a fixed, deterministic search budget on all cores and flags the blunders
+// QuartoAnalyze --output analysis.qana [--jobs n] [--iterations n] [--seed n] [--threshold 0.3] [--list n] games.qrec...
+// The record files are memory-mapped and streamed through decode -> analyze -> write, only a window of games is in flight at any time
+// Every placement gets two searches: the token search of the player handing the token over and the move search of the placing player
+// A decision is a blunder if the search prefers an alternative whose win rate is at least the threshold higher than the one of the played choice
+// A played choice the search hardly visited is judged by the search of the position it leads to instead, which the analysis runs anyway
+//
+// Output file, games in the order of the input files:
+//   file header: "QANA", u8 version, 3 reserved bytes
+//   game:        u8 number of placements (0 if the game couldn't be replayed)
+//                per placement 6 bytes: slot << 4 | token as played, best token << 4 | best slot found by the searches,
+//                u8 win rates * 255 of the best and the handed over token, of the best and the played move
+
+#include "QuartoCore/MCTS/SearchTree.h"
+#include "QuartoCore/Records/GameRecord.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ai::mcts;
+
+namespace
+{
+	constexpr brU8 s_fileMagic[4] = { 'Q', 'A', 'N', 'A' };
+	constexpr brU8 s_formatVersion = 1;
+
+	void PrintUsage()
+	{
+		std::fprintf(stderr,
+			"usage: QuartoAnalyze --output file [--jobs n] [--iterations n] [--seed n] [--threshold w] [--list n] records...\n"
+			"  iterations: budget of every search (default 2000), the search is deterministic, so the results don't depend on the jobs\n"
+			"  threshold:  win rate difference of a blunder (default 0.3)\n"
+			"  list:       blunders printed to stdout (default 20)\n");
+	}
+
+	std::string FormatSlot(quarto::SlotIndex slot)
+	{
+		return { static_cast<char>('a' + slot % QUARTO_BOARD_SIZE_X), static_cast<char>('1' + slot / QUARTO_BOARD_SIZE_X) };
+	}
+
+	brU8 ToByte(brFloat winRate)
+	{
+		return static_cast<brU8>(std::lround(std::min(std::max(winRate, 0.f), 1.f) * 255.f));
+	}
+
+	// A read-only mapping of a whole file, the kernel pages it in and out as the decoder walks through it
+	class MappedFile
+	{
+	public:
+		explicit MappedFile(char const* path)
+		{
+			int const file = open(path, O_RDONLY);
+			if (file < 0)
+			{
+				return;
+			}
+			struct stat status;
+			if (fstat(file, &status) == 0 && status.st_size > 0)
+			{
+				void* const data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+				if (data != MAP_FAILED)
+				{
+					madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+					m_data = static_cast<brU8 const*>(data);
+					m_size = static_cast<size_t>(status.st_size);
+				}
+			}
+			close(file);
+		}
+
+		~MappedFile()
+		{
+			if (m_data)
+			{
+				munmap(const_cast<brU8*>(m_data), m_size);
+			}
+		}
+
+		MappedFile(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile const&) = delete;
+
+		brBool IsValid() const { return m_data != nullptr; }
+		brU8 const* GetData() const { return m_data; }
+		size_t GetSize() const { return m_size; }
+
+	private:
+		brU8 const* m_data = nullptr;
+		size_t m_size = 0;
+	};
+
+	// A decision of the game judged by the search, win rates of the deciding player
+	struct Decision
+	{
+		Action Best = InvalidAction;
+		brFloat BestWinRate = 0.f;
+		brFloat PlayedWinRate = 0.f;
+		// The played choice got enough visits for its win rate to be trusted
+		brBool IsPlayedWinRateReliable = false;
+	};
+
+	struct PlacementAnalysis
+	{
+		quarto::PlacementRecord Placement;
+		Decision Token;
+		Decision Move;
+	};
+
+	struct GameAnalysis
+	{
+		brU64 Index = 0;
+		brU8 NumPlacements = 0;
+		PlacementAnalysis Placements[QUARTO_BOARD_AVAILABLE_SLOTS];
+	};
+
+	// Root children with less than this share of the iterations have too few visits for their win rate
+	constexpr brU32 s_minVisitsShareDivisor = 32;
+
+	Decision Judge(SearchSettings const& settings, SearchRequest const& request, Action played)
+	{
+		auto const isPlayed = [&request, played](Action action)
+		{
+			return request.IsOpponentTokenSearch() ? GetActionToken(action) == GetActionToken(played) : GetActionSlot(action) == GetActionSlot(played);
+		};
+
+		SearchResult const result = RunSearch(settings, request);
+		Decision decision;
+		decision.Best = result.IsValid() ? result.BestAction : played;
+		decision.BestWinRate = result.Stats.EstimatedWinRate;
+		for (RootChildStats const& child : result.Stats.RootChildren)
+		{
+			if (isPlayed(child.PlayedAction))
+			{
+				decision.PlayedWinRate = child.WinRate;
+				decision.IsPlayedWinRateReliable = child.VisitCount * s_minVisitsShareDivisor >= result.Stats.NumIterations;
+			}
+		}
+		if (result.Stats.RootChildren.empty() || isPlayed(decision.Best))
+		{
+			//forced decisions finish without visits
+			decision.PlayedWinRate = decision.BestWinRate;
+			decision.IsPlayedWinRateReliable = true;
+		}
+		return decision;
+	}
+
+	// Replays the game and judges every token hand-over and every move, an illegal game is analyzed as empty
+	void Analyze(SearchSettings const& settings, quarto::GameRecord const& record, GameAnalysis& analysis)
+	{
+		analysis.NumPlacements = 0;
+		quarto::Board board;
+		if (!record.Replay(board))
+		{
+			return;
+		}
+
+		board.Reset();
+		for (brU8 i = 0; i < record.NumPlacements; ++i)
+		{
+			quarto::PlacementRecord const& placement = record.Placements[i];
+			PlayerId const placer = i % 2;
+			PlayerId const other = 1 - placer;
+
+			//like in the game, the player receiving the token is the searching player of the token search
+			SearchRequest request;
+			request.Board = board;
+			request.Player = placer;
+			request.Opponent = other;
+			request.Budget = settings.OpponentTokenSearchBudget;
+			PlacementAnalysis& result = analysis.Placements[i];
+			result.Placement = placement;
+			result.Token = Judge(settings, request, MakeAction(0, placement.Token));
+
+			request.Token = placement.Token;
+			request.Budget = settings.MoveSearchBudget;
+			result.Move = Judge(settings, request, MakeAction(placement.Slot, placement.Token));
+
+			//the move search knows how well the receiving player does with the handed over token
+			if (!result.Token.IsPlayedWinRateReliable)
+			{
+				result.Token.PlayedWinRate = 1.f - result.Move.BestWinRate;
+			}
+
+			board.SetTokenOnBoard(placement.Slot, placement.Token);
+			analysis.NumPlacements = i + 1;
+		}
+
+		//a move is judged by the next token search, seen from the other side, which counts draws as not lost
+		for (brU8 i = 0; i < analysis.NumPlacements; ++i)
+		{
+			Decision& move = analysis.Placements[i].Move;
+			if (move.IsPlayedWinRateReliable)
+			{
+				continue;
+			}
+			if (i + 1 < analysis.NumPlacements)
+			{
+				move.PlayedWinRate = analysis.Placements[i + 1].Token.BestWinRate;
+				continue;
+			}
+
+			board.Reset();
+			for (brU8 j = 0; j <= i; ++j)
+			{
+				board.SetTokenOnBoard(record.Placements[j].Slot, record.Placements[j].Token);
+			}
+			if (board.HasWinningLine())
+			{
+				move.PlayedWinRate = 1.f;
+			}
+			else if (board.GetStatus() == quarto::Board::GameStatus::End)
+			{
+				move.PlayedWinRate = 0.f;
+			}
+			else
+			{
+				SearchRequest request;
+				request.Board = board;
+				request.Player = (i + 1) % 2;
+				request.Opponent = i % 2;
+				request.Budget = settings.OpponentTokenSearchBudget;
+				move.PlayedWinRate = RunSearch(settings, request).Stats.EstimatedWinRate;
+			}
+		}
+	}
+
+	void AppendAnalysis(std::vector<brU8>& buffer, GameAnalysis const& analysis)
+	{
+		buffer.push_back(analysis.NumPlacements);
+		for (brU8 i = 0; i < analysis.NumPlacements; ++i)
+		{
+			PlacementAnalysis const& placement = analysis.Placements[i];
+			buffer.push_back(static_cast<brU8>((placement.Placement.Slot << 4) | placement.Placement.Token));
+			buffer.push_back(static_cast<brU8>((GetActionToken(placement.Token.Best) << 4) | GetActionSlot(placement.Move.Best)));
+			buffer.push_back(ToByte(placement.Token.BestWinRate));
+			buffer.push_back(ToByte(placement.Token.PlayedWinRate));
+			buffer.push_back(ToByte(placement.Move.BestWinRate));
+			buffer.push_back(ToByte(placement.Move.PlayedWinRate));
+		}
+	}
+
+	// Hands the decoded games to the analyzing jobs and their results in order to the writer
+	// The decoder waits while the window is full, so neither the input nor the results pile up in memory
+	class Pipeline
+	{
+	public:
+		explicit Pipeline(brU64 window) : m_window(window) {}
+
+		// Decoder
+		void PushGame(quarto::GameRecord const& record)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_hasRoom.wait(lock, [this]() { return m_numDecoded - m_numWritten < m_window; });
+			m_pendingGames.push_back({ m_numDecoded++, record });
+			m_hasGame.notify_one();
+		}
+
+		void FinishDecoding()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isDecodingFinished = true;
+			m_hasGame.notify_all();
+			m_hasResult.notify_all();
+		}
+
+		// Jobs, false once all games are taken
+		brBool PopGame(brU64& index, quarto::GameRecord& record)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_hasGame.wait(lock, [this]() { return !m_pendingGames.empty() || m_isDecodingFinished; });
+			if (m_pendingGames.empty())
+			{
+				return false;
+			}
+			index = m_pendingGames.front().first;
+			record = m_pendingGames.front().second;
+			m_pendingGames.pop_front();
+			return true;
+		}
+
+		void PushResult(GameAnalysis const& analysis)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_results.emplace(analysis.Index, analysis);
+			if (analysis.Index == m_numWritten)
+			{
+				m_hasResult.notify_one();
+			}
+		}
+
+		// Writer, false once all games are written
+		brBool PopNextResult(GameAnalysis& analysis)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_hasResult.wait(lock, [this]() { return m_results.count(m_numWritten) || (m_isDecodingFinished && m_numWritten == m_numDecoded); });
+			auto const next = m_results.find(m_numWritten);
+			if (next == m_results.end())
+			{
+				return false;
+			}
+			analysis = next->second;
+			m_results.erase(next);
+			++m_numWritten;
+			m_hasRoom.notify_one();
+			return true;
+		}
+
+	private:
+		brU64 const m_window;
+		std::mutex m_mutex;
+		std::condition_variable m_hasRoom;
+		std::condition_variable m_hasGame;
+		std::condition_variable m_hasResult;
+		std::deque<std::pair<brU64, quarto::GameRecord>> m_pendingGames;
+		std::map<brU64, GameAnalysis> m_results;
+		brU64 m_numDecoded = 0;
+		brU64 m_numWritten = 0;
+		brBool m_isDecodingFinished = false;
+	};
+
+	struct Summary
+	{
+		brU64 NumGames = 0;
+		brU64 NumInvalidGames = 0;
+		brU64 NumPlacements = 0;
+		brU64 NumTokenBlunders = 0;
+		brU64 NumMoveBlunders = 0;
+	};
+
+	// Counts and prints the blunders of one game
+	void Report(GameAnalysis const& analysis, brFloat threshold, brU32& numListed, brU32 maxListed, Summary& summary)
+	{
+		++summary.NumGames;
+		summary.NumInvalidGames += analysis.NumPlacements == 0;
+		summary.NumPlacements += analysis.NumPlacements;
+		for (brU8 i = 0; i < analysis.NumPlacements; ++i)
+		{
+			PlacementAnalysis const& placement = analysis.Placements[i];
+			if (placement.Token.BestWinRate - placement.Token.PlayedWinRate >= threshold)
+			{
+				++summary.NumTokenBlunders;
+				if (numListed++ < maxListed)
+				{
+					std::printf("game %llu, placement %u: token %u handed over, %.2f instead of %.2f with token %u\n",
+						static_cast<unsigned long long>(analysis.Index), i + 1, placement.Placement.Token,
+						placement.Token.PlayedWinRate, placement.Token.BestWinRate, GetActionToken(placement.Token.Best));
+				}
+			}
+			if (placement.Move.BestWinRate - placement.Move.PlayedWinRate >= threshold)
+			{
+				++summary.NumMoveBlunders;
+				if (numListed++ < maxListed)
+				{
+					std::printf("game %llu, placement %u: %s=%u played, %.2f instead of %.2f on %s\n",
+						static_cast<unsigned long long>(analysis.Index), i + 1, FormatSlot(placement.Placement.Slot).c_str(), placement.Placement.Token,
+						placement.Move.PlayedWinRate, placement.Move.BestWinRate, FormatSlot(GetActionSlot(placement.Move.Best)).c_str());
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	char const* outputPath = nullptr;
+	std::vector<char const*> inputPaths;
+	brU32 numJobs = std::max(std::thread::hardware_concurrency(), 1u);
+	brU32 numIterations = 2000;
+	brU64 seed = 0;
+	brFloat threshold = 0.3f;
+	brU32 maxListed = 20;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		brBool const hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--output") && hasValue)
+		{
+			outputPath = argv[++i];
+		}
+		else if (!std::strcmp(argv[i], "--jobs") && hasValue)
+		{
+			numJobs = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (!std::strcmp(argv[i], "--iterations") && hasValue)
+		{
+			numIterations = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (!std::strcmp(argv[i], "--seed") && hasValue)
+		{
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (!std::strcmp(argv[i], "--threshold") && hasValue)
+		{
+			threshold = static_cast<brFloat>(std::atof(argv[++i]));
+		}
+		else if (!std::strcmp(argv[i], "--list") && hasValue)
+		{
+			maxListed = static_cast<brU32>(std::max(std::atoi(argv[++i]), 0));
+		}
+		else if (argv[i][0] != '-')
+		{
+			inputPaths.push_back(argv[i]);
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (!outputPath || inputPaths.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::FILE* const output = std::fopen(outputPath, "wb");
+	if (!output)
+	{
+		std::fprintf(stderr, "can't write to '%s'\n", outputPath);
+		return 1;
+	}
+	std::fwrite(s_fileMagic, 1, sizeof(s_fileMagic), output);
+	brU8 const version[4] = { s_formatVersion, 0, 0, 0 };
+	std::fwrite(version, 1, sizeof(version), output);
+
+	//the whole budget is iterations, so every job judges a position exactly like any other run would
+	SearchSettings settings;
+	settings.UseDeterministicSearch = true;
+	settings.RandomSeed = seed;
+	settings.NumThreads = 1;
+	//every alternative needs visits to be compared with the played one
+	settings.UseProgressiveWidening = false;
+	settings.UseEarlyTermination = false;
+	for (SearchBudgetSettings* budget : { &settings.MoveSearchBudget, &settings.OpponentTokenSearchBudget })
+	{
+		budget->MaxIterations = numIterations;
+	}
+
+	Pipeline pipeline(numJobs * 8);
+	auto const start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> jobs;
+	for (brU32 job = 0; job < numJobs; ++job)
+	{
+		jobs.emplace_back([&]()
+		{
+			quarto::GameRecord record;
+			GameAnalysis analysis;
+			while (pipeline.PopGame(analysis.Index, record))
+			{
+				Analyze(settings, record, analysis);
+				pipeline.PushResult(analysis);
+			}
+		});
+	}
+
+	Summary summary;
+	std::thread writer([&]()
+	{
+		std::vector<brU8> buffer;
+		GameAnalysis analysis;
+		brU32 numListed = 0;
+		while (pipeline.PopNextResult(analysis))
+		{
+			Report(analysis, threshold, numListed, maxListed, summary);
+			AppendAnalysis(buffer, analysis);
+			if (buffer.size() >= 64 * 1024)
+			{
+				std::fwrite(buffer.data(), 1, buffer.size(), output);
+				buffer.clear();
+			}
+		}
+		std::fwrite(buffer.data(), 1, buffer.size(), output);
+		if (numListed > maxListed)
+		{
+			std::printf("... %u more\n", numListed - maxListed);
+		}
+	});
+
+	brU32 numCorruptBlocks = 0;
+	brBool hasFailed = false;
+	for (char const* path : inputPaths)
+	{
+		MappedFile const file(path);
+		quarto::GameRecordReader reader(file.GetData(), file.GetSize());
+		if (!file.IsValid() || !reader.IsValidFile())
+		{
+			std::fprintf(stderr, "'%s' isn't a readable game record file, skipping it\n", path);
+			hasFailed = true;
+			continue;
+		}
+
+		quarto::GameRecord record;
+		while (reader.Next(record))
+		{
+			pipeline.PushGame(record);
+		}
+		numCorruptBlocks += reader.GetNumCorruptBlocks();
+		if (reader.IsTruncated())
+		{
+			std::fprintf(stderr, "'%s' ends with a torn block\n", path);
+		}
+	}
+	pipeline.FinishDecoding();
+
+	for (std::thread& job : jobs)
+	{
+		job.join();
+	}
+	writer.join();
+	hasFailed |= std::fclose(output) != 0;
+
+	brDouble const seconds = std::chrono::duration<brDouble>(std::chrono::steady_clock::now() - start).count();
+	std::printf("games: %llu (%llu not replayable), placements: %llu, corrupt blocks skipped: %u\n",
+		static_cast<unsigned long long>(summary.NumGames), static_cast<unsigned long long>(summary.NumInvalidGames),
+		static_cast<unsigned long long>(summary.NumPlacements), numCorruptBlocks);
+	std::printf("blunders: %llu token hand-overs, %llu moves (threshold %.2f)\n",
+		static_cast<unsigned long long>(summary.NumTokenBlunders), static_cast<unsigned long long>(summary.NumMoveBlunders), threshold);
+	std::printf("%.1fs, %.1f placements/s with %u jobs\n", seconds, summary.NumPlacements / std::max(seconds, 1e-9), numJobs);
+	return hasFailed ? 1 : 0;
+}
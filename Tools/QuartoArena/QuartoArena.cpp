@@ -0,0 +1,299 @@
+// Headless self-play arena: plays two search configurations against each other, games run in parallel
+// QuartoArena --games 1000 --jobs 8 --a "seconds=0.05" --b "seconds=0.05,rave=0" [--record games.qrec]
+
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/MCTS/SearchOptions.h"
+#include "QuartoCore/MCTS/SearchTree.h"
+#include "QuartoCore/Records/GameRecordWriter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ai::mcts;
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::printf(
+			"usage: QuartoArena [--games n] [--jobs n] [--a config] [--b config] [--record file]\n"
+			"  config: comma separated key=value pairs, applied to the default settings and seconds=0.05\n"
+			"    seconds, iterations, playouts, nodes, memory (MB)   budget of every decision\n"
+			"    threads                                             root parallel search threads\n"
+			"    exploration, rave, rave-k, widening, widening-c, widening-alpha, early, recycling, tactics, deterministic, seed\n"
+			"    ntuple (file of QuartoTrain), cutoff                playouts end after cutoff placements with the network's estimate\n"
+			"    network (file of QuartoTrainNet), puct              PUCT search on the network's priors and values instead of playouts\n"
+			"    priors                                              PUCT search on heuristic priors, the leaves are still valued by playouts\n"
+			"  file: appends every game to a game record file\n");
+	}
+
+	brBool ParseConfig(std::string const& text, SearchSettings& settings)
+	{
+		std::stringstream stream(text);
+		std::string pair;
+		while (std::getline(stream, pair, ','))
+		{
+			size_t const separator = pair.find('=');
+			if (separator == std::string::npos)
+			{
+				std::fprintf(stderr, "invalid config entry '%s'\n", pair.c_str());
+				return false;
+			}
+			std::string const key = pair.substr(0, separator);
+			std::string const value = pair.substr(separator + 1);
+			SearchOptionStatus const status = SetSearchOption(settings, key, value);
+			if (status == SearchOptionStatus::UnknownKey)
+			{
+				std::fprintf(stderr, "unknown config key '%s'\n", key.c_str());
+				return false;
+			}
+			if (status == SearchOptionStatus::InvalidValue)
+			{
+				std::fprintf(stderr, "invalid value '%s' of config key '%s'\n", value.c_str(), key.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	struct DecisionStats
+	{
+		void Add(DecisionStats const& other)
+		{
+			NumDecisions += other.NumDecisions;
+			TotalSeconds += other.TotalSeconds;
+			MaxSeconds = std::max(MaxSeconds, other.MaxSeconds);
+			SavedSeconds += other.SavedSeconds;
+		}
+
+		brU32 NumDecisions = 0;
+		brDouble TotalSeconds = 0.0;
+		brDouble MaxSeconds = 0.0;
+		// Unused budget because of the early termination
+		brDouble SavedSeconds = 0.0;
+	};
+
+	struct GameResult
+	{
+		// Index of the winning engine, -1 for a draw
+		brS32 Winner = -1;
+		DecisionStats Stats[2];
+		quarto::GameRecord Record;
+	};
+
+	SearchResult TimedSearch(SearchSettings const& settings, SearchRequest const& request, DecisionStats& stats)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		SearchResult const result = RunSearch(settings, request);
+		brDouble const seconds = std::chrono::duration<brDouble>(std::chrono::steady_clock::now() - start).count();
+
+		++stats.NumDecisions;
+		stats.TotalSeconds += seconds;
+		stats.MaxSeconds = std::max(stats.MaxSeconds, seconds);
+		stats.SavedSeconds += result.SavedSeconds;
+		return result;
+	}
+
+	// Engine i plays as player i, the starting player places the token chosen by the other one
+	GameResult PlayGame(SearchSettings const* settings[2], brU32 firstPlayer)
+	{
+		GameResult game;
+		quarto::Board board;
+		brU32 current = firstPlayer;
+		brU32 other = 1 - firstPlayer;
+
+		SearchRequest tokenRequest;
+		tokenRequest.Board = board;
+		tokenRequest.Player = current;
+		tokenRequest.Opponent = other;
+		tokenRequest.Budget = settings[other]->OpponentTokenSearchBudget;
+		quarto::TokenId token = TimedSearch(*settings[other], tokenRequest, game.Stats[other]).GetToken();
+
+		while (true)
+		{
+			SearchRequest moveRequest;
+			moveRequest.Board = board;
+			moveRequest.Token = token;
+			moveRequest.Player = current;
+			moveRequest.Opponent = other;
+			moveRequest.Budget = settings[current]->MoveSearchBudget;
+			SearchResult const move = TimedSearch(*settings[current], moveRequest, game.Stats[current]);
+			if (!move.IsValid() || !board.IsSlotEmpty(move.GetSlot()))
+			{
+				std::fprintf(stderr, "engine %c returned an invalid move, the game counts as lost\n", 'A' + current);
+				game.Winner = static_cast<brS32>(other);
+				return game;
+			}
+
+			board.SetTokenOnBoard(move.GetSlot(), token);
+			game.Record.AddPlacement(move.GetSlot(), token, move.Stats.NumIterations, move.Stats.EstimatedWinRate);
+			if (board.HasWinningLineThrough(move.GetSlot()))
+			{
+				game.Winner = static_cast<brS32>(current);
+				game.Record.Result = current == firstPlayer ? quarto::GameResult::FirstPlayerWon : quarto::GameResult::SecondPlayerWon;
+				return game;
+			}
+			if (board.GetStatus() == quarto::Board::GameStatus::End)
+			{
+				game.Record.Result = quarto::GameResult::Draw;
+				return game;
+			}
+
+			tokenRequest.Board = board;
+			tokenRequest.Player = other;
+			tokenRequest.Opponent = current;
+			tokenRequest.Budget = settings[current]->OpponentTokenSearchBudget;
+			token = TimedSearch(*settings[current], tokenRequest, game.Stats[current]).GetToken();
+			if (token >= quarto::NumTokens || !board.IsTokenFree(token))
+			{
+				std::fprintf(stderr, "engine %c returned an invalid token, the game counts as lost\n", 'A' + current);
+				game.Winner = static_cast<brS32>(other);
+				return game;
+			}
+
+			std::swap(current, other);
+		}
+	}
+
+	// Elo difference of a score in (0, 1)
+	brDouble ScoreToElo(brDouble score)
+	{
+		score = std::min(std::max(score, 1e-6), 1.0 - 1e-6);
+		return -400.0 * std::log10(1.0 / score - 1.0);
+	}
+
+	void PrintReport(brU32 wins[2], brU32 draws, DecisionStats const stats[2], brDouble wallSeconds)
+	{
+		brU32 const numGames = wins[0] + wins[1] + draws;
+		if (numGames == 0)
+		{
+			return;
+		}
+
+		//score of A and its standard error over the games, the interval is the 95% normal approximation
+		brDouble const score = (wins[0] + 0.5 * draws) / numGames;
+		brDouble const variance = (wins[0] * std::pow(1.0 - score, 2) + draws * std::pow(0.5 - score, 2) + wins[1] * std::pow(score, 2)) / numGames;
+		brDouble const margin = 1.96 * std::sqrt(variance / numGames);
+
+		std::printf("games: %u in %.1fs\n", numGames, wallSeconds);
+		std::printf("A wins: %u  draws: %u  B wins: %u  (A scores %.1f%%)\n", wins[0], draws, wins[1], 100.0 * score);
+		std::printf("elo A - B: %+.1f  [%+.1f, %+.1f] 95%% confidence\n", ScoreToElo(score), ScoreToElo(score - margin), ScoreToElo(score + margin));
+		for (brU32 i = 0; i < 2; ++i)
+		{
+			DecisionStats const& engine = stats[i];
+			brDouble const decisions = std::max(engine.NumDecisions, 1u);
+			std::printf("%c: %u decisions, latency avg %.2fms max %.2fms, saved avg %.2fms\n",
+				'A' + i, engine.NumDecisions, 1000.0 * engine.TotalSeconds / decisions, 1000.0 * engine.MaxSeconds, 1000.0 * engine.SavedSeconds / decisions);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	brU32 numGames = 100;
+	brU32 numJobs = std::max(std::thread::hardware_concurrency(), 1u);
+	char const* recordPath = nullptr;
+	SearchSettings settings[2];
+	for (SearchSettings& engine : settings)
+	{
+		engine.MoveSearchBudget.MaxSeconds = 0.05f;
+		engine.OpponentTokenSearchBudget.MaxSeconds = 0.05f;
+	}
+
+	for (int i = 1; i < argc; ++i)
+	{
+		brBool const hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--games") && hasValue)
+		{
+			numGames = static_cast<brU32>(std::atoi(argv[++i]));
+		}
+		else if (!std::strcmp(argv[i], "--jobs") && hasValue)
+		{
+			numJobs = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (!std::strcmp(argv[i], "--record") && hasValue)
+		{
+			recordPath = argv[++i];
+		}
+		else if ((!std::strcmp(argv[i], "--a") || !std::strcmp(argv[i], "--b")) && hasValue)
+		{
+			brU32 const engine = argv[i][2] == 'a' ? 0 : 1;
+			if (!ParseConfig(argv[++i], settings[engine]))
+			{
+				return 1;
+			}
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	std::unique_ptr<quarto::GameRecordWriter> recordWriter;
+	if (recordPath)
+	{
+		recordWriter = std::make_unique<quarto::GameRecordWriter>(recordPath);
+		if (!recordWriter->IsOpen())
+		{
+			std::fprintf(stderr, "can't append to the game record file '%s'\n", recordPath);
+			return 1;
+		}
+	}
+
+	SearchSettings const* engines[2] = { &settings[0], &settings[1] };
+	std::mutex mutex;
+	std::atomic<brU32> nextGame(0);
+	brU32 wins[2] = {};
+	brU32 draws = 0;
+	DecisionStats stats[2];
+
+	auto const start = std::chrono::steady_clock::now();
+	std::vector<std::thread> jobs;
+	for (brU32 job = 0; job < std::min(numJobs, numGames); ++job)
+	{
+		jobs.emplace_back([&]()
+		{
+			for (brU32 game = nextGame++; game < numGames; game = nextGame++)
+			{
+				//both engines start every other game
+				GameResult const result = PlayGame(engines, game % 2);
+
+				std::lock_guard<std::mutex> lock(mutex);
+				if (result.Winner < 0)
+				{
+					++draws;
+				}
+				else
+				{
+					++wins[result.Winner];
+				}
+				stats[0].Add(result.Stats[0]);
+				stats[1].Add(result.Stats[1]);
+				//the mutex makes the jobs take turns as the single producer of the writer
+				if (recordWriter)
+				{
+					recordWriter->Push(result.Record);
+				}
+			}
+		});
+	}
+	for (std::thread& job : jobs)
+	{
+		job.join();
+	}
+
+	PrintReport(wins, draws, stats, std::chrono::duration<brDouble>(std::chrono::steady_clock::now() - start).count());
+	return 0;
+}
@@ -0,0 +1,288 @@
+// Microbenchmarks of the board primitives and the search phases of the core library
+// JSON for tracking across commits: QuartoBench --benchmark_out=bench.json --benchmark_out_format=json
+
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/Common/BitUtils.h"
+#include "QuartoCore/Common/Random.h"
+#include "QuartoCore/MCTS/SearchScheduler.h"
+#include "QuartoCore/MCTS/SearchTree.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using namespace ai::mcts;
+
+namespace
+{
+	constexpr brU64 s_seed = 0x5EED;
+	constexpr brU32 s_numBoards = 256;
+
+	// Boards in progress with the given number of tokens on them, the same for every run
+	std::vector<quarto::Board> MakeBoards(brU32 numTokens)
+	{
+		quarto::Random random(s_seed + numTokens);
+		std::vector<quarto::Board> boards;
+		while (boards.size() < s_numBoards)
+		{
+			quarto::Board board;
+			for (brU32 i = 0; i < numTokens && board.GetStatus() == quarto::Board::GameStatus::InProgress; ++i)
+			{
+				brU32 const emptySlots = board.GetEmptySlotsMask();
+				brU32 const freeTokens = board.GetFreeTokensMask();
+				board.SetTokenOnBoard(
+					static_cast<quarto::SlotIndex>(quarto::GetIndexOfNthSetBit(emptySlots, random.NextBelow(quarto::CountSetBits(emptySlots)))),
+					static_cast<quarto::TokenId>(quarto::GetIndexOfNthSetBit(freeTokens, random.NextBelow(quarto::CountSetBits(freeTokens)))));
+			}
+			if (board.GetStatus() == quarto::Board::GameStatus::InProgress && board.GetNumberOfFreeSlots() == QUARTO_BOARD_AVAILABLE_SLOTS - numTokens)
+			{
+				boards.push_back(board);
+			}
+		}
+		return boards;
+	}
+
+	SearchRequest MakeRequest(quarto::Board const& board)
+	{
+		SearchRequest request;
+		request.Board = board;
+		request.Token = static_cast<quarto::TokenId>(quarto::GetIndexOfLowestSetBit(board.GetFreeTokensMask()));
+		return request;
+	}
+
+	// A tree which went through the given number of iterations, so the phases run on a realistic shape
+	std::unique_ptr<SearchTree> MakeWarmTree(brU32 numIterations)
+	{
+		auto tree = std::make_unique<SearchTree>(SearchSettings(), MakeRequest(MakeBoards(4)[0]), s_seed);
+		for (brU32 i = 0; i < numIterations; ++i)
+		{
+			tree->Iterate();
+		}
+		return tree;
+	}
+
+	// Argument: number of tokens on the board
+	void TokensOnBoardArguments(benchmark::internal::Benchmark* benchmark)
+	{
+		benchmark->Arg(4)->Arg(8)->Arg(12);
+	}
+}
+
+static void BM_Board_GetStatus(benchmark::State& state)
+{
+	std::vector<quarto::Board> const boards = MakeBoards(static_cast<brU32>(state.range(0)));
+	brU32 i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(boards[i++ % s_numBoards].GetStatus());
+	}
+}
+BENCHMARK(BM_Board_GetStatus)->Apply(TokensOnBoardArguments);
+
+static void BM_Board_HasWinningLineThrough(benchmark::State& state)
+{
+	std::vector<quarto::Board> const boards = MakeBoards(static_cast<brU32>(state.range(0)));
+	brU32 i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(boards[i % s_numBoards].HasWinningLineThrough(static_cast<quarto::SlotIndex>(i % QUARTO_BOARD_AVAILABLE_SLOTS)));
+		++i;
+	}
+}
+BENCHMARK(BM_Board_HasWinningLineThrough)->Apply(TokensOnBoardArguments);
+
+static void BM_Board_GetNumberOfThreatLines(benchmark::State& state)
+{
+	std::vector<quarto::Board> const boards = MakeBoards(static_cast<brU32>(state.range(0)));
+	brU32 i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(boards[i++ % s_numBoards].GetNumberOfThreatLines());
+	}
+}
+BENCHMARK(BM_Board_GetNumberOfThreatLines)->Apply(TokensOnBoardArguments);
+
+static void BM_Board_GetWinningSlotsMask(benchmark::State& state)
+{
+	std::vector<quarto::Board> const boards = MakeBoards(static_cast<brU32>(state.range(0)));
+	brU32 i = 0;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(boards[i % s_numBoards].GetWinningSlotsMask(static_cast<quarto::TokenId>(i % quarto::NumTokens)));
+		++i;
+	}
+}
+BENCHMARK(BM_Board_GetWinningSlotsMask)->Apply(TokensOnBoardArguments);
+
+// Core equivalent of QuartoBoardData::GetEmptySlotCoordinates: walking the empty slots
+static void BM_Board_EnumerateEmptySlots(benchmark::State& state)
+{
+	std::vector<quarto::Board> const boards = MakeBoards(static_cast<brU32>(state.range(0)));
+	brU32 i = 0;
+	for (auto _ : state)
+	{
+		brU32 sum = 0;
+		for (brU32 slots = boards[i++ % s_numBoards].GetEmptySlotsMask(); slots; slots &= slots - 1)
+		{
+			sum += quarto::GetIndexOfLowestSetBit(slots);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+}
+BENCHMARK(BM_Board_EnumerateEmptySlots)->Apply(TokensOnBoardArguments);
+
+// Core equivalent of QuartoBoardData::GetFreeTokens: walking the free tokens
+static void BM_Board_EnumerateFreeTokens(benchmark::State& state)
+{
+	std::vector<quarto::Board> const boards = MakeBoards(static_cast<brU32>(state.range(0)));
+	brU32 i = 0;
+	for (auto _ : state)
+	{
+		brU32 sum = 0;
+		for (brU32 tokens = boards[i++ % s_numBoards].GetFreeTokensMask(); tokens; tokens &= tokens - 1)
+		{
+			sum += quarto::GetIndexOfLowestSetBit(tokens);
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+}
+BENCHMARK(BM_Board_EnumerateFreeTokens)->Apply(TokensOnBoardArguments);
+
+// Places and removes a token, so the board stays the same
+static void BM_Board_SetTokenOnBoard(benchmark::State& state)
+{
+	std::vector<quarto::Board> boards = MakeBoards(static_cast<brU32>(state.range(0)));
+	brU32 i = 0;
+	for (auto _ : state)
+	{
+		quarto::Board& board = boards[i++ % s_numBoards];
+		quarto::SlotIndex const slot = static_cast<quarto::SlotIndex>(quarto::GetIndexOfLowestSetBit(board.GetEmptySlotsMask()));
+		board.SetTokenOnBoard(slot, static_cast<quarto::TokenId>(quarto::GetIndexOfLowestSetBit(board.GetFreeTokensMask())));
+		board.RemoveTokenFromBoard(slot);
+		benchmark::ClobberMemory();
+	}
+}
+BENCHMARK(BM_Board_SetTokenOnBoard)->Apply(TokensOnBoardArguments);
+
+static void BM_Search_RandomPlay(benchmark::State& state)
+{
+	std::vector<quarto::Board> const boards = MakeBoards(static_cast<brU32>(state.range(0)));
+	SearchTree tree(SearchSettings(), MakeRequest(boards[0]), s_seed);
+	brU32 i = 0;
+	for (auto _ : state)
+	{
+		quarto::Board board = boards[i++ % s_numBoards];
+		benchmark::DoNotOptimize(tree.RandomPlay(board));
+	}
+}
+BENCHMARK(BM_Search_RandomPlay)->Apply(TokensOnBoardArguments);
+
+// A full random playout from a leaf of the root
+static void BM_Search_Simulate(benchmark::State& state)
+{
+	std::vector<quarto::Board> const boards = MakeBoards(static_cast<brU32>(state.range(0)));
+	SearchTree tree(SearchSettings(), MakeRequest(boards[0]), s_seed);
+	Node leaf;
+	AmafTrace trace;
+	brU32 i = 0;
+	for (auto _ : state)
+	{
+		quarto::Board board = boards[i++ % s_numBoards];
+		trace.Reset();
+		benchmark::DoNotOptimize(tree.Simulate(&leaf, board, trace));
+	}
+	state.counters["playouts/s"] = benchmark::Counter(static_cast<brDouble>(state.iterations()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Search_Simulate)->Apply(TokensOnBoardArguments);
+
+static void BM_Search_Select(benchmark::State& state)
+{
+	std::unique_ptr<SearchTree> tree = MakeWarmTree(static_cast<brU32>(state.range(0)));
+	for (auto _ : state)
+	{
+		quarto::Board board = tree->GetRequest().Board;
+		benchmark::DoNotOptimize(tree->Select(board));
+	}
+}
+BENCHMARK(BM_Search_Select)->Arg(1000)->Arg(10000);
+
+// Expansion of a fresh root, the tree creation isn't measured
+static void BM_Search_Expand(benchmark::State& state)
+{
+	SearchSettings settings;
+	settings.UseProgressiveWidening = state.range(0) != 0;
+	SearchRequest request = MakeRequest(MakeBoards(4)[0]);
+	request.Token = quarto::InvalidToken;
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		auto tree = std::make_unique<SearchTree>(settings, request, s_seed);
+		state.ResumeTiming();
+
+		tree->Expand(&tree->GetRoot(), request.Board);
+
+		state.PauseTiming();
+		tree.reset();
+		state.ResumeTiming();
+	}
+}
+BENCHMARK(BM_Search_Expand)->ArgName("widening")->Arg(0)->Arg(1);
+
+static void BM_Search_BackPropagate(benchmark::State& state)
+{
+	std::unique_ptr<SearchTree> tree = MakeWarmTree(static_cast<brU32>(state.range(0)));
+	quarto::Board board = tree->GetRequest().Board;
+	Node* leaf = tree->Select(board);
+	AmafTrace trace;
+	for (auto _ : state)
+	{
+		trace.Reset();
+		tree->BackPropagate(leaf, 0, trace);
+	}
+}
+BENCHMARK(BM_Search_BackPropagate)->Arg(1000)->Arg(10000);
+
+// Everything together, with the default settings and without a budget
+// Later positions often have a winning child at the root, the search then stops growing and isn't representative anymore
+static void BM_Search_Iterate(benchmark::State& state)
+{
+	SearchTree tree(SearchSettings(), MakeRequest(MakeBoards(static_cast<brU32>(state.range(0)))[0]), s_seed);
+	for (auto _ : state)
+	{
+		tree.Iterate();
+	}
+	state.counters["iterations/s"] = benchmark::Counter(static_cast<brDouble>(state.iterations()), benchmark::Counter::kIsRate);
+	state.counters["nodes"] = static_cast<brDouble>(tree.GetBudget().GetNumNodes());
+}
+BENCHMARK(BM_Search_Iterate)->Arg(0)->Arg(4);
+
+// Many concurrent searches of fixed size on a shared pool with the given number of workers, the total iteration rate should scale with the workers
+static void BM_Scheduler_ConcurrentSearches(benchmark::State& state)
+{
+	constexpr brU32 numSearches = 32;
+	constexpr brU32 numIterationsPerSearch = 2000;
+	SearchScheduler scheduler(static_cast<brU32>(state.range(0)));
+	std::vector<quarto::Board> const boards = MakeBoards(4);
+	SearchSettings settings;
+	settings.UseEarlyTermination = false;
+	for (auto _ : state)
+	{
+		std::atomic<brU32> numFinished { 0 };
+		for (brU32 i = 0; i < numSearches; ++i)
+		{
+			SearchRequest request = MakeRequest(boards[i]);
+			request.Budget.MaxIterations = numIterationsPerSearch;
+			scheduler.Submit(settings, request, nullptr, 1 + i % 2, [&numFinished](SearchResult const&) { ++numFinished; });
+		}
+		while (numFinished < numSearches)
+		{
+			std::this_thread::yield();
+		}
+	}
+	state.counters["iterations/s"] = benchmark::Counter(static_cast<brDouble>(state.iterations()) * numSearches * numIterationsPerSearch, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Scheduler_ConcurrentSearches)->ArgName("workers")->Arg(1)->Arg(2)->Arg(4)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
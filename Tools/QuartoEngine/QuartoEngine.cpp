@@ -0,0 +1,394 @@
+// Headless engine speaking a line based protocol on stdin/stdout, modelled after UCI, so scripts and other processes can drive the search
+// Commands are processed in order, a client may pipeline them: a command which changes the position or the options first waits for the running search
+//   quarto                                 identifies the engine and lists the options, answered with quartook
+//   isready                                answered with readyok right away, also while searching
+//   setoption name <key> value <v>         same keys as the QuartoArena configs (MCTS/SearchOptions.h), e.g. "setoption name seconds value 0.5"
+//   newgame                                empty board, no token in hand
+//   position startpos [moves m...] [token t]
+//       moves place tokens on the board: <slot>=<token>, slots a1..d4 (column a-d = x, row 1-4 = y), tokens 0..15 (TokenId bits)
+//       token is the token handed to the side to move, without it the engine searches for the token to hand over instead
+//   go [movetime ms] [iterations n] [playouts n] [nodes n] [infinite]
+//       without limits the budget of the options is used, infinite searches until stop
+//       nodes only caps the tree and never ends a search, it needs one of the other limits or infinite
+//       streams "info ..." lines while searching and ends with "bestmove <slot>" or "bestmove <token>" ("bestmove none" without a legal decision)
+//   stop                                   ends the search, it still reports its best decision so far
+//   quit                                   stops the search, at the end of the input a search with limits is finished first
+
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/MCTS/SearchOptions.h"
+#include "QuartoCore/MCTS/SearchTree.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace ai::mcts;
+
+namespace
+{
+	std::mutex s_outputMutex;
+
+	// One line of output, flushed right away so a pipe sees it
+	void Send(char const* format, ...)
+	{
+		std::lock_guard<std::mutex> lock(s_outputMutex);
+		va_list args;
+		va_start(args, format);
+		std::vprintf(format, args);
+		va_end(args);
+		std::fputc('\n', stdout);
+		std::fflush(stdout);
+	}
+
+	brBool ParseSlot(std::string const& text, quarto::SlotIndex& slot)
+	{
+		if (text.size() != 2 || text[0] < 'a' || text[0] >= 'a' + QUARTO_BOARD_SIZE_X || text[1] < '1' || text[1] >= '1' + QUARTO_BOARD_SIZE_Y)
+		{
+			return false;
+		}
+		slot = static_cast<quarto::SlotIndex>((text[1] - '1') * QUARTO_BOARD_SIZE_X + (text[0] - 'a'));
+		return true;
+	}
+
+	brBool ParseToken(std::string const& text, quarto::TokenId& token)
+	{
+		char* end = nullptr;
+		long const value = std::strtol(text.c_str(), &end, 10);
+		if (text.empty() || *end != '\0' || value < 0 || value >= quarto::NumTokens)
+		{
+			return false;
+		}
+		token = static_cast<quarto::TokenId>(value);
+		return true;
+	}
+
+	std::string FormatSlot(quarto::SlotIndex slot)
+	{
+		return { static_cast<char>('a' + slot % QUARTO_BOARD_SIZE_X), static_cast<char>('1' + slot / QUARTO_BOARD_SIZE_X) };
+	}
+
+	class Engine
+	{
+	public:
+		Engine()
+		{
+			m_settings.MoveSearchBudget.MaxSeconds = 1.f;
+			m_settings.OpponentTokenSearchBudget.MaxSeconds = 1.f;
+		}
+
+		// Until quit or the end of the input
+		void Run()
+		{
+			std::string line;
+			while (std::getline(std::cin, line))
+			{
+				if (!HandleLine(line))
+				{
+					StopSearch();
+					break;
+				}
+			}
+
+			//a piped batch of commands still gets its last decision, only a search without any limit would never end
+			if (m_isSearchUnlimited)
+			{
+				StopSearch();
+			}
+			WaitForSearch();
+		}
+
+	private:
+		// False on quit
+		brBool HandleLine(std::string const& line)
+		{
+			std::istringstream stream(line);
+			std::string command;
+			if (!(stream >> command))
+			{
+				return true;
+			}
+
+			if (command == "quarto")
+			{
+				Send("id name QuartoEngine");
+				Send("option %s info-interval", GetSearchOptionKeys());
+				Send("quartook");
+			}
+			else if (command == "isready") Send("readyok");
+			else if (command == "setoption") HandleSetOption(stream);
+			else if (command == "newgame")
+			{
+				WaitForSearch();
+				m_board.Reset();
+				m_token = quarto::InvalidToken;
+			}
+			else if (command == "position") HandlePosition(stream);
+			else if (command == "go") HandleGo(stream);
+			else if (command == "stop") StopSearch();
+			else if (command == "quit") return false;
+			else Send("info string unknown command '%s'", command.c_str());
+			return true;
+		}
+
+		void HandleSetOption(std::istringstream& stream)
+		{
+			std::string nameKeyword, key, valueKeyword, value;
+			if (!(stream >> nameKeyword >> key >> valueKeyword >> value) || nameKeyword != "name" || valueKeyword != "value")
+			{
+				Send("info string usage: setoption name <key> value <number or file>");
+				return;
+			}
+
+			WaitForSearch();
+			if (key == "info-interval")
+			{
+				m_infoIntervalMs = static_cast<brU32>(std::strtoul(value.c_str(), nullptr, 10));
+				return;
+			}
+
+			SearchOptionStatus const status = SetSearchOption(m_settings, key, value);
+			if (status == SearchOptionStatus::UnknownKey)
+			{
+				Send("info string unknown option '%s'", key.c_str());
+			}
+			else if (status == SearchOptionStatus::InvalidValue)
+			{
+				Send("info string invalid value '%s' of option '%s'", value.c_str(), key.c_str());
+			}
+		}
+
+		void HandlePosition(std::istringstream& stream)
+		{
+			std::string word;
+			if (!(stream >> word) || word != "startpos")
+			{
+				Send("info string usage: position startpos [moves <slot>=<token> ...] [token <token>]");
+				return;
+			}
+
+			//the position is only taken over once it is valid completely
+			quarto::Board board;
+			quarto::TokenId tokenInHand = quarto::InvalidToken;
+			brBool isReadingMoves = false;
+			while (stream >> word)
+			{
+				if (word == "moves")
+				{
+					isReadingMoves = true;
+				}
+				else if (word == "token")
+				{
+					isReadingMoves = false;
+					if (!(stream >> word) || !ParseToken(word, tokenInHand) || !board.IsTokenFree(tokenInHand))
+					{
+						Send("info string invalid token in hand '%s'", word.c_str());
+						return;
+					}
+				}
+				else if (isReadingMoves)
+				{
+					size_t const separator = word.find('=');
+					quarto::SlotIndex slot = quarto::InvalidSlot;
+					quarto::TokenId token = quarto::InvalidToken;
+					if (separator == std::string::npos || !ParseSlot(word.substr(0, separator), slot) || !ParseToken(word.substr(separator + 1), token)
+						|| !board.IsSlotEmpty(slot) || !board.IsTokenFree(token) || board.HasWinningLine())
+					{
+						Send("info string illegal move '%s'", word.c_str());
+						return;
+					}
+					board.SetTokenOnBoard(slot, token);
+				}
+				else
+				{
+					Send("info string unexpected '%s' in position", word.c_str());
+					return;
+				}
+			}
+
+			WaitForSearch();
+			m_board = board;
+			m_token = tokenInHand;
+		}
+
+		void HandleGo(std::istringstream& stream)
+		{
+			WaitForSearch();
+
+			SearchRequest request;
+			request.Board = m_board;
+			request.Token = m_token;
+			request.Budget = request.IsOpponentTokenSearch() ? m_settings.OpponentTokenSearchBudget : m_settings.MoveSearchBudget;
+
+			//limits of the command replace the ones of the options
+			brBool hasLimits = false;
+			brBool isInfinite = false;
+			SearchBudgetSettings limits = request.Budget;
+			limits.MaxSeconds = 0.f;
+			limits.MaxIterations = 0;
+			limits.MaxPlayouts = 0;
+			limits.MaxNodes = 0;
+			std::string word;
+			while (stream >> word)
+			{
+				brDouble value = 0.0;
+				if (word == "infinite")
+				{
+					hasLimits = true;
+					isInfinite = true;
+					continue;
+				}
+				if (!(stream >> value) || value < 0.0)
+				{
+					Send("info string missing value of '%s'", word.c_str());
+					return;
+				}
+
+				hasLimits = true;
+				if (word == "movetime") limits.MaxSeconds = static_cast<brFloat>(value / 1000.0);
+				else if (word == "iterations") limits.MaxIterations = static_cast<brU32>(value);
+				else if (word == "playouts") limits.MaxPlayouts = static_cast<brU32>(value);
+				else if (word == "nodes") limits.MaxNodes = static_cast<brU32>(value);
+				else
+				{
+					Send("info string unknown go parameter '%s'", word.c_str());
+					return;
+				}
+			}
+			if (hasLimits)
+			{
+				request.Budget = limits;
+			}
+
+			SearchBudgetSettings const& budget = request.Budget;
+			brBool const hasTerminatingLimit = budget.MaxSeconds > 0.f || budget.MaxIterations > 0 || budget.MaxPlayouts > 0;
+			if (limits.MaxNodes > 0 && !hasTerminatingLimit && !isInfinite)
+			{
+				Send("info string nodes only caps the tree, go needs movetime, iterations, playouts or infinite with it");
+				return;
+			}
+
+			if (m_board.GetStatus() == quarto::Board::GameStatus::End)
+			{
+				Send("info string the game is over");
+				Send("bestmove none");
+				return;
+			}
+
+			//the node and memory limits only stop the tree from growing, the search goes on with playouts
+			m_isSearchUnlimited = !hasTerminatingLimit;
+			m_control = std::make_unique<SearchControl>();
+			m_searchThread = std::thread(&Engine::Search, this, m_settings, request);
+		}
+
+		void StopSearch()
+		{
+			if (m_control)
+			{
+				m_control->Stop();
+			}
+		}
+
+		void WaitForSearch()
+		{
+			if (m_searchThread.joinable())
+			{
+				m_searchThread.join();
+			}
+		}
+
+		// Runs on the search thread, a reporter thread streams the snapshots meanwhile
+		void Search(SearchSettings settings, SearchRequest request)
+		{
+			std::mutex mutex;
+			std::condition_variable finished;
+			brBool isFinished = false;
+			std::thread reporter;
+			if (m_infoIntervalMs > 0)
+			{
+				reporter = std::thread([this, &mutex, &finished, &isFinished]()
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					while (!finished.wait_for(lock, std::chrono::milliseconds(m_infoIntervalMs), [&isFinished]() { return isFinished; }))
+					{
+						if (m_snapshots.Update())
+						{
+							SendInfo(m_snapshots.GetReadBuffer());
+						}
+					}
+				});
+			}
+
+			SearchResult const result = RunSearch(settings, request, m_control.get(), &m_snapshots);
+
+			if (reporter.joinable())
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					isFinished = true;
+				}
+				finished.notify_one();
+				reporter.join();
+			}
+
+			//the final snapshot of the search, the reporter is done reading
+			m_snapshots.Update();
+			SendInfo(m_snapshots.GetReadBuffer());
+			if (!result.IsValid())
+			{
+				Send("bestmove none");
+			}
+			else if (request.IsOpponentTokenSearch())
+			{
+				Send("bestmove %u", static_cast<brU32>(result.GetToken()));
+			}
+			else
+			{
+				Send("bestmove %s", FormatSlot(result.GetSlot()).c_str());
+			}
+		}
+
+		static void SendInfo(SearchSnapshot const& snapshot)
+		{
+			if (!snapshot.IsValid)
+			{
+				return;
+			}
+
+			std::string best = "none";
+			if (snapshot.BestAction != InvalidAction)
+			{
+				best = snapshot.IsOpponentTokenSearch ? std::to_string(GetActionToken(snapshot.BestAction)) : FormatSlot(GetActionSlot(snapshot.BestAction));
+			}
+			Send("info time %u iterations %u playouts %u nodes %u winrate %.3f best %s",
+				static_cast<brU32>(snapshot.ElapsedSeconds * 1000.0), snapshot.NumIterations, snapshot.NumPlayouts, snapshot.NumNodes, snapshot.EstimatedWinRate, best.c_str());
+		}
+
+	private:
+		SearchSettings m_settings;
+		quarto::Board m_board;
+		quarto::TokenId m_token = quarto::InvalidToken;
+		brU32 m_infoIntervalMs = 100;
+
+		// Only replaced while no search is running
+		std::unique_ptr<SearchControl> m_control;
+		brBool m_isSearchUnlimited = false;
+		std::thread m_searchThread;
+		// Written by the search, read by the reporter and then by the search thread, never at the same time
+		SearchSnapshotBuffer m_snapshots;
+	};
+}
+
+int main()
+{
+	Engine engine;
+	engine.Run();
+	return 0;
+}
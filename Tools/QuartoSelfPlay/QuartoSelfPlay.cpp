@@ -0,0 +1,392 @@
+// Self-play generator of training data: the search plays against itself and every decision becomes one fixed size record
+// QuartoSelfPlay --output dir [--workers n] [--positions n] [--iterations n] [--sampled-placements n] [--shard-records n] [--seed n]
+// Every worker is a process of its own writing its own shards (dir/selfplay-<worker>-<shard>.qspd), nothing is shared, so the throughput scales with the workers
+// The searches are deterministic, the same seed and worker count generate the same shards
+//
+// Shard file, all integers little endian, written through a shared memory mapping:
+//   header (16 bytes): "QSPD", u8 version, u8 record size, 2 reserved bytes, u64 number of records (written when the shard is closed)
+//   record (48 bytes), the position in its canonical form (Board/Symmetry.h), seen from the deciding player:
+//     u16 empty slots mask, u8[8] tokens of the slots (slot 2i in the low nibble), u8 token to place (0xFF: the token to hand over is decided),
+//     u8 result of the game for the deciding player (0 lost, 1 draw, 2 won),
+//     u16[16] root visits by slot (placing) or by token (handing over) in the canonical form, u32 iterations of the search
+// Decisions without a choice (a single free slot or token) aren't recorded
+
+#include "QuartoCore/Board/Symmetry.h"
+#include "QuartoCore/MCTS/SearchTree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ai::mcts;
+
+namespace
+{
+	constexpr brU8 s_fileMagic[4] = { 'Q', 'S', 'P', 'D' };
+	constexpr brU8 s_formatVersion = 1;
+	constexpr size_t s_headerSize = 16;
+	constexpr size_t s_recordSize = 48;
+
+	void PrintUsage()
+	{
+		std::fprintf(stderr,
+			"usage: QuartoSelfPlay --output dir [--workers n] [--positions n] [--iterations n] [--sampled-placements n] [--shard-records n] [--seed n]\n"
+			"  workers:            processes, one per hardware thread by default\n"
+			"  positions:          records to generate over all workers (default 100000)\n"
+			"  iterations:         budget of every search (default 800)\n"
+			"  sampled-placements: the choices of the first placements are sampled by their visits instead of taking the best (default 4)\n"
+			"  shard-records:      records per shard file (default 1048576)\n");
+	}
+
+	struct Options
+	{
+		std::string OutputDirectory;
+		brU32 NumWorkers = 1;
+		brU64 NumPositions = 100000;
+		brU32 NumIterations = 800;
+		brU32 NumSampledPlacements = 4;
+		brU64 NumShardRecords = 1 << 20;
+		brU64 Seed = 0;
+	};
+
+	void WriteU16(brU8* data, brU16 value)
+	{
+		data[0] = static_cast<brU8>(value);
+		data[1] = static_cast<brU8>(value >> 8);
+	}
+
+	void WriteU32(brU8* data, brU32 value)
+	{
+		for (brU32 i = 0; i < 4; ++i)
+		{
+			data[i] = static_cast<brU8>(value >> (8 * i));
+		}
+	}
+
+	void WriteU64(brU8* data, brU64 value)
+	{
+		for (brU32 i = 0; i < 8; ++i)
+		{
+			data[i] = static_cast<brU8>(value >> (8 * i));
+		}
+	}
+
+	// One decision of a game, waiting for the result
+	struct Sample
+	{
+		quarto::Board Board;
+		quarto::TokenId Token = quarto::InvalidToken;
+		PlayerId Decider = 0;
+		brU16 Visits[QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+		brU32 NumIterations = 0;
+	};
+
+	void EncodeRecord(Sample const& sample, brU8 result, brU8* record)
+	{
+		std::memset(record, 0, s_recordSize);
+		WriteU16(record, sample.Board.GetEmptySlotsMask());
+		for (quarto::SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+		{
+			if (!sample.Board.IsSlotEmpty(slot))
+			{
+				record[2 + slot / 2] |= static_cast<brU8>(sample.Board.GetToken(slot) << (4 * (slot % 2)));
+			}
+		}
+		record[10] = sample.Token;
+		record[11] = result;
+		for (brU8 i = 0; i < QUARTO_BOARD_AVAILABLE_SLOTS; ++i)
+		{
+			WriteU16(record + 12 + 2 * i, sample.Visits[i]);
+		}
+		WriteU32(record + 44, sample.NumIterations);
+	}
+
+	// A shard of fixed size records, the file is sized up front and filled through a shared mapping, so the records are written without any copy through stdio
+	class ShardWriter
+	{
+	public:
+		ShardWriter(std::string const& path, brU64 capacity)
+			: m_capacity(capacity)
+		{
+			m_file = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+			m_mappedSize = s_headerSize + capacity * s_recordSize;
+			if (m_file < 0 || ftruncate(m_file, static_cast<off_t>(m_mappedSize)) != 0)
+			{
+				return;
+			}
+			void* const data = mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_file, 0);
+			if (data == MAP_FAILED)
+			{
+				return;
+			}
+			m_data = static_cast<brU8*>(data);
+			std::memcpy(m_data, s_fileMagic, sizeof(s_fileMagic));
+			m_data[4] = s_formatVersion;
+			m_data[5] = static_cast<brU8>(s_recordSize);
+		}
+
+		// Writes the number of records and cuts the file to them
+		~ShardWriter()
+		{
+			if (m_data)
+			{
+				WriteU64(m_data + 8, m_numRecords);
+				munmap(m_data, m_mappedSize);
+				if (ftruncate(m_file, static_cast<off_t>(s_headerSize + m_numRecords * s_recordSize)) != 0)
+				{
+					std::fprintf(stderr, "can't cut a shard to its records\n");
+				}
+			}
+			if (m_file >= 0)
+			{
+				close(m_file);
+			}
+		}
+
+		ShardWriter(ShardWriter const&) = delete;
+		ShardWriter& operator=(ShardWriter const&) = delete;
+
+		brBool IsOpen() const { return m_data != nullptr; }
+		brBool IsFull() const { return m_numRecords == m_capacity; }
+
+		void Append(Sample const& sample, brU8 result)
+		{
+			EncodeRecord(sample, result, m_data + s_headerSize + m_numRecords * s_recordSize);
+			++m_numRecords;
+		}
+
+	private:
+		int m_file = -1;
+		brU8* m_data = nullptr;
+		size_t m_mappedSize = 0;
+		brU64 m_capacity;
+		brU64 m_numRecords = 0;
+	};
+
+	// Plays games until the worker's share of the positions is written, returns the number of written records or -1 on an error
+	brS64 RunWorker(Options const& options, brU32 worker, brU64 numPositions)
+	{
+		SearchSettings settings;
+		settings.UseDeterministicSearch = true;
+		settings.NumThreads = 1;
+		settings.MoveSearchBudget.MaxIterations = options.NumIterations;
+		settings.OpponentTokenSearchBudget.MaxIterations = options.NumIterations;
+		quarto::Random random(options.Seed * 1000003 + worker);
+
+		brU32 numShards = 0;
+		std::unique_ptr<ShardWriter> shard;
+		std::vector<Sample> samples;
+		brU64 numWritten = 0;
+		while (numWritten < numPositions)
+		{
+			quarto::Board board;
+			quarto::TokenId token = quarto::InvalidToken;
+			PlayerId decider = 1;
+			brS32 winner = -1;
+			samples.clear();
+
+			//every game starts with the token handed over to player 0
+			while (board.GetStatus() == quarto::Board::GameStatus::InProgress)
+			{
+				SearchRequest request;
+				request.Board = board;
+				request.Token = token;
+				//the searching player of a token search is the one receiving the token
+				request.Player = request.IsOpponentTokenSearch() ? 1 - decider : decider;
+				request.Opponent = 1 - request.Player;
+				request.Budget = request.IsOpponentTokenSearch() ? settings.OpponentTokenSearchBudget : settings.MoveSearchBudget;
+				settings.RandomSeed = random.Next();
+				SearchResult const result = RunSearch(settings, request);
+				if (!result.IsValid())
+				{
+					std::fprintf(stderr, "worker %u: the search returned no decision\n", worker);
+					return -1;
+				}
+
+				Action chosen = result.BestAction;
+				brU32 const numPlacements = QUARTO_BOARD_AVAILABLE_SLOTS - board.GetNumberOfFreeSlots();
+				if (result.Stats.RootChildren.size() > 1)
+				{
+					Sample& sample = *samples.emplace(samples.end());
+					quarto::Symmetry const canonical = quarto::FindCanonicalSymmetry(board, token);
+					sample.Board = canonical.TransformBoard(board);
+					sample.Token = canonical.TransformToken(token);
+					sample.Decider = decider;
+					sample.NumIterations = result.Stats.NumIterations;
+					brU32 const maxVisits = result.Stats.RootChildren.front().VisitCount;
+					for (RootChildStats const& child : result.Stats.RootChildren)
+					{
+						brU8 const index = request.IsOpponentTokenSearch() ? canonical.TransformToken(GetActionToken(child.PlayedAction)) : canonical.TransformSlot(GetActionSlot(child.PlayedAction));
+						sample.Visits[index] = static_cast<brU16>(maxVisits > 0xFFFF ? static_cast<brU64>(child.VisitCount) * 0xFFFF / maxVisits : child.VisitCount);
+					}
+
+					//early choices are sampled by their visits, so the games don't all follow the same lines
+					if (numPlacements < options.NumSampledPlacements)
+					{
+						brU32 totalVisits = 0;
+						for (RootChildStats const& child : result.Stats.RootChildren)
+						{
+							totalVisits += child.VisitCount;
+						}
+						brU32 pick = random.NextBelow(std::max(totalVisits, 1u));
+						for (RootChildStats const& child : result.Stats.RootChildren)
+						{
+							chosen = child.PlayedAction;
+							if (pick < child.VisitCount)
+							{
+								break;
+							}
+							pick -= child.VisitCount;
+						}
+					}
+				}
+
+				if (request.IsOpponentTokenSearch())
+				{
+					token = GetActionToken(chosen);
+					decider = 1 - decider;
+				}
+				else
+				{
+					quarto::SlotIndex const slot = GetActionSlot(chosen);
+					board.SetTokenOnBoard(slot, token);
+					token = quarto::InvalidToken;
+					if (board.HasWinningLineThrough(slot))
+					{
+						winner = decider;
+					}
+				}
+			}
+
+			for (Sample const& sample : samples)
+			{
+				if (numWritten == numPositions)
+				{
+					break;
+				}
+				if (!shard || shard->IsFull())
+				{
+					shard.reset();
+					std::string const path = options.OutputDirectory + "/selfplay-" + std::to_string(worker) + "-" + std::to_string(numShards++) + ".qspd";
+					shard = std::make_unique<ShardWriter>(path, options.NumShardRecords);
+					if (!shard->IsOpen())
+					{
+						std::fprintf(stderr, "worker %u: can't create the shard '%s'\n", worker, path.c_str());
+						return -1;
+					}
+				}
+				shard->Append(sample, winner < 0 ? 1 : winner == static_cast<brS32>(sample.Decider) ? 2 : 0);
+				++numWritten;
+			}
+		}
+		return static_cast<brS64>(numWritten);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	options.NumWorkers = std::max(static_cast<brU32>(sysconf(_SC_NPROCESSORS_ONLN)), 1u);
+	for (int i = 1; i < argc; ++i)
+	{
+		brBool const hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--output") && hasValue)
+		{
+			options.OutputDirectory = argv[++i];
+		}
+		else if (!std::strcmp(argv[i], "--workers") && hasValue)
+		{
+			options.NumWorkers = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (!std::strcmp(argv[i], "--positions") && hasValue)
+		{
+			options.NumPositions = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (!std::strcmp(argv[i], "--iterations") && hasValue)
+		{
+			options.NumIterations = std::max(std::atoi(argv[++i]), 1);
+		}
+		else if (!std::strcmp(argv[i], "--sampled-placements") && hasValue)
+		{
+			options.NumSampledPlacements = static_cast<brU32>(std::max(std::atoi(argv[++i]), 0));
+		}
+		else if (!std::strcmp(argv[i], "--shard-records") && hasValue)
+		{
+			options.NumShardRecords = std::max<brU64>(std::strtoull(argv[++i], nullptr, 10), 1);
+		}
+		else if (!std::strcmp(argv[i], "--seed") && hasValue)
+		{
+			options.Seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (options.OutputDirectory.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	//every worker reports its number of records through the pipe when it is done
+	int reports[2];
+	if (pipe(reports) != 0)
+	{
+		std::perror("pipe");
+		return 1;
+	}
+
+	auto const start = std::chrono::steady_clock::now();
+	std::vector<pid_t> workers;
+	for (brU32 worker = 0; worker < options.NumWorkers; ++worker)
+	{
+		brU64 const numPositions = options.NumPositions / options.NumWorkers + (worker < options.NumPositions % options.NumWorkers ? 1 : 0);
+		pid_t const process = fork();
+		if (process == 0)
+		{
+			close(reports[0]);
+			brS64 const numWritten = RunWorker(options, worker, numPositions);
+			ssize_t const reported = write(reports[1], &numWritten, sizeof(numWritten));
+			_exit(numWritten >= 0 && reported == sizeof(numWritten) ? 0 : 1);
+		}
+		if (process < 0)
+		{
+			std::perror("fork");
+			break;
+		}
+		workers.push_back(process);
+	}
+	close(reports[1]);
+
+	brBool hasFailed = workers.size() != options.NumWorkers;
+	brU64 numWritten = 0;
+	brS64 report;
+	while (read(reports[0], &report, sizeof(report)) == sizeof(report))
+	{
+		numWritten += report > 0 ? static_cast<brU64>(report) : 0;
+	}
+	close(reports[0]);
+	for (pid_t worker : workers)
+	{
+		int status = 0;
+		waitpid(worker, &status, 0);
+		hasFailed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+	}
+
+	brDouble const seconds = std::chrono::duration<brDouble>(std::chrono::steady_clock::now() - start).count();
+	std::printf("positions: %llu in %.1fs with %zu workers, %.0f positions/hour\n",
+		static_cast<unsigned long long>(numWritten), seconds, workers.size(), numWritten / std::max(seconds, 1e-9) * 3600.0);
+	return hasFailed ? 1 : 0;
+}
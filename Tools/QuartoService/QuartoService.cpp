@@ -0,0 +1,567 @@
+// Local search service: clients send search requests over a Unix domain socket, see ServiceProtocol.h for the framing
+// All requests share one SearchScheduler, every batch of frames read from the clients is submitted at once
+// QuartoService --socket /tmp/quarto.sock [--workers n] [--slice-ms 2] [--max-queue 1024]
+
+#include "ServiceProtocol.h"
+
+#include "QuartoCore/MCTS/SearchScheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace ai::mcts;
+using namespace service;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	std::atomic<brBool> s_isShutdownRequested(false);
+
+	void OnShutdownSignal(int)
+	{
+		s_isShutdownRequested = true;
+	}
+
+	void PrintUsage()
+	{
+		std::printf("usage: QuartoService --socket path [--workers n (0 = one per hardware thread)] [--slice-ms ms] [--max-queue n]\n");
+	}
+
+	brU32 ToMicroseconds(Clock::duration duration)
+	{
+		return static_cast<brU32>(std::min<long long>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), 0xFFFFFFFFll));
+	}
+
+	// Latencies of the most recent responses
+	class LatencyWindow
+	{
+	public:
+		void Add(brU32 latencyUs)
+		{
+			if (m_latencies.size() < s_windowSize)
+			{
+				m_latencies.push_back(latencyUs);
+			}
+			else
+			{
+				m_latencies[m_next] = latencyUs;
+				m_next = (m_next + 1) % s_windowSize;
+			}
+		}
+
+		void FillPercentiles(StatsResponseMessage& stats) const
+		{
+			if (m_latencies.empty())
+			{
+				return;
+			}
+			std::vector<brU32> sorted = m_latencies;
+			std::sort(sorted.begin(), sorted.end());
+			auto const percentile = [&sorted](brDouble p) { return sorted[static_cast<size_t>(p * (sorted.size() - 1))]; };
+			stats.LatencyP50Us = percentile(0.5);
+			stats.LatencyP90Us = percentile(0.9);
+			stats.LatencyP99Us = percentile(0.99);
+			stats.LatencyMaxUs = sorted.back();
+		}
+
+	private:
+		static constexpr size_t s_windowSize = 4096;
+		std::vector<brU32> m_latencies;
+		size_t m_next = 0;
+	};
+
+	struct Connection
+	{
+		int Socket = -1;
+		std::vector<brU8> Input;
+		std::vector<brU8> Output;
+		// Searches of this connection which are still running, stopped when it closes
+		std::unordered_map<brU64, std::shared_ptr<SearchControl>> Searches;
+		// The client sent everything, the connection closes once the responses to its requests are written
+		brBool IsClosing = false;
+	};
+
+	// A finished search on its way from a worker to the event loop
+	struct Completion
+	{
+		brU64 ConnectionId;
+		brU64 SearchId;
+		SearchResponseMessage Response;
+	};
+
+	class Service
+	{
+	public:
+		Service(std::string socketPath, brU32 numWorkers, brDouble sliceSeconds, brU32 maxQueueDepth)
+			: m_socketPath(std::move(socketPath))
+			, m_sliceDuration(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<brDouble>(sliceSeconds)))
+			, m_maxQueueDepth(maxQueueDepth)
+			, m_scheduler(std::make_unique<SearchScheduler>(numWorkers, sliceSeconds))
+		{
+		}
+
+		~Service()
+		{
+			//stops all searches, the last callbacks still use the wake up pipe
+			m_scheduler.reset();
+			for (auto& connection : m_connections)
+			{
+				close(connection.second.Socket);
+			}
+			if (m_listenSocket >= 0)
+			{
+				close(m_listenSocket);
+				unlink(m_socketPath.c_str());
+			}
+			for (int pipeEnd : m_wakeUpPipe)
+			{
+				if (pipeEnd >= 0)
+				{
+					close(pipeEnd);
+				}
+			}
+		}
+
+		brBool Start()
+		{
+			sockaddr_un address = {};
+			address.sun_family = AF_UNIX;
+			if (m_socketPath.size() >= sizeof(address.sun_path))
+			{
+				std::fprintf(stderr, "socket path '%s' is too long\n", m_socketPath.c_str());
+				return false;
+			}
+			std::strcpy(address.sun_path, m_socketPath.c_str());
+
+			//a stale socket file of a previous run would make the bind fail
+			unlink(m_socketPath.c_str());
+			m_listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (m_listenSocket < 0 || bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(m_listenSocket, SOMAXCONN) != 0)
+			{
+				std::fprintf(stderr, "can't listen on '%s': %s\n", m_socketPath.c_str(), std::strerror(errno));
+				return false;
+			}
+			if (pipe(m_wakeUpPipe) != 0)
+			{
+				std::fprintf(stderr, "can't create the wake up pipe: %s\n", std::strerror(errno));
+				return false;
+			}
+			SetNonBlocking(m_listenSocket);
+			SetNonBlocking(m_wakeUpPipe[0]);
+			SetNonBlocking(m_wakeUpPipe[1]);
+
+			std::printf("listening on %s with %u workers\n", m_socketPath.c_str(), m_scheduler->GetNumWorkers());
+			std::fflush(stdout);
+			return true;
+		}
+
+		// Until SIGINT or SIGTERM
+		void Run()
+		{
+			std::vector<pollfd> polls;
+			std::vector<brU64> pollConnections;
+			while (!s_isShutdownRequested)
+			{
+				polls.clear();
+				pollConnections.clear();
+				polls.push_back({ m_listenSocket, POLLIN, 0 });
+				polls.push_back({ m_wakeUpPipe[0], POLLIN, 0 });
+				for (auto const& connection : m_connections)
+				{
+					//the end of the input of a closing connection would be reported by every poll
+					short const events = static_cast<short>((connection.second.IsClosing ? 0 : POLLIN) | (connection.second.Output.empty() ? 0 : POLLOUT));
+					polls.push_back({ connection.second.Socket, events, 0 });
+					pollConnections.push_back(connection.first);
+				}
+
+				//the timeout catches a signal which arrives right before the poll
+				if (poll(polls.data(), polls.size(), 200) < 0)
+				{
+					continue;
+				}
+
+				if (polls[0].revents & POLLIN)
+				{
+					AcceptConnections();
+				}
+				if (polls[1].revents & POLLIN)
+				{
+					DrainWakeUpPipe();
+				}
+
+				std::vector<SubmittedSearch> batch;
+				for (size_t i = 0; i < pollConnections.size(); ++i)
+				{
+					pollfd const& entry = polls[i + 2];
+					brU64 const connectionId = pollConnections[i];
+					Connection& connection = m_connections[connectionId];
+					//a hang up after the half close means nobody reads the responses anymore
+					brBool isOpen = !(entry.revents & (POLLERR | POLLNVAL)) && !(connection.IsClosing && (entry.revents & POLLHUP));
+					if (isOpen && !connection.IsClosing && (entry.revents & (POLLIN | POLLHUP)))
+					{
+						isOpen = ReadFrames(connectionId, connection, batch);
+					}
+					if (isOpen && (entry.revents & POLLOUT))
+					{
+						isOpen = WriteOutput(connection);
+					}
+					if (!isOpen)
+					{
+						CloseConnection(connectionId);
+					}
+				}
+				SubmitBatch(batch);
+				DeliverCompletions();
+				CloseFinishedConnections();
+			}
+
+			std::printf("shutting down, %llu searches completed\n", static_cast<unsigned long long>(m_numCompleted));
+		}
+
+	private:
+		struct SubmittedSearch
+		{
+			brU64 ConnectionId;
+			SearchRequestMessage Request;
+			Clock::time_point Arrival;
+		};
+
+		static void SetNonBlocking(int fileDescriptor)
+		{
+			fcntl(fileDescriptor, F_SETFL, fcntl(fileDescriptor, F_GETFL, 0) | O_NONBLOCK);
+		}
+
+		void AcceptConnections()
+		{
+			while (true)
+			{
+				int const socket = accept(m_listenSocket, nullptr, nullptr);
+				if (socket < 0)
+				{
+					return;
+				}
+				SetNonBlocking(socket);
+				m_connections[m_nextConnectionId++].Socket = socket;
+			}
+		}
+
+		void DrainWakeUpPipe()
+		{
+			brU8 buffer[64];
+			while (read(m_wakeUpPipe[0], buffer, sizeof(buffer)) > 0)
+			{
+			}
+		}
+
+		// False once the connection is broken, a half close only marks it as closing
+		brBool ReadFrames(brU64 connectionId, Connection& connection, std::vector<SubmittedSearch>& batch)
+		{
+			brU8 buffer[4096];
+			while (true)
+			{
+				ssize_t const numBytes = read(connection.Socket, buffer, sizeof(buffer));
+				if (numBytes == 0)
+				{
+					//a half close, the frames which came before it are still answered
+					connection.IsClosing = true;
+					break;
+				}
+				if (numBytes < 0)
+				{
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+					{
+						break;
+					}
+					return false;
+				}
+				connection.Input.insert(connection.Input.end(), buffer, buffer + numBytes);
+			}
+
+			Clock::time_point const arrival = Clock::now();
+			size_t offset = 0;
+			while (size_t const frameSize = GetCompleteFrameSize(connection.Input.data() + offset, connection.Input.size() - offset))
+			{
+				FrameReader reader(connection.Input.data() + offset + 2, frameSize - 2);
+				offset += frameSize;
+				brU8 const type = reader.ReadU8();
+				if (type == MessageType_SearchRequest)
+				{
+					SubmittedSearch search { connectionId, SearchRequestMessage(), arrival };
+					if (ReadSearchRequest(reader, search.Request))
+					{
+						batch.push_back(search);
+					}
+					else
+					{
+						SearchResponseMessage response;
+						response.RequestId = search.Request.RequestId;
+						response.Status = SearchStatus_InvalidRequest;
+						WriteSearchResponse(connection.Output, response);
+					}
+				}
+				else if (type == MessageType_StatsRequest)
+				{
+					WriteStatsResponse(connection.Output, GetStats());
+				}
+				else
+				{
+					//without a known message type the framing can't be trusted anymore
+					std::fprintf(stderr, "unknown message type %u, closing the connection\n", type);
+					return false;
+				}
+			}
+			connection.Input.erase(connection.Input.begin(), connection.Input.begin() + offset);
+			return connection.Input.size() < MaxFrameSize;
+		}
+
+		brBool WriteOutput(Connection& connection)
+		{
+			size_t offset = 0;
+			while (offset < connection.Output.size())
+			{
+				ssize_t const numBytes = write(connection.Socket, connection.Output.data() + offset, connection.Output.size() - offset);
+				if (numBytes < 0)
+				{
+					if (errno == EAGAIN || errno == EWOULDBLOCK)
+					{
+						break;
+					}
+					return false;
+				}
+				offset += static_cast<size_t>(numBytes);
+			}
+			connection.Output.erase(connection.Output.begin(), connection.Output.begin() + offset);
+			return true;
+		}
+
+		void CloseConnection(brU64 connectionId)
+		{
+			Connection& connection = m_connections[connectionId];
+			for (auto& search : connection.Searches)
+			{
+				search.second->Stop();
+			}
+			close(connection.Socket);
+			m_connections.erase(connectionId);
+		}
+
+		void CloseFinishedConnections()
+		{
+			for (auto it = m_connections.begin(); it != m_connections.end();)
+			{
+				Connection const& connection = it->second;
+				if (connection.IsClosing && connection.Searches.empty() && connection.Output.empty())
+				{
+					close(connection.Socket);
+					it = m_connections.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		void SubmitBatch(std::vector<SubmittedSearch> const& batch)
+		{
+			SearchSettings settings;
+			for (SubmittedSearch const& search : batch)
+			{
+				auto const it = m_connections.find(search.ConnectionId);
+				if (it == m_connections.end())
+				{
+					//closed right after sending the request
+					continue;
+				}
+				Connection& connection = it->second;
+				if (m_scheduler->GetNumPendingSearches() >= m_maxQueueDepth)
+				{
+					SearchResponseMessage response;
+					response.RequestId = search.Request.RequestId;
+					response.Status = SearchStatus_Busy;
+					WriteSearchResponse(connection.Output, response);
+					continue;
+				}
+
+				SearchRequest request;
+				request.Board = search.Request.Board;
+				request.Token = search.Request.Token;
+				request.Budget.MaxIterations = search.Request.MaxIterations;
+
+				//the search ends a bit before the deadline of the request, so the response still makes it in time
+				std::shared_ptr<SearchControl> const control = std::make_shared<SearchControl>();
+				Clock::time_point deadline = Clock::time_point::max();
+				if (search.Request.DeadlineMs > 0)
+				{
+					Clock::duration const timeout = std::chrono::milliseconds(search.Request.DeadlineMs);
+					deadline = search.Arrival + timeout;
+					control->SetDeadline(deadline - std::min(m_sliceDuration, timeout / 4));
+				}
+
+				brU64 const searchId = m_nextSearchId++;
+				connection.Searches.emplace(searchId, control);
+				brU64 const connectionId = search.ConnectionId;
+				brU32 const requestId = search.Request.RequestId;
+				Clock::time_point const arrival = search.Arrival;
+				m_scheduler->Submit(settings, request, control, search.Request.Priority,
+					[this, connectionId, searchId, requestId, arrival, deadline](SearchResult const& result)
+					{
+						Clock::time_point const now = Clock::now();
+						Completion completion { connectionId, searchId, SearchResponseMessage() };
+						SearchResponseMessage& response = completion.Response;
+						response.RequestId = requestId;
+						response.Status = now > deadline ? SearchStatus_DeadlineMissed : SearchStatus_Ok;
+						response.BestAction = result.BestAction;
+						response.NumIterations = result.Stats.NumIterations;
+						response.EstimatedWinRate = result.Stats.EstimatedWinRate;
+						response.LatencyUs = ToMicroseconds(now - arrival);
+						PushCompletion(completion);
+					});
+			}
+		}
+
+		// Called by the workers
+		void PushCompletion(Completion const& completion)
+		{
+			brBool wasEmpty = false;
+			{
+				std::lock_guard<std::mutex> lock(m_completionMutex);
+				wasEmpty = m_completions.empty();
+				m_completions.push_back(completion);
+			}
+			if (wasEmpty)
+			{
+				brU8 const signal = 1;
+				//a full pipe already wakes the event loop
+				(void)!write(m_wakeUpPipe[1], &signal, 1);
+			}
+		}
+
+		void DeliverCompletions()
+		{
+			std::vector<Completion> completions;
+			{
+				std::lock_guard<std::mutex> lock(m_completionMutex);
+				completions.swap(m_completions);
+			}
+
+			for (Completion const& completion : completions)
+			{
+				++m_numCompleted;
+				m_latencies.Add(completion.Response.LatencyUs);
+
+				auto const it = m_connections.find(completion.ConnectionId);
+				if (it == m_connections.end())
+				{
+					//the client is gone
+					continue;
+				}
+				Connection& connection = it->second;
+				connection.Searches.erase(completion.SearchId);
+				WriteSearchResponse(connection.Output, completion.Response);
+				if (!WriteOutput(connection))
+				{
+					CloseConnection(completion.ConnectionId);
+				}
+			}
+		}
+
+		StatsResponseMessage GetStats() const
+		{
+			StatsResponseMessage stats;
+			stats.QueueDepth = m_scheduler->GetNumPendingSearches();
+			stats.NumWorkers = m_scheduler->GetNumWorkers();
+			stats.NumCompleted = m_numCompleted;
+			m_latencies.FillPercentiles(stats);
+			return stats;
+		}
+
+	private:
+		std::string m_socketPath;
+		Clock::duration m_sliceDuration;
+		brU32 m_maxQueueDepth;
+		int m_listenSocket = -1;
+		int m_wakeUpPipe[2] = { -1, -1 };
+
+		std::unordered_map<brU64, Connection> m_connections;
+		brU64 m_nextConnectionId = 0;
+		brU64 m_nextSearchId = 0;
+		brU64 m_numCompleted = 0;
+		LatencyWindow m_latencies;
+
+		std::mutex m_completionMutex;
+		std::vector<Completion> m_completions;
+		std::unique_ptr<SearchScheduler> m_scheduler;
+	};
+}
+
+int main(int argc, char** argv)
+{
+	std::string socketPath;
+	brU32 numWorkers = 0;
+	brDouble sliceSeconds = 0.002;
+	brU32 maxQueueDepth = 1024;
+	for (int i = 1; i < argc; ++i)
+	{
+		brBool const hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--socket") && hasValue)
+		{
+			socketPath = argv[++i];
+		}
+		else if (!std::strcmp(argv[i], "--workers") && hasValue)
+		{
+			numWorkers = static_cast<brU32>(std::max(std::atoi(argv[++i]), 0));
+		}
+		else if (!std::strcmp(argv[i], "--slice-ms") && hasValue)
+		{
+			sliceSeconds = std::max(std::atof(argv[++i]), 0.1) / 1000.0;
+		}
+		else if (!std::strcmp(argv[i], "--max-queue") && hasValue)
+		{
+			maxQueueDepth = static_cast<brU32>(std::max(std::atoi(argv[++i]), 1));
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (socketPath.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	//a client which disconnects while its response is written must not kill the service
+	std::signal(SIGPIPE, SIG_IGN);
+	struct sigaction shutdownAction = {};
+	shutdownAction.sa_handler = OnShutdownSignal;
+	sigaction(SIGINT, &shutdownAction, nullptr);
+	sigaction(SIGTERM, &shutdownAction, nullptr);
+
+	Service service(socketPath, numWorkers, sliceSeconds, maxQueueDepth);
+	if (!service.Start())
+	{
+		return 1;
+	}
+	service.Run();
+	return 0;
+}
@@ -0,0 +1,386 @@
+// Local stand-in for the clients of QuartoService: concurrent connections pipelining search requests, every response is checked
+// Reports the latencies seen by the clients next to the statistics of the service, fails if any response is wrong
+// QuartoServiceClient --socket /tmp/quarto.sock [--clients 8] [--requests 100] [--pipeline 4] [--deadline-ms 50] [--iterations 0] [--spawn path/to/QuartoService]
+
+#include "ServiceProtocol.h"
+
+#include "QuartoCore/Common/BitUtils.h"
+#include "QuartoCore/Common/Random.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ai::mcts;
+using namespace service;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Options
+	{
+		std::string SocketPath;
+		brU32 NumClients = 8;
+		brU32 NumRequestsPerClient = 100;
+		brU32 Pipeline = 4;
+		brU32 DeadlineMs = 50;
+		brU32 MaxIterations = 0;
+	};
+
+	struct ClientReport
+	{
+		void Add(ClientReport const& other)
+		{
+			NumOk += other.NumOk;
+			NumDeadlineMissed += other.NumDeadlineMissed;
+			NumBusy += other.NumBusy;
+			NumFailures += other.NumFailures;
+			LatenciesUs.insert(LatenciesUs.end(), other.LatenciesUs.begin(), other.LatenciesUs.end());
+		}
+
+		brU32 NumOk = 0;
+		brU32 NumDeadlineMissed = 0;
+		brU32 NumBusy = 0;
+		brU32 NumFailures = 0;
+		std::vector<brU32> LatenciesUs;
+	};
+
+	void PrintUsage()
+	{
+		std::printf("usage: QuartoServiceClient --socket path [--clients n] [--requests n per client] [--pipeline n] [--deadline-ms ms] [--iterations n] [--spawn service]\n");
+	}
+
+	// Retries for a while, so a service which was just started has time to listen
+	int Connect(std::string const& socketPath)
+	{
+		sockaddr_un address = {};
+		address.sun_family = AF_UNIX;
+		std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+		for (brU32 attempt = 0; attempt < 100; ++attempt)
+		{
+			int const socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+			if (socket >= 0 && connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+			{
+				return socket;
+			}
+			close(socket);
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+		std::fprintf(stderr, "can't connect to '%s'\n", socketPath.c_str());
+		return -1;
+	}
+
+	brBool SendAll(int socket, std::vector<brU8> const& data)
+	{
+		size_t offset = 0;
+		while (offset < data.size())
+		{
+			ssize_t const numBytes = write(socket, data.data() + offset, data.size() - offset);
+			if (numBytes <= 0)
+			{
+				return false;
+			}
+			offset += static_cast<size_t>(numBytes);
+		}
+		return true;
+	}
+
+	// Blocks until a whole frame arrived, the payload ends up in frame
+	brBool ReceiveFrame(int socket, std::vector<brU8>& input, std::vector<brU8>& frame)
+	{
+		while (true)
+		{
+			if (size_t const frameSize = GetCompleteFrameSize(input.data(), input.size()))
+			{
+				frame.assign(input.begin() + 2, input.begin() + frameSize);
+				input.erase(input.begin(), input.begin() + frameSize);
+				return true;
+			}
+
+			brU8 buffer[1024];
+			ssize_t const numBytes = read(socket, buffer, sizeof(buffer));
+			if (numBytes <= 0)
+			{
+				return false;
+			}
+			input.insert(input.end(), buffer, buffer + numBytes);
+		}
+	}
+
+	brBool ReceiveSearchResponse(int socket, std::vector<brU8>& input, SearchResponseMessage& response)
+	{
+		std::vector<brU8> frame;
+		if (!ReceiveFrame(socket, input, frame))
+		{
+			return false;
+		}
+		FrameReader reader(frame.data(), frame.size());
+		return reader.ReadU8() == MessageType_SearchResponse && ReadSearchResponse(reader, response);
+	}
+
+	// Random position of a running game, with or without a token in hand
+	SearchRequestMessage MakeRequest(quarto::Random& random, brU32 requestId, Options const& options)
+	{
+		SearchRequestMessage request;
+		request.RequestId = requestId;
+		request.DeadlineMs = options.DeadlineMs;
+		request.MaxIterations = options.MaxIterations;
+		request.Priority = static_cast<brU8>(1 + random.NextBelow(3));
+
+		brU32 const numTokens = random.NextBelow(10);
+		for (brU32 i = 0; i < numTokens; ++i)
+		{
+			brU32 const emptySlots = request.Board.GetEmptySlotsMask();
+			brU32 const freeTokens = request.Board.GetFreeTokensMask();
+			quarto::SlotIndex const slot = static_cast<quarto::SlotIndex>(quarto::GetIndexOfNthSetBit(emptySlots, random.NextBelow(quarto::CountSetBits(emptySlots))));
+			quarto::TokenId const token = static_cast<quarto::TokenId>(quarto::GetIndexOfNthSetBit(freeTokens, random.NextBelow(quarto::CountSetBits(freeTokens))));
+			request.Board.SetTokenOnBoard(slot, token);
+			if (request.Board.GetStatus() != quarto::Board::GameStatus::InProgress)
+			{
+				request.Board.RemoveTokenFromBoard(slot);
+				break;
+			}
+		}
+
+		if (random.NextBelow(2))
+		{
+			brU32 const freeTokens = request.Board.GetFreeTokensMask();
+			request.Token = static_cast<quarto::TokenId>(quarto::GetIndexOfNthSetBit(freeTokens, random.NextBelow(quarto::CountSetBits(freeTokens))));
+		}
+		return request;
+	}
+
+	brBool IsLegalDecision(SearchRequestMessage const& request, Action action)
+	{
+		if (action == InvalidAction)
+		{
+			return false;
+		}
+		if (request.Token == quarto::InvalidToken)
+		{
+			return request.Board.IsTokenFree(GetActionToken(action));
+		}
+		return request.Board.IsSlotEmpty(GetActionSlot(action)) && GetActionToken(action) == request.Token;
+	}
+
+	ClientReport RunClient(Options const& options, brU32 clientIndex)
+	{
+		ClientReport report;
+		int const socket = Connect(options.SocketPath);
+		if (socket < 0)
+		{
+			report.NumFailures = options.NumRequestsPerClient;
+			return report;
+		}
+
+		quarto::Random random(0xC11E + clientIndex);
+		std::unordered_map<brU32, std::pair<SearchRequestMessage, Clock::time_point>> pending;
+		std::vector<brU8> input;
+		brU32 numSent = 0;
+		brU32 numReceived = 0;
+		while (numReceived < options.NumRequestsPerClient)
+		{
+			//keeps the pipeline full
+			std::vector<brU8> output;
+			while (numSent < options.NumRequestsPerClient && pending.size() < options.Pipeline)
+			{
+				SearchRequestMessage const request = MakeRequest(random, numSent++, options);
+				WriteSearchRequest(output, request);
+				pending.emplace(request.RequestId, std::make_pair(request, Clock::now()));
+			}
+			SearchResponseMessage response;
+			if ((!output.empty() && !SendAll(socket, output)) || !ReceiveSearchResponse(socket, input, response))
+			{
+				std::fprintf(stderr, "client %u lost the connection\n", clientIndex);
+				report.NumFailures += options.NumRequestsPerClient - numReceived;
+				break;
+			}
+			++numReceived;
+
+			auto const it = pending.find(response.RequestId);
+			if (it == pending.end())
+			{
+				std::fprintf(stderr, "client %u got a response to the unknown request %u\n", clientIndex, response.RequestId);
+				++report.NumFailures;
+				continue;
+			}
+			report.LatenciesUs.push_back(static_cast<brU32>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - it->second.second).count()));
+			if (response.Status == SearchStatus_Busy)
+			{
+				++report.NumBusy;
+			}
+			else if ((response.Status == SearchStatus_Ok || response.Status == SearchStatus_DeadlineMissed) && IsLegalDecision(it->second.first, response.BestAction))
+			{
+				++(response.Status == SearchStatus_Ok ? report.NumOk : report.NumDeadlineMissed);
+			}
+			else
+			{
+				std::fprintf(stderr, "client %u got a wrong response to request %u: status %u action 0x%x\n", clientIndex, response.RequestId, response.Status, response.BestAction);
+				++report.NumFailures;
+			}
+			pending.erase(it);
+		}
+		close(socket);
+		return report;
+	}
+
+	// A request with a token twice on the board has to be rejected
+	brBool CheckInvalidRequest(Options const& options)
+	{
+		int const socket = Connect(options.SocketPath);
+		if (socket < 0)
+		{
+			return false;
+		}
+
+		std::vector<brU8> output;
+		{
+			FrameWriter frame(output, MessageType_SearchRequest);
+			frame.WriteU32(7);
+			frame.WriteU16(0x3);
+			frame.WriteU64(0x55);
+			frame.WriteU8(quarto::InvalidToken);
+			frame.WriteU8(1);
+			frame.WriteU32(10);
+			frame.WriteU32(0);
+		}
+		std::vector<brU8> input;
+		SearchResponseMessage response;
+		brBool const isRejected = SendAll(socket, output) && ReceiveSearchResponse(socket, input, response)
+			&& response.RequestId == 7 && response.Status == SearchStatus_InvalidRequest;
+		close(socket);
+		return isRejected;
+	}
+
+	brBool QueryStats(Options const& options, StatsResponseMessage& stats)
+	{
+		int const socket = Connect(options.SocketPath);
+		if (socket < 0)
+		{
+			return false;
+		}
+
+		std::vector<brU8> output;
+		WriteStatsRequest(output);
+		std::vector<brU8> input;
+		std::vector<brU8> frame;
+		brBool isReceived = SendAll(socket, output) && ReceiveFrame(socket, input, frame);
+		if (isReceived)
+		{
+			FrameReader reader(frame.data(), frame.size());
+			isReceived = reader.ReadU8() == MessageType_StatsResponse && ReadStatsResponse(reader, stats);
+		}
+		close(socket);
+		return isReceived;
+	}
+
+	brU32 GetPercentile(std::vector<brU32> const& sorted, brDouble p)
+	{
+		return sorted.empty() ? 0 : sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	char const* servicePath = nullptr;
+	for (int i = 1; i < argc; ++i)
+	{
+		brBool const hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--socket") && hasValue) options.SocketPath = argv[++i];
+		else if (!std::strcmp(argv[i], "--clients") && hasValue) options.NumClients = static_cast<brU32>(std::max(std::atoi(argv[++i]), 1));
+		else if (!std::strcmp(argv[i], "--requests") && hasValue) options.NumRequestsPerClient = static_cast<brU32>(std::max(std::atoi(argv[++i]), 1));
+		else if (!std::strcmp(argv[i], "--pipeline") && hasValue) options.Pipeline = static_cast<brU32>(std::max(std::atoi(argv[++i]), 1));
+		else if (!std::strcmp(argv[i], "--deadline-ms") && hasValue) options.DeadlineMs = static_cast<brU32>(std::max(std::atoi(argv[++i]), 0));
+		else if (!std::strcmp(argv[i], "--iterations") && hasValue) options.MaxIterations = static_cast<brU32>(std::max(std::atoi(argv[++i]), 0));
+		else if (!std::strcmp(argv[i], "--spawn") && hasValue) servicePath = argv[++i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (options.SocketPath.empty() || (options.DeadlineMs == 0 && options.MaxIterations == 0))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	pid_t servicePid = -1;
+	if (servicePath)
+	{
+		servicePid = fork();
+		if (servicePid == 0)
+		{
+			execl(servicePath, servicePath, "--socket", options.SocketPath.c_str(), static_cast<char*>(nullptr));
+			std::perror("can't start the service");
+			_exit(1);
+		}
+	}
+
+	auto const start = Clock::now();
+	ClientReport report;
+	std::mutex mutex;
+	std::vector<std::thread> clients;
+	for (brU32 i = 0; i < options.NumClients; ++i)
+	{
+		clients.emplace_back([&options, &report, &mutex, i]()
+		{
+			ClientReport const clientReport = RunClient(options, i);
+			std::lock_guard<std::mutex> lock(mutex);
+			report.Add(clientReport);
+		});
+	}
+	for (std::thread& client : clients)
+	{
+		client.join();
+	}
+	brDouble const seconds = std::chrono::duration<brDouble>(Clock::now() - start).count();
+
+	if (!CheckInvalidRequest(options))
+	{
+		std::fprintf(stderr, "an invalid request wasn't rejected\n");
+		++report.NumFailures;
+	}
+
+	std::sort(report.LatenciesUs.begin(), report.LatenciesUs.end());
+	std::printf("requests: %u ok, %u deadline missed, %u busy, %u failed in %.2fs (%.0f/s)\n",
+		report.NumOk, report.NumDeadlineMissed, report.NumBusy, report.NumFailures, seconds, report.LatenciesUs.size() / seconds);
+	std::printf("client latency: p50 %.2fms p90 %.2fms p99 %.2fms max %.2fms\n",
+		GetPercentile(report.LatenciesUs, 0.5) / 1000.0, GetPercentile(report.LatenciesUs, 0.9) / 1000.0,
+		GetPercentile(report.LatenciesUs, 0.99) / 1000.0, GetPercentile(report.LatenciesUs, 1.0) / 1000.0);
+
+	StatsResponseMessage stats;
+	if (QueryStats(options, stats))
+	{
+		std::printf("service: %u workers, queue depth %u, %llu completed, latency p50 %.2fms p90 %.2fms p99 %.2fms max %.2fms\n",
+			stats.NumWorkers, stats.QueueDepth, static_cast<unsigned long long>(stats.NumCompleted),
+			stats.LatencyP50Us / 1000.0, stats.LatencyP90Us / 1000.0, stats.LatencyP99Us / 1000.0, stats.LatencyMaxUs / 1000.0);
+	}
+	else
+	{
+		std::fprintf(stderr, "can't query the service statistics\n");
+		++report.NumFailures;
+	}
+
+	if (servicePid > 0)
+	{
+		kill(servicePid, SIGTERM);
+		waitpid(servicePid, nullptr, 0);
+	}
+	return report.NumFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+// Binary framing of the QuartoService, shared by the service and its clients
+// Every message is a frame: u16 payload size, then the payload starting with its MessageType. All integers are little endian.
+
+#include "QuartoCore/Board/Board.h"
+#include "QuartoCore/MCTS/Action.h"
+
+#include <cstring>
+#include <vector>
+
+namespace service
+{
+	enum MessageType : brU8
+	{
+		MessageType_SearchRequest = 1,
+		MessageType_SearchResponse = 2,
+		MessageType_StatsRequest = 3,
+		MessageType_StatsResponse = 4
+	};
+
+	enum SearchStatus : brU8
+	{
+		SearchStatus_Ok = 0,
+		SearchStatus_InvalidRequest = 1,
+		// The queue of the service is full, the request was not searched
+		SearchStatus_Busy = 2,
+		// The response left the service after the deadline, the action is still the best decision of the search
+		SearchStatus_DeadlineMissed = 3
+	};
+
+	constexpr brU32 MaxFrameSize = 256;
+
+	struct SearchRequestMessage
+	{
+		brU32 RequestId = 0;
+		quarto::Board Board;
+		// Token to place, InvalidToken searches for the token to hand over
+		quarto::TokenId Token = quarto::InvalidToken;
+		// Share of the workers relative to other requests, 0 counts as 1
+		brU8 Priority = 1;
+		// Counted from the arrival at the service, 0 = no deadline
+		brU32 DeadlineMs = 0;
+		// 0 = no iteration limit, a request needs a deadline or an iteration limit
+		brU32 MaxIterations = 0;
+	};
+
+	struct SearchResponseMessage
+	{
+		brU32 RequestId = 0;
+		SearchStatus Status = SearchStatus_Ok;
+		ai::mcts::Action BestAction = ai::mcts::InvalidAction;
+		brU32 NumIterations = 0;
+		// From the arrival of the request until its response was queued for sending
+		brU32 LatencyUs = 0;
+		brFloat EstimatedWinRate = 0.f;
+	};
+
+	struct StatsResponseMessage
+	{
+		// Searches waiting for or running on the workers
+		brU32 QueueDepth = 0;
+		brU32 NumWorkers = 0;
+		brU64 NumCompleted = 0;
+		// Over the most recent responses
+		brU32 LatencyP50Us = 0;
+		brU32 LatencyP90Us = 0;
+		brU32 LatencyP99Us = 0;
+		brU32 LatencyMaxUs = 0;
+	};
+
+	class FrameWriter
+	{
+	public:
+		explicit FrameWriter(std::vector<brU8>& buffer, MessageType type)
+			: m_buffer(buffer)
+			, m_start(buffer.size())
+		{
+			WriteU16(0);
+			WriteU8(type);
+		}
+		// Patches the size into the frame
+		~FrameWriter()
+		{
+			size_t const size = m_buffer.size() - m_start - 2;
+			m_buffer[m_start] = static_cast<brU8>(size);
+			m_buffer[m_start + 1] = static_cast<brU8>(size >> 8);
+		}
+
+		void WriteU8(brU8 value) { m_buffer.push_back(value); }
+		void WriteU16(brU16 value) { WriteU8(static_cast<brU8>(value)); WriteU8(static_cast<brU8>(value >> 8)); }
+		void WriteU32(brU32 value) { WriteU16(static_cast<brU16>(value)); WriteU16(static_cast<brU16>(value >> 16)); }
+		void WriteU64(brU64 value) { WriteU32(static_cast<brU32>(value)); WriteU32(static_cast<brU32>(value >> 32)); }
+		void WriteFloat(brFloat value) { brU32 bits; std::memcpy(&bits, &value, sizeof(bits)); WriteU32(bits); }
+
+	private:
+		std::vector<brU8>& m_buffer;
+		size_t m_start;
+	};
+
+	// Reads the payload of one frame, reading past its end fails the whole frame
+	class FrameReader
+	{
+	public:
+		FrameReader(brU8 const* payload, size_t size)
+			: m_data(payload)
+			, m_size(size) {}
+
+		brBool IsValid() const { return m_isValid; }
+		brBool IsAtEnd() const { return m_position == m_size; }
+
+		brU8 ReadU8()
+		{
+			if (m_position >= m_size)
+			{
+				m_isValid = false;
+				return 0;
+			}
+			return m_data[m_position++];
+		}
+		brU16 ReadU16() { brU16 const low = ReadU8(); return static_cast<brU16>(low | (ReadU8() << 8)); }
+		brU32 ReadU32() { brU32 const low = ReadU16(); return low | (static_cast<brU32>(ReadU16()) << 16); }
+		brU64 ReadU64() { brU64 const low = ReadU32(); return low | (static_cast<brU64>(ReadU32()) << 32); }
+		brFloat ReadFloat() { brU32 const bits = ReadU32(); brFloat value; std::memcpy(&value, &bits, sizeof(value)); return value; }
+
+	private:
+		brU8 const* m_data;
+		size_t m_size;
+		size_t m_position = 0;
+		brBool m_isValid = true;
+	};
+
+	// Size of the first complete frame in the buffer including its size field, 0 while it is incomplete
+	inline size_t GetCompleteFrameSize(brU8 const* data, size_t size)
+	{
+		if (size < 2)
+		{
+			return 0;
+		}
+		size_t const frameSize = 2 + (data[0] | (data[1] << 8));
+		return size >= frameSize ? frameSize : 0;
+	}
+
+	// The board is sent as a mask of the occupied slots and the tokens of all slots, 4 bits each
+	inline void WriteSearchRequest(std::vector<brU8>& buffer, SearchRequestMessage const& message)
+	{
+		brU64 tokens = 0;
+		for (quarto::SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+		{
+			if (!message.Board.IsSlotEmpty(slot))
+			{
+				tokens |= static_cast<brU64>(message.Board.GetToken(slot)) << (4 * slot);
+			}
+		}
+
+		FrameWriter frame(buffer, MessageType_SearchRequest);
+		frame.WriteU32(message.RequestId);
+		frame.WriteU16(static_cast<brU16>(~message.Board.GetEmptySlotsMask()));
+		frame.WriteU64(tokens);
+		frame.WriteU8(message.Token);
+		frame.WriteU8(message.Priority);
+		frame.WriteU32(message.DeadlineMs);
+		frame.WriteU32(message.MaxIterations);
+	}
+
+	// Fails on a malformed frame or an illegal position: a token twice on the board, a game which is over or a token in hand which is on the board already
+	inline brBool ReadSearchRequest(FrameReader& reader, SearchRequestMessage& message)
+	{
+		message.RequestId = reader.ReadU32();
+		brU16 const occupiedSlots = reader.ReadU16();
+		brU64 const tokens = reader.ReadU64();
+		message.Token = reader.ReadU8();
+		message.Priority = reader.ReadU8();
+		message.DeadlineMs = reader.ReadU32();
+		message.MaxIterations = reader.ReadU32();
+		if (!reader.IsValid() || !reader.IsAtEnd())
+		{
+			return false;
+		}
+
+		message.Board.Reset();
+		for (quarto::SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+		{
+			if ((occupiedSlots >> slot) & 1u)
+			{
+				quarto::TokenId const token = static_cast<quarto::TokenId>((tokens >> (4 * slot)) & 0xF);
+				if (!message.Board.IsTokenFree(token))
+				{
+					return false;
+				}
+				message.Board.SetTokenOnBoard(slot, token);
+			}
+		}
+		if (message.Token != quarto::InvalidToken && (message.Token >= quarto::NumTokens || !message.Board.IsTokenFree(message.Token)))
+		{
+			return false;
+		}
+		return message.Board.GetStatus() == quarto::Board::GameStatus::InProgress && (message.DeadlineMs > 0 || message.MaxIterations > 0);
+	}
+
+	inline void WriteSearchResponse(std::vector<brU8>& buffer, SearchResponseMessage const& message)
+	{
+		FrameWriter frame(buffer, MessageType_SearchResponse);
+		frame.WriteU32(message.RequestId);
+		frame.WriteU8(message.Status);
+		frame.WriteU16(message.BestAction);
+		frame.WriteU32(message.NumIterations);
+		frame.WriteU32(message.LatencyUs);
+		frame.WriteFloat(message.EstimatedWinRate);
+	}
+
+	inline brBool ReadSearchResponse(FrameReader& reader, SearchResponseMessage& message)
+	{
+		message.RequestId = reader.ReadU32();
+		message.Status = static_cast<SearchStatus>(reader.ReadU8());
+		message.BestAction = reader.ReadU16();
+		message.NumIterations = reader.ReadU32();
+		message.LatencyUs = reader.ReadU32();
+		message.EstimatedWinRate = reader.ReadFloat();
+		return reader.IsValid() && reader.IsAtEnd();
+	}
+
+	inline void WriteStatsRequest(std::vector<brU8>& buffer)
+	{
+		FrameWriter frame(buffer, MessageType_StatsRequest);
+	}
+
+	inline void WriteStatsResponse(std::vector<brU8>& buffer, StatsResponseMessage const& message)
+	{
+		FrameWriter frame(buffer, MessageType_StatsResponse);
+		frame.WriteU32(message.QueueDepth);
+		frame.WriteU32(message.NumWorkers);
+		frame.WriteU64(message.NumCompleted);
+		frame.WriteU32(message.LatencyP50Us);
+		frame.WriteU32(message.LatencyP90Us);
+		frame.WriteU32(message.LatencyP99Us);
+		frame.WriteU32(message.LatencyMaxUs);
+	}
+
+	inline brBool ReadStatsResponse(FrameReader& reader, StatsResponseMessage& message)
+	{
+		message.QueueDepth = reader.ReadU32();
+		message.NumWorkers = reader.ReadU32();
+		message.NumCompleted = reader.ReadU64();
+		message.LatencyP50Us = reader.ReadU32();
+		message.LatencyP90Us = reader.ReadU32();
+		message.LatencyP99Us = reader.ReadU32();
+		message.LatencyMaxUs = reader.ReadU32();
+		return reader.IsValid() && reader.IsAtEnd();
+	}
+}
@@ -0,0 +1,261 @@
+// Trains the n-tuple value network (Eval/NTupleNetwork.h) by TD(0) learning from self-play
+// QuartoTrain --output weights.qntn [--input weights.qntn] [--games n] [--alpha 0.01] [--epsilon 0.1] [--report n] [--seed n]
+// Both sides play greedily by the network with epsilon exploration: a placement maximizes the value of the board it leads to,
+// a token handed over minimizes the best value the opponent can reach with it. After every placement the value of the previous board is moved
+// towards the value of the new one from the other side, a win or a draw ends the game with the exact result.
+// Every report plays the network against a random player and saves the weights.
+// Use the weights with the QuartoArena config key ntuple, e.g. --a "seconds=0.05,ntuple=weights.qntn,cutoff=4"
+
+#include "QuartoCore/Common/BitUtils.h"
+#include "QuartoCore/Common/Random.h"
+#include "QuartoCore/Eval/NTupleNetwork.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+using namespace ai::eval;
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::fprintf(stderr,
+			"usage: QuartoTrain --output file [--input file] [--games n] [--alpha a] [--epsilon e] [--report n] [--seed n]\n"
+			"  games:   self-play games (default 100000)\n"
+			"  alpha:   learning rate per weight (default 0.01)\n"
+			"  epsilon: share of random choices while training (default 0.1)\n"
+			"  report:  games between two reports and saves (default 10000)\n");
+	}
+
+	// A board with the tuple indices of the network
+	struct Position
+	{
+		void Place(quarto::SlotIndex slot, quarto::TokenId token)
+		{
+			Board.SetTokenOnBoard(slot, token);
+			State.SetToken(slot, token);
+		}
+
+		void Remove(quarto::SlotIndex slot, quarto::TokenId token)
+		{
+			Board.RemoveTokenFromBoard(slot);
+			State.RemoveToken(slot, token);
+		}
+
+		quarto::Board Board;
+		NTupleState State;
+	};
+
+	quarto::SlotIndex PickRandomSlot(quarto::Board const& board, quarto::Random& random)
+	{
+		brU32 const emptySlots = board.GetEmptySlotsMask();
+		return static_cast<quarto::SlotIndex>(quarto::GetIndexOfNthSetBit(emptySlots, random.NextBelow(quarto::CountSetBits(emptySlots))));
+	}
+
+	quarto::TokenId PickRandomToken(quarto::Board const& board, quarto::Random& random)
+	{
+		brU32 const freeTokens = board.GetFreeTokensMask();
+		return static_cast<quarto::TokenId>(quarto::GetIndexOfNthSetBit(freeTokens, random.NextBelow(quarto::CountSetBits(freeTokens))));
+	}
+
+	// Best placement of the token and its value for the placing player, a winning placement is worth 1
+	quarto::SlotIndex FindBestSlot(NTupleNetwork const& network, Position& position, quarto::TokenId token, brFloat& bestValue)
+	{
+		quarto::SlotIndex bestSlot = quarto::InvalidSlot;
+		bestValue = -1.f;
+		for (brU32 emptySlots = position.Board.GetEmptySlotsMask(); emptySlots != 0; emptySlots &= emptySlots - 1)
+		{
+			quarto::SlotIndex const slot = static_cast<quarto::SlotIndex>(quarto::GetIndexOfLowestSetBit(emptySlots));
+			position.Place(slot, token);
+			brFloat const value = position.Board.HasWinningLineThrough(slot) ? 1.f
+				: position.Board.GetEmptySlotsMask() == 0 ? 0.5f : network.Evaluate(position.State);
+			position.Remove(slot, token);
+			if (value > bestValue)
+			{
+				bestValue = value;
+				bestSlot = slot;
+			}
+		}
+		return bestSlot;
+	}
+
+	// The token which leaves the opponent the worst best placement
+	quarto::TokenId FindBestToken(NTupleNetwork const& network, Position& position)
+	{
+		quarto::TokenId bestToken = quarto::InvalidToken;
+		brFloat lowestOpponentValue = 2.f;
+		for (brU32 freeTokens = position.Board.GetFreeTokensMask(); freeTokens != 0; freeTokens &= freeTokens - 1)
+		{
+			quarto::TokenId const token = static_cast<quarto::TokenId>(quarto::GetIndexOfLowestSetBit(freeTokens));
+			brFloat opponentValue;
+			FindBestSlot(network, position, token, opponentValue);
+			if (opponentValue < lowestOpponentValue)
+			{
+				lowestOpponentValue = opponentValue;
+				bestToken = token;
+			}
+		}
+		return bestToken;
+	}
+
+	struct Player
+	{
+		NTupleNetwork const* Network = nullptr;
+		brFloat Epsilon = 0.f;
+	};
+
+	// Plays one game, player 0 places first, trains the network if given. Returns the winner, -1 for a draw.
+	brS32 PlayGame(Player const players[2], quarto::Random& random, NTupleNetwork* trainedNetwork, brFloat alpha, brDouble& squaredErrors, brU64& numUpdates)
+	{
+		Position position;
+		NTupleState previousState;
+		brBool hasPreviousState = false;
+
+		auto const chooses = [&random](Player const& player) { return player.Network && random.NextFloat() >= player.Epsilon; };
+		quarto::TokenId token = chooses(players[1]) ? FindBestToken(*players[1].Network, position) : PickRandomToken(position.Board, random);
+		for (brU32 current = 0;; current = 1 - current)
+		{
+			Player const& player = players[current];
+			brFloat value;
+			quarto::SlotIndex const slot = chooses(player) ? FindBestSlot(*player.Network, position, token, value) : PickRandomSlot(position.Board, random);
+			position.Place(slot, token);
+
+			brBool const isWon = position.Board.HasWinningLineThrough(slot);
+			brBool const isDraw = !isWon && position.Board.GetEmptySlotsMask() == 0;
+			if (trainedNetwork && hasPreviousState)
+			{
+				//the previous board was valued from the other side
+				brFloat const target = isWon ? 0.f : isDraw ? 0.5f : 1.f - trainedNetwork->Evaluate(position.State);
+				brFloat const error = target - trainedNetwork->Evaluate(previousState);
+				squaredErrors += error * error;
+				++numUpdates;
+				trainedNetwork->Train(previousState, target, alpha);
+			}
+			if (isWon)
+			{
+				return static_cast<brS32>(current);
+			}
+			if (isDraw)
+			{
+				return -1;
+			}
+
+			previousState = position.State;
+			hasPreviousState = true;
+			token = chooses(player) ? FindBestToken(*player.Network, position) : PickRandomToken(position.Board, random);
+		}
+	}
+
+	// Score of the greedy network against a random player, both start every other game
+	brDouble EvaluateAgainstRandom(NTupleNetwork const& network, quarto::Random& random, brU32 numGames)
+	{
+		brDouble score = 0.0;
+		brDouble squaredErrors = 0.0;
+		brU64 numUpdates = 0;
+		for (brU32 game = 0; game < numGames; ++game)
+		{
+			brU32 const networkPlayer = game % 2;
+			Player players[2];
+			players[networkPlayer].Network = &network;
+			brS32 const winner = PlayGame(players, random, nullptr, 0.f, squaredErrors, numUpdates);
+			score += winner < 0 ? 0.5 : winner == static_cast<brS32>(networkPlayer) ? 1.0 : 0.0;
+		}
+		return score / numGames;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	char const* outputPath = nullptr;
+	char const* inputPath = nullptr;
+	brU32 numGames = 100000;
+	brFloat alpha = 0.01f;
+	brFloat epsilon = 0.1f;
+	brU32 reportInterval = 10000;
+	brU64 seed = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		brBool const hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--output") && hasValue)
+		{
+			outputPath = argv[++i];
+		}
+		else if (!std::strcmp(argv[i], "--input") && hasValue)
+		{
+			inputPath = argv[++i];
+		}
+		else if (!std::strcmp(argv[i], "--games") && hasValue)
+		{
+			numGames = static_cast<brU32>(std::max(std::atoi(argv[++i]), 0));
+		}
+		else if (!std::strcmp(argv[i], "--alpha") && hasValue)
+		{
+			alpha = static_cast<brFloat>(std::atof(argv[++i]));
+		}
+		else if (!std::strcmp(argv[i], "--epsilon") && hasValue)
+		{
+			epsilon = static_cast<brFloat>(std::atof(argv[++i]));
+		}
+		else if (!std::strcmp(argv[i], "--report") && hasValue)
+		{
+			reportInterval = static_cast<brU32>(std::max(std::atoi(argv[++i]), 1));
+		}
+		else if (!std::strcmp(argv[i], "--seed") && hasValue)
+		{
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (!outputPath)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	//the tables take ~6 MB, too much for the stack
+	std::unique_ptr<NTupleNetwork> network = std::make_unique<NTupleNetwork>();
+	if (inputPath && !network->Load(inputPath))
+	{
+		std::fprintf(stderr, "can't load the network '%s'\n", inputPath);
+		return 1;
+	}
+
+	quarto::Random random(seed);
+	quarto::Random evaluationRandom(seed + 1);
+	Player players[2];
+	players[0] = players[1] = { network.get(), epsilon };
+
+	auto const start = std::chrono::steady_clock::now();
+	brDouble squaredErrors = 0.0;
+	brU64 numUpdates = 0;
+	for (brU32 game = 1; game <= numGames; ++game)
+	{
+		PlayGame(players, random, network.get(), alpha, squaredErrors, numUpdates);
+		if (game % reportInterval == 0 || game == numGames)
+		{
+			brDouble const seconds = std::chrono::duration<brDouble>(std::chrono::steady_clock::now() - start).count();
+			std::printf("games: %u, %.0f games/s, rms td error: %.4f, score against random: %.3f\n",
+				game, game / std::max(seconds, 1e-9), std::sqrt(squaredErrors / std::max<brU64>(numUpdates, 1)), EvaluateAgainstRandom(*network, evaluationRandom, 1000));
+			std::fflush(stdout);
+			squaredErrors = 0.0;
+			numUpdates = 0;
+			if (!network->Save(outputPath))
+			{
+				std::fprintf(stderr, "can't save the network to '%s'\n", outputPath);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
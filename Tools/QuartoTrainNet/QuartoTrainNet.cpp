@@ -0,0 +1,298 @@
+// Trains the policy/value network (Eval/PolicyValueNetwork.h) on the self-play records of QuartoSelfPlay
+// QuartoTrainNet --output network.qpvn [--input network.qpvn] [--epochs n] [--learning-rate a] [--validation share] [--seed n] shards...
+// Every record is one gradient step in a random order, seen through a random symmetry of its position (Board/Symmetry.h), the records are stored in their canonical form.
+// The value learns the result of the game for the deciding player, the policy the visit shares of the search's root.
+// After every epoch the quantized network is measured on the held out records and the weights are saved.
+// Use the weights with the QuartoArena config key network, e.g. --a "seconds=0.05,network=network.qpvn"
+
+#include "QuartoCore/Board/Symmetry.h"
+#include "QuartoCore/Eval/PolicyValueNetwork.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ai::eval;
+
+namespace
+{
+	constexpr brU8 s_shardMagic[4] = { 'Q', 'S', 'P', 'D' };
+	constexpr brU8 s_shardVersion = 1;
+	constexpr size_t s_headerSize = 16;
+	constexpr size_t s_recordSize = 48;
+
+	void PrintUsage()
+	{
+		std::fprintf(stderr,
+			"usage: QuartoTrainNet --output file [--input file] [--epochs n] [--learning-rate a] [--validation share] [--seed n] shards...\n"
+			"  epochs:        passes over the training records (default 10)\n"
+			"  learning-rate: step size of the gradient descent (default 0.01)\n"
+			"  validation:    share of the records held out to measure the network (default 0.05)\n");
+	}
+
+	brU16 ReadU16(brU8 const* data)
+	{
+		return static_cast<brU16>(data[0] | (data[1] << 8));
+	}
+
+	brU64 ReadU64(brU8 const* data)
+	{
+		brU64 value = 0;
+		for (brU32 i = 0; i < 8; ++i)
+		{
+			value |= static_cast<brU64>(data[i]) << (8 * i);
+		}
+		return value;
+	}
+
+	// Appends the records of a shard, false if it isn't a shard of this format
+	brBool ReadShard(char const* path, std::vector<brU8>& records)
+	{
+		std::FILE* const file = std::fopen(path, "rb");
+		if (!file)
+		{
+			return false;
+		}
+
+		brU8 header[s_headerSize];
+		brBool isValid = std::fread(header, 1, sizeof(header), file) == sizeof(header)
+			&& std::memcmp(header, s_shardMagic, sizeof(s_shardMagic)) == 0 && header[4] == s_shardVersion && header[5] == s_recordSize;
+		if (isValid)
+		{
+			size_t const oldSize = records.size();
+			size_t const numBytes = static_cast<size_t>(ReadU64(header + 8)) * s_recordSize;
+			records.resize(oldSize + numBytes);
+			isValid = std::fread(records.data() + oldSize, 1, numBytes, file) == numBytes;
+			if (!isValid)
+			{
+				records.resize(oldSize);
+			}
+		}
+		std::fclose(file);
+		return isValid;
+	}
+
+	// One record, decoded and moved by a symmetry
+	struct Decision
+	{
+		quarto::Board Board;
+		quarto::TokenId Token = quarto::InvalidToken;
+		brFloat ValueTarget = 0.5f;
+		// Visit shares by slot with a token, by token without one
+		brFloat PolicyTarget[QUARTO_BOARD_AVAILABLE_SLOTS] = {};
+	};
+
+	Decision DecodeRecord(brU8 const* record, quarto::Symmetry const& symmetry)
+	{
+		quarto::Board board;
+		brU16 const emptySlots = ReadU16(record);
+		for (quarto::SlotIndex slot = 0; slot < QUARTO_BOARD_AVAILABLE_SLOTS; ++slot)
+		{
+			if (!((emptySlots >> slot) & 1u))
+			{
+				board.SetTokenOnBoard(slot, static_cast<quarto::TokenId>((record[2 + slot / 2] >> (4 * (slot % 2))) & 0x0F));
+			}
+		}
+
+		Decision decision;
+		decision.Board = symmetry.TransformBoard(board);
+		quarto::TokenId const token = record[10];
+		decision.Token = symmetry.TransformToken(token);
+		decision.ValueTarget = 0.5f * record[11];
+
+		brFloat totalVisits = 0.f;
+		for (brU8 i = 0; i < QUARTO_BOARD_AVAILABLE_SLOTS; ++i)
+		{
+			totalVisits += ReadU16(record + 12 + 2 * i);
+		}
+		for (brU8 i = 0; i < QUARTO_BOARD_AVAILABLE_SLOTS; ++i)
+		{
+			brU8 const target = token != quarto::InvalidToken ? symmetry.TransformSlot(i) : symmetry.TransformToken(i);
+			decision.PolicyTarget[target] = totalVisits > 0.f ? ReadU16(record + 12 + 2 * i) / totalVisits : 0.f;
+		}
+		return decision;
+	}
+
+	quarto::Symmetry MakeRandomSymmetry(quarto::Random& random)
+	{
+		quarto::Symmetry symmetry;
+		auto const& boardSymmetries = quarto::Symmetry::GetBoardSymmetries();
+		brU32 const boardSymmetry = random.NextBelow(quarto::Symmetry::NumBoardSymmetries);
+		std::copy(std::begin(boardSymmetries[boardSymmetry]), std::end(boardSymmetries[boardSymmetry]), symmetry.SlotMap);
+		for (brU8 i = quarto::Symmetry::NumAttributes - 1; i > 0; --i)
+		{
+			std::swap(symmetry.AttributeMap[i], symmetry.AttributeMap[random.NextBelow(i + 1)]);
+		}
+		symmetry.TokenMask = static_cast<quarto::TokenId>(random.NextBelow(quarto::NumTokens));
+		return symmetry;
+	}
+
+	struct ValidationStats
+	{
+		brDouble ValueError = 0.0;
+		brDouble PolicyAccuracy = 0.0;
+	};
+
+	// Quantized network, as the search sees it: root mean square error of the value and share of the most visited choice picked by the policy
+	ValidationStats Validate(PolicyValueNetwork const& network, std::vector<brU8> const& records, size_t firstRecord, size_t numRecords)
+	{
+		ValidationStats stats;
+		quarto::Symmetry const identity;
+		for (size_t i = firstRecord; i < firstRecord + numRecords; ++i)
+		{
+			Decision const decision = DecodeRecord(records.data() + i * s_recordSize, identity);
+			PolicyValue output;
+			network.Evaluate(decision.Board, decision.Token, output);
+			stats.ValueError += (output.Value - decision.ValueTarget) * (output.Value - decision.ValueTarget);
+
+			brBool const isPlacing = decision.Token != quarto::InvalidToken;
+			brU32 const legalMask = isPlacing ? decision.Board.GetEmptySlotsMask() : decision.Board.GetFreeTokensMask();
+			brFloat const* const logits = isPlacing ? output.SlotLogits : output.TokenLogits;
+			brU32 bestChoice = 0;
+			for (brU32 choice = 0; choice < QUARTO_BOARD_AVAILABLE_SLOTS; ++choice)
+			{
+				if (((legalMask >> choice) & 1u) && (!((legalMask >> bestChoice) & 1u) || logits[choice] > logits[bestChoice]))
+				{
+					bestChoice = choice;
+				}
+			}
+			brFloat const mostVisits = *std::max_element(std::begin(decision.PolicyTarget), std::end(decision.PolicyTarget));
+			stats.PolicyAccuracy += decision.PolicyTarget[bestChoice] >= mostVisits ? 1.0 : 0.0;
+		}
+		stats.ValueError = std::sqrt(stats.ValueError / std::max<size_t>(numRecords, 1));
+		stats.PolicyAccuracy /= std::max<size_t>(numRecords, 1);
+		return stats;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	char const* outputPath = nullptr;
+	char const* inputPath = nullptr;
+	brU32 numEpochs = 10;
+	brFloat learningRate = 0.01f;
+	brDouble validationShare = 0.05;
+	brU64 seed = 0;
+	std::vector<char const*> shardPaths;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		brBool const hasValue = i + 1 < argc;
+		if (!std::strcmp(argv[i], "--output") && hasValue)
+		{
+			outputPath = argv[++i];
+		}
+		else if (!std::strcmp(argv[i], "--input") && hasValue)
+		{
+			inputPath = argv[++i];
+		}
+		else if (!std::strcmp(argv[i], "--epochs") && hasValue)
+		{
+			numEpochs = static_cast<brU32>(std::max(std::atoi(argv[++i]), 1));
+		}
+		else if (!std::strcmp(argv[i], "--learning-rate") && hasValue)
+		{
+			learningRate = static_cast<brFloat>(std::atof(argv[++i]));
+		}
+		else if (!std::strcmp(argv[i], "--validation") && hasValue)
+		{
+			validationShare = std::min(std::max(std::atof(argv[++i]), 0.0), 0.5);
+		}
+		else if (!std::strcmp(argv[i], "--seed") && hasValue)
+		{
+			seed = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (argv[i][0] != '-')
+		{
+			shardPaths.push_back(argv[i]);
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (!outputPath || shardPaths.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<brU8> records;
+	for (char const* path : shardPaths)
+	{
+		if (!ReadShard(path, records))
+		{
+			std::fprintf(stderr, "can't read the shard '%s'\n", path);
+			return 1;
+		}
+	}
+	size_t const numRecords = records.size() / s_recordSize;
+	size_t const numValidationRecords = static_cast<size_t>(numRecords * validationShare);
+	size_t const numTrainingRecords = numRecords - numValidationRecords;
+	if (numTrainingRecords == 0)
+	{
+		std::fprintf(stderr, "no records to train on\n");
+		return 1;
+	}
+
+	//larger than the usual stack frame
+	std::unique_ptr<PolicyValueNetwork> network = std::make_unique<PolicyValueNetwork>();
+	quarto::Random random(seed);
+	if (inputPath)
+	{
+		if (!network->Load(inputPath))
+		{
+			std::fprintf(stderr, "can't load the network '%s'\n", inputPath);
+			return 1;
+		}
+	}
+	else
+	{
+		network->Randomize(random);
+	}
+
+	//the shards are written game by game, the held out records are the last games
+	std::printf("records: %zu training, %zu validation\n", numTrainingRecords, numValidationRecords);
+	std::vector<brU32> order(numTrainingRecords);
+	for (size_t i = 0; i < numTrainingRecords; ++i)
+	{
+		order[i] = static_cast<brU32>(i);
+	}
+
+	auto const start = std::chrono::steady_clock::now();
+	for (brU32 epoch = 1; epoch <= numEpochs; ++epoch)
+	{
+		for (size_t i = numTrainingRecords - 1; i > 0; --i)
+		{
+			std::swap(order[i], order[random.NextBelow(static_cast<brU32>(i + 1))]);
+		}
+
+		brDouble totalLoss = 0.0;
+		for (brU32 record : order)
+		{
+			Decision const decision = DecodeRecord(records.data() + record * s_recordSize, MakeRandomSymmetry(random));
+			totalLoss += network->Train(decision.Board, decision.Token, decision.ValueTarget, decision.PolicyTarget, learningRate);
+		}
+		network->Quantize();
+
+		ValidationStats const validation = Validate(*network, records, numTrainingRecords, numValidationRecords);
+		brDouble const seconds = std::chrono::duration<brDouble>(std::chrono::steady_clock::now() - start).count();
+		std::printf("epoch: %u, %.0f records/s, training loss: %.4f, validation value rms error: %.4f, validation policy accuracy: %.3f\n",
+			epoch, epoch * numTrainingRecords / std::max(seconds, 1e-9), totalLoss / numTrainingRecords, validation.ValueError, validation.PolicyAccuracy);
+		std::fflush(stdout);
+		if (!network->Save(outputPath))
+		{
+			std::fprintf(stderr, "can't save the network to '%s'\n", outputPath);
+			return 1;
+		}
+	}
+	return 0;
+}